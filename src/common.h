@@ -7,7 +7,6 @@
 #ifndef _COMMON_H_
 #define _COMMON_H_
 
-#include <wx/platform.h>
 //#include "version.h"
 
 
@@ -19,7 +18,7 @@
 #define _MAX_PATH	260
 #endif
 
-#if defined(__WXMSW__)
+#if defined(_WIN32)
 
 #include <stdint.h>
 
@@ -34,12 +33,12 @@
 #include "tchar.h"
 #include "typedef.h"
 
-#if defined(__WXOSX__)
+#if defined(__APPLE__)
 
 wchar_t *_wgetenv(const wchar_t *);
 int _wsystem(const wchar_t *);
 
-#elif defined(__WXGTK__)
+#else
 
 wchar_t *_wgetenv(const wchar_t *);
 int _wsystem(const wchar_t *);
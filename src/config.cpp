@@ -19,11 +19,15 @@ Config::Config()
 	sample_bits = 0;
 	baud = 0;
 	auto_baud = true;
+	demod_type = 0;
+	decimate_rate = 0;
 	correct_type = 0;
 	correct_amp[0] = 1000;
 	correct_amp[1] = 1000;
+	correct_calc = 0;
 	chg_gap_size = false;
 	out_err_ser = false;
+	decode_threads = 0;
 }
 
 Config::~Config()
@@ -55,6 +59,12 @@ void Config::Load()
 	if (lv < 0 || 3 < lv) lv = baud;
 	baud = lv;
 	ini->Read(_T("AutoBaud"), &auto_baud);
+	if (!ini->Read(_T("DemodType"), &lv)) lv = demod_type;
+	if (lv < 0 || 1 < lv) lv = demod_type;
+	demod_type = lv;
+	if (!ini->Read(_T("DecimateRate"), &lv)) lv = decimate_rate;
+	if (lv < 0 || 4 < lv) lv = decimate_rate;
+	decimate_rate = lv;
 	if (!ini->Read(_T("CorrectType"), &lv)) lv = correct_type;
 	if (lv < 0 || 2 < lv) lv = correct_type;
 	correct_type = lv;
@@ -64,8 +74,14 @@ void Config::Load()
 	if (!ini->Read(_T("CorrectAmp1"), &lv)) lv = correct_amp[1];
 	if (lv < 100 || 5000 < lv) lv = correct_amp[1];
 	correct_amp[1] = lv;
+	if (!ini->Read(_T("CorrectCalc"), &lv)) lv = correct_calc;
+	if (lv < 0 || 1 < lv) lv = correct_calc;
+	correct_calc = lv;
 	ini->Read(_T("ChangeGapSize"), &chg_gap_size);
 	ini->Read(_T("OutputErrorSerial"), &out_err_ser);
+	if (!ini->Read(_T("DecodeThreads"), &lv)) lv = decode_threads;
+	if (lv < 0 || 256 < lv) lv = decode_threads;
+	decode_threads = lv;
 	for(int i=0; i<MAX_RECENT_FILES; i++) {
 		wxString sval;
 		ini->Read(wxString::Format(_T("Recent%d"), i), &sval);
@@ -95,11 +111,15 @@ void Config::Save()
 	ini->Write(_T("SampleBits"), sample_bits);
 	ini->Write(_T("Baud"), baud);
 	ini->Write(_T("AutoBaud"), auto_baud);
+	ini->Write(_T("DemodType"), demod_type);
+	ini->Write(_T("DecimateRate"), decimate_rate);
 	ini->Write(_T("CorrectType"), correct_type);
 	ini->Write(_T("CorrectAmp0"), correct_amp[0]);
 	ini->Write(_T("CorrectAmp1"), correct_amp[1]);
+	ini->Write(_T("CorrectCalc"), correct_calc);
 	ini->Write(_T("ChangeGapSize"), chg_gap_size);
 	ini->Write(_T("OutputErrorSerial"), out_err_ser);
+	ini->Write(_T("DecodeThreads"), decode_threads);
 	for(int i=0,row=0; row<MAX_RECENT_FILES && i<(int)mRecentFiles.Count(); i++) {
 		wxString sval = mRecentFiles.Item(i);
 		if (sval.IsEmpty()) continue;
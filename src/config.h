@@ -24,10 +24,14 @@ private:
 	int      sample_bits;
 	int      baud;
 	bool     auto_baud;
+	int      demod_type;
+	int      decimate_rate;
 	int      correct_type;
 	int      correct_amp[2];
+	int      correct_calc;
 	bool     chg_gap_size;
 	bool     out_err_ser;
+	int      decode_threads;
 	wxArrayString mRecentFiles;
 
 public:
@@ -46,14 +50,22 @@ public:
 	void SetBaud(int val) { baud = val; }
 	bool GetAutoBaud() const { return auto_baud; }
 	void SetAutoBaud(bool val) { auto_baud = val; }
+	int GetDemodType() const { return demod_type; }
+	void SetDemodType(int val) { demod_type = val; }
+	int GetDecimateRatePos() const { return decimate_rate; }
+	void SetDecimateRatePos(int val) { decimate_rate = val; }
 	int GetCorrectType() const { return correct_type; }
 	int GetCorrectAmp(int idx) const { return correct_amp[idx]; }
 	void SetCorrectType(int val) { correct_type = val; }
 	void SetCorrectAmp(int idx, int val) { correct_amp[idx] = val; }
+	int GetCorrectCalc() const { return correct_calc; }
+	void SetCorrectCalc(int val) { correct_calc = val; }
 	bool GetChangeGapSize() const { return chg_gap_size; }
 	void SetChangeGapSize(bool val) { chg_gap_size = val; }
 	bool GetOutErrSerial() const { return out_err_ser; }
 	void SetOutErrSerial(bool val) { out_err_ser = val; }
+	int GetDecodeThreads() const { return decode_threads; }
+	void SetDecodeThreads(int val) { decode_threads = val; }
 	void AddRecentFile(const wxString &val);
 	wxString &GetRecentFile();
 	void GetRecentFiles(wxArrayString &vals);
@@ -75,6 +75,19 @@ ConfigBox::ConfigBox(wxWindow* parent, wxWindowID id)
 	bszr->Add(chkHalfwave, flags);
 	szrWav2L3c->Add(bszr, flags);
 	bszr = new wxBoxSizer(wxHORIZONTAL);
+	chkCorrelate = new wxCheckBox(this, IDC_CHK_CORRELATE, _("Demodulate by Correlation"));
+	bszr->Add(chkCorrelate, flags);
+	szrWav2L3c->Add(bszr, flags);
+	bszr = new wxBoxSizer(wxHORIZONTAL);
+	wxString drate_list[] = {
+		_("Auto"), _T("11025"), _T("22050"), _T("44100"), _T("48000")
+	};
+	bszr->Add(new wxStaticText(this, wxID_ANY, _("Decimate High Rate Input to")), flags);
+	comDRate = new wxComboBox(this, IDC_COMBO_DRATE, _T(""), wxDefaultPosition, wxDefaultSize, 5, drate_list, wxCB_DROPDOWN | wxCB_READONLY);
+	bszr->Add(comDRate, flags);
+	bszr->Add(new wxStaticText(this, wxID_ANY, _("Hz")), flags);
+	szrWav2L3c->Add(bszr, flags);
+	bszr = new wxBoxSizer(wxHORIZONTAL);
 //	chkCorrect = new wxCheckBox(this, IDC_CHK_CORRECT, _("Correct"));
 	bszr->Add(new wxStaticText(this, wxID_ANY, _("Correct")), flags);
 	radNoCorrect = new wxRadioButton(this, IDC_RADIO_NOCORRECT, _("No"),wxDefaultPosition,wxDefaultSize,wxRB_GROUP);
@@ -226,6 +239,8 @@ void ConfigBox::init_dialog()
 
 		chkReverse->SetValue(param.GetReverseWave());
 		chkHalfwave->SetValue(param.GetHalfWave());
+		chkCorrelate->SetValue(param.GetDemodType() == 1);
+		comDRate->Select(param.GetDecimateRatePos());
 
 		radNoCorrect->SetValue(param.GetCorrectType() == 0);
 		radCorrCosw->SetValue(param.GetCorrectType() == 1);
@@ -417,6 +432,8 @@ void ConfigBox::term_dialog()
 
 	param.SetReverseWave(chkReverse->GetValue());
 	param.SetHalfWave(chkHalfwave->GetValue());
+	param.SetDemodType(chkCorrelate->GetValue() ? 1 : 0);
+	param.SetDecimateRatePos(comDRate->GetCurrentSelection());
 
 	if (radCorrCosw->GetValue()) param.SetCorrectType(1);
 	else if (radCorrSinw->GetValue()) param.SetCorrectType(2);
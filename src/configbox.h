@@ -27,6 +27,8 @@ private:
 
 	wxCheckBox *chkReverse;
 	wxCheckBox *chkHalfwave;
+	wxCheckBox *chkCorrelate;
+	wxComboBox *comDRate;
 
 	wxRadioButton *radNoCorrect;
 	wxRadioButton *radCorrCosw;
@@ -81,6 +83,8 @@ public:
 		IDC_SPIN_RANGE4800,
 		IDC_CHK_REVERSE,
 		IDC_CHK_HALFWAVE,
+		IDC_CHK_CORRELATE,
+		IDC_COMBO_DRATE,
 		IDC_RADIO_NOCORRECT,
 		IDC_RADIO_COSW,
 		IDC_RADIO_SINW,
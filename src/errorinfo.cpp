@@ -5,107 +5,115 @@
 /// @author Copyright (c) Sasaji. All rights reserved.
 ///
 #include "errorinfo.h"
+#include "paw_frontend.h"
+#include <stdio.h>
 
 PwErrInfo::PwErrInfo()
 {
 	mType = pwOK;
 	mCode = pwErrNone;
-	mMsg = _T("");
+	mCode2 = pwErrNone;
 	mLine = 0;
+	mFrontend = NULL;
 }
 
 PwErrInfo::~PwErrInfo()
 {
 }
 
-// エラーメッセージ
-wxString PwErrInfo::ErrMsg(PwErrCode code)
+// エラーメッセージの書式
+const char *PwErrInfo::ErrFormat(PwErrCode code)
 {
-	wxString str;
+	const char *str;
 	switch(code) {
 		case pwErrNone:
 			// no error
-			str = _T("");
+			str = "";
 			break;
 		case pwErrFileNotFound:
 			// ファイルがみつかりません。
-			str = _("File not found.");
+			str = _TX("File not found.");
 			break;
 		case pwErrNotPCMFormat:
 			// PCMフォーマットのwavファイルではありません。
-			str = _("This is not PCM format in the wav file.");
+			str = _TX("This is not PCM format in the wav file.");
 			break;
 		case pwErrSampleRate:
-			// サンプルレートは11025～48000Hzをサポートします。
-			str = _("Sample rate is supported between 11025 and 48000Hz.");
+			// サンプルレートは11025～48000Hzと、48000Hz以下に間引ける384000Hzまでをサポートします。
+			str = _TX("Sample rate is supported between 11025 and 48000Hz, and up to 384000Hz if it can be decimated to 48000Hz or less.");
 			break;
 		case pwErrCannotWrite:
 			// ファイルを出力できません。
-			str = _("Cannot write file.");
+			str = _TX("Cannot write file.");
 			break;
 		case pwErrCannotWriteDebugLog:
 			// デバッグログを出力できませんが、処理を続けます。
-			str = _("Cannot write debug log. Continue this process.");
+			str = _TX("Cannot write debug log. Continue this process.");
 			break;
 		case pwErrFileEmpty:
 			// ファイルが空です。
-			str = _("File is empty.");
+			str = _TX("File is empty.");
 			break;
 		case pwErrSameFile:
 			// 同じファイルを指定することはできません。
-			str = _("Cannot specify the same file.");
+			str = _TX("Cannot specify the same file.");
 			break;
 		case pwErrNotT9XFormat:
 			// t9xフォーマットのファイルではありません。
-			str = _("This file is not t9x format.");
+			str = _TX("This file is not t9x format.");
 			break;
 		case pwErrNoBASICIntermediateLanguage:
 			// BASIC中間言語形式のファイルではありませんが、処理を続けます。
-			str = _("This is not BASIC intermediate language file. Continue this process.");
+			str = _TX("This is not BASIC intermediate language file. Continue this process.");
 			break;
 		default:
 			// 不明なエラー: %d
-			str.Printf(_("Unknown error: %d"), code);
+			str = _TX("Unknown error: %d");
 			break;
 	}
 	return str;
 }
 
+// エラーメッセージ
+std::string PwErrInfo::ErrMsg(PwErrCode code)
+{
+	char str[256];
+	snprintf(str, sizeof(str), ErrFormat(code), (int)code);
+	return std::string(str);
+}
+
 // エラー情報セット
-void PwErrInfo::SetInfo(int line, PwErrType type, PwErrCode code, const wxString &msg)
+void PwErrInfo::SetInfo(int line, PwErrType type, PwErrCode code, const std::string &msg)
 {
 		mType = type;
 		mCode = code;
+		mCode2 = pwErrNone;
+		mDetail = msg;
 		mMsg = ErrMsg(code);
-		if (!msg.IsEmpty()) {
-			mMsg += _T(" (") + msg + _T(")");
+		if (!msg.empty()) {
+			mMsg += " (" + msg + ")";
 		}
 		mLine = line;
 }
 
-void PwErrInfo::SetInfo(int line, PwErrType type, PwErrCode code1, PwErrCode code2, const wxString &msg)
+void PwErrInfo::SetInfo(int line, PwErrType type, PwErrCode code1, PwErrCode code2, const std::string &msg)
 {
 		mType = type;
 		mCode = code1;
+		mCode2 = code2;
+		mDetail = msg;
 		mMsg = ErrMsg(code1);
-		if (!msg.IsEmpty()) {
-			mMsg += _T(" (") + msg + _T(")");
+		if (!msg.empty()) {
+			mMsg += " (" + msg + ")";
 		}
-		mMsg += _T("\n") + ErrMsg(code2);
+		mMsg += "\n" + ErrMsg(code2);
 		mLine = line;
 }
 
-// gui メッセージBOX
-void PwErrInfo::ShowMsgBox(wxWindow *win)
+// メッセージ表示
+void PwErrInfo::ShowMsgBox()
 {
-	switch(mType) {
-		case pwError:
-			wxMessageBox(mMsg, _("Error"), wxOK | wxICON_ERROR, win);
-			break;
-		case pwWarning:
-			wxMessageBox(mMsg, _("Warning"), wxOK | wxICON_WARNING, win);
-			break;
-		default:
-			break;
+	if (mFrontend && (mType == pwError || mType == pwWarning)) {
+		mFrontend->ShowMessage(*this);
 	}
 }
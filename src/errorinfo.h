@@ -8,8 +8,17 @@
 #define _ERRORINFO_H_
 
 #include "common.h"
-#include <wx/wx.h>
+#include <string>
 
+/// 翻訳対象の文字列 (翻訳はフロントエンドで行う)
+#ifndef _TX
+#define _TX(x) x
+#endif
+
+namespace PARSEWAV
+{
+class Frontend;
+};
 
 /// エラータイプ
 typedef enum enumPwErrType {
@@ -35,28 +44,43 @@ typedef enum enumPwErrCode {
 } PwErrCode;
 
 /// エラー情報保存用
+///
+/// メッセージの表示はフロントエンドに任せる
 class PwErrInfo
 {
 private:
 	PwErrType mType;
 	PwErrCode mCode;
-	wxString  mMsg;
+	PwErrCode mCode2;	///< 続けて表示するエラーコード
+	std::string mDetail;	///< 補足情報
+	std::string mMsg;
 	int       mLine;
+	PARSEWAV::Frontend *mFrontend;
 
 public:
 	PwErrInfo();
 	~PwErrInfo();
 
+	/// エラーメッセージの書式
+	static const char *ErrFormat(PwErrCode code);
 	/// エラーメッセージ
-	wxString ErrMsg(PwErrCode code);
+	static std::string ErrMsg(PwErrCode code);
 	/// エラー情報セット
-	void SetInfo(int line, PwErrType type, PwErrCode code, const wxString &msg = wxEmptyString);
+	void SetInfo(int line, PwErrType type, PwErrCode code, const std::string &msg = std::string());
 	/// エラー情報セット
-	void SetInfo(int line, PwErrType type, PwErrCode code1, PwErrCode code2, const wxString &msg = wxEmptyString);
+	void SetInfo(int line, PwErrType type, PwErrCode code1, PwErrCode code2, const std::string &msg = std::string());
 
-	/// gui メッセージBOX
-	void ShowMsgBox(wxWindow *win = 0);
+	/// フロントエンドにメッセージを表示させる
+	void ShowMsgBox();
+	/// 表示先のフロントエンドを設定
+	void SetFrontend(PARSEWAV::Frontend *val) { mFrontend = val; }
 
+	PwErrType GetType() const { return mType; }
+	PwErrCode GetCode() const { return mCode; }
+	PwErrCode GetCode2() const { return mCode2; }
+	const std::string &GetDetail() const { return mDetail; }
+	const std::string &GetMsg() const { return mMsg; }
+	int GetLine() const { return mLine; }
 };
 
 #endif /* _ERRORINFO_H_ */
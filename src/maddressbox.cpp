@@ -8,23 +8,6 @@
 
 //////////////////////////////////////////////////////////////////////
 
-MAddressParam::MAddressParam()
-{
-	Initialize();
-}
-
-void MAddressParam::Initialize()
-{
-	p.start_addr = 0;
-	p.exec_addr  = 0;
-	p.data_size  = 0;
-	p.file_size  = 0;
-	p.valid      = false;
-	submitted    = false;
-}
-
-//////////////////////////////////////////////////////////////////////
-
 BEGIN_EVENT_TABLE(MAddressBox, wxDialog)
 	EVT_CHECKBOX(IDC_INC_HEADER, MAddressBox::OnCheckIncHeader)
 	EVT_BUTTON(wxID_OK, MAddressBox::OnClickOk)
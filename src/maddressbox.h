@@ -10,36 +10,9 @@
 #include "common.h"
 #include <wx/wx.h>
 #include <wx/dialog.h>
-#include "paw_defs.h"
+#include "paw_param.h"
 
-/// マシン語開始アドレス設定パラメータ
-class MAddressParam
-{
-private:
-	PARSEWAV::maddress_t p;
-	bool  submitted;
-
-public:
-	MAddressParam();
-	~MAddressParam() {}
-
-	void Initialize();
-
-	long GetStartAddr() const { return p.start_addr; }
-	void SetStartAddr(long val) { p.start_addr = val; }
-	long GetExecAddr() const { return p.exec_addr; }
-	void SetExecAddr(long val) { p.exec_addr = val; }
-	long GetDataSize() const { return p.data_size; }
-	void SetDataSize(long val) { p.data_size = val; }
-	long GetFileSize() const { return p.file_size; }
-	void SetFileSize(long val) { p.file_size = val; }
-	bool IncludeHeader() const { return p.include_header; }
-	void IncludeHeader(bool val) { p.include_header = val; }
-	bool Valid() const { return p.valid; }
-	void Valid(bool val) { p.valid = val; }
-	bool Submitted() const { return submitted; }
-	void Submitted(bool val) { submitted = val; }
-};
+using PARSEWAV::MAddressParam;
 
 /// マシン語開始アドレス設定ダイアログ
 class MAddressBox : public wxDialog
@@ -5,28 +5,43 @@
 /// @author Copyright (c) Sasaji. All rights reserved.
 ///
 #include "parsewav.h"
-#include <wx/filename.h>
 #include "utils.h"
 #include "version.h"
+#ifdef PARSEWAV_USE_THREAD
+#include <thread>
+#include <chrono>
+#endif
 
 
 namespace PARSEWAV
 {
 
-/// 処理中ダイアログを表示するか
-#define USE_PROGRESSBOX 1
-
 /// 解析時の読み込む秒数
 #define ANALYZE_SEC	30
 
+/// 解析の試行数(FSK速度 x 補正波形)
+#define ANALYZE_TRIALS	4
+
+/// 長いテープを分割してデコードする時の区間の最短の秒数
+#define SEGMENT_MIN_SEC	30
+
 /// ギャップの長さ
 static const int c_gap_length[4] = { 0x5a, 0xc0, 0x19b, 0x36f };
 
 /// @brief コンストラクタ
 ///
-ParseWav::ParseWav(wxWindow *parent)
+/// @param[in] frontend_ 進捗表示や問い合わせ先 NULLなら何も表示しない
+/// @param[in] owner_    並列で解析するために作る場合は親
+///
+ParseWav::ParseWav(Frontend *frontend_, ParseWav *owner_)
 {
-	parent_window = parent;
+	frontend = (frontend_ ? frontend_ : &default_frontend);
+	owner = owner_;
+	trial_top = 0;
+
+	trial_pos = 0;
+	trial_finished = 0;
+	trial_cancel = false;
 
 	//
 	wave_data = new WaveData();
@@ -46,8 +61,13 @@ ParseWav::ParseWav(wxWindow *parent)
 	serial_parser.SetInputFile(infile);
 	binary_parser.SetInputFile(infile);
 
+	wave_parser.SetLogFile(logfile);
+	carrier_parser.SetLogFile(logfile);
+	serial_parser.SetLogFile(logfile);
+	binary_parser.SetLogFile(logfile);
+
 	logbuf = NULL;
-	logfilename = _T("wavtool.log");
+	logfilename = "wavtool.log";
 
 	include_header = true;
 
@@ -55,12 +75,10 @@ ParseWav::ParseWav(wxWindow *parent)
 
 	process_mode = PROCESS_IDLE;
 
-#ifdef USE_PROGRESSBOX
-	progbox = new ProgressBox(parent_window);
-#endif
 //	rftypebox = new RfTypeBox(parent_window, wxID_ANY);
 //	maddressbox = new MAddressBox(parent_window, wxID_ANY);
 	errinfo = new PwErrInfo();
+	errinfo->SetFrontend(frontend);
 
 	viewing_dir = 0;
 
@@ -78,9 +96,6 @@ ParseWav::~ParseWav()
 	delete errinfo;
 //	delete maddressbox;
 //	delete rftypebox;
-#ifdef USE_PROGRESSBOX
-	delete progbox;
-#endif
 
 	delete binary_data;
 	delete serial_new_data;
@@ -173,6 +188,7 @@ int ParseWav::InitFileHeader(OutputFile &file)
 		outwav.Init(param.GetSampleRate(), (param.GetSampleBitsPos() == 0 ? 8 : 16), 1);
 
 		conv.InitConvSampleData();
+		wave_parser.InitEncodeToWave(outwav.GetSampleRate(), outwav.GetBlockSize());
 
 		len_all = outwav.Out(file);
 
@@ -200,6 +216,9 @@ void ParseWav::SetFileHeader(OutputFile &file)
 	if (file.GetType() == FILETYPE_WAV) {
 		// WAVファイル以外からの変換の場合、データ末尾に2400/4800Hzを0.5sec出力
 		out_dummy_tail_data(file);
+		// 合成やレート変換で残っているデータを出力
+		wave_parser.FlushEncodeToWave(file);
+		conv.FlushConvSampleData(1, outwav.GetBlockSize(), file);
 		// ファイルサイズ、データサイズを書き込む
 		WaveFormat::OutSize(file);
 
@@ -214,6 +233,8 @@ void ParseWav::SetFileHeader(OutputFile &file)
 		file.Fwrite((void *)&head, sizeof(head), 1);
 
 	}
+	// バッファにたまっているデータを出力
+	file.Flush();
 
 	return;
 }
@@ -224,7 +245,6 @@ void ParseWav::out_dummy_tail_data(OutputFile &file)
 	if (infile.GetType() != FILETYPE_WAV) {
 		int spd = param.GetFskSpeed();
 		int samples = 48000 / 2400 / (spd + 1);
-		uint8_t w_data[200];
 		for(int j=0; j<120; j++) {
 			uint8_t c = carrier_data->GetRead(-1).Data();	// 最後のデータ
 			carrier_data->Shift();
@@ -232,12 +252,8 @@ void ParseWav::out_dummy_tail_data(OutputFile &file)
 				c = ((1 - (c & 1)) | 0x30);
 				carrier_data->Add(c, 0);
 			}
-			int pos = 0;
-			while(!carrier_data->IsTail()) {
-				pos += wave_parser.EncodeToWave(carrier_data, &w_data[pos], sizeof(w_data) - pos);
-			}
-			// convert
-			conv.OutConvSampleData(w_data, 48000, 1, pos, outwav.GetSampleRate(), outwav.GetBlockSize(), file);
+			// 出力レートで直接合成
+			wave_parser.EncodeToWave(carrier_data, 0, samples, file);
 		}
 	}
 }
@@ -248,16 +264,12 @@ void ParseWav::out_dummy_tail_data(OutputFile &file)
 /// @return pwOK:OK pwCancel:キャンセル終了
 PwErrType ParseWav::check_rf_format(InputFile &file)
 {
-	int rc;
-	_TCHAR bname[_MAX_PATH];
+	std::string bname;
 
-	UTILS::base_name(file.GetName(), bname, _MAX_PATH);
+	UTILS::base_name(file.GetName(), bname);
 
 	// ファイルの種類を選択
-	rftypeparam.Initialize();
-	RfTypeBox rftypebox(parent_window, rftypeparam);
-	rc = rftypebox.showRftypeBox(bname, true);
-	if (rc != 1) {
+	if (!frontend->SelectRfType(rftypeparam, bname, true)) {
 		// cancel button
 		return pwCancel;
 	}
@@ -412,10 +424,15 @@ int ParseWav::decode_phase1(int fsk_spd, WaveData *w_data, WaveData *wc_data, Ca
 	bool reverse_wave = tmp_param.GetReverseWave();
 	WaveData *wn_data;
 
+	if (tmp_param.GetDemodType() == 1) {
+		// 相関で復調する場合は補正しない
+		correct_type = 0;
+	}
+
 	if (infile.GetType() == FILETYPE_WAV && (correct_type > 0 || process_mode == PROCESS_ANALYZING)) {
 		// 補正あり
 		wn_data = wc_data;
-		dft.Init(wave_parser.GetLamda().samples[fsk_spd], correct_type, param.GetCorrectAmp(0), param.GetCorrectAmp(1));
+		dft.Init(wave_parser.GetLamda().samples[fsk_spd], correct_type, param.GetCorrectAmp(0), param.GetCorrectAmp(1), param.GetCorrectCalc());
 	} else {
 		// 補正なし
 		wn_data = w_data;
@@ -450,7 +467,7 @@ int ParseWav::decode_phase1(int fsk_spd, WaveData *w_data, WaveData *wc_data, Ca
 				}
 				if (outfile.GetType() == FILETYPE_WAV && outfile.GetType() >= infile.GetType()) {
 					// WAV ファイル出力
-					conv.OutConvSampleData(*wn_data, inwav.GetSampleRate(), outwav.GetSampleRate(), outwav.GetBlockSize(), outfile);
+					conv.OutConvSampleData(*wn_data, wave_parser.GetSampleRate(), outwav.GetSampleRate(), outwav.GetBlockSize(), outfile);
 				}
 				// データ最後まで読んだ場合
 				if (correct_type > 0 || process_mode == PROCESS_ANALYZING) {
@@ -1049,6 +1066,8 @@ int ParseWav::encode_phase3(BinaryData *b_data, SerialData *s_data, CarrierData
 //	int step = 0;
 	bool last = false;
 	uint8_t bin_data = 0;
+	// バイナリから搬送波へ直接変換するか
+	bool to_carrier = (outfile.GetType() < FILETYPE_L3B && (start_phase == PHASE3_GET_BIN_SAMPLE || start_phase == PHASE3_GET_L3_SAMPLE));
 
 //	pos = strlen(serial_data);
 
@@ -1086,6 +1105,18 @@ int ParseWav::encode_phase3(BinaryData *b_data, SerialData *s_data, CarrierData
 				phase3 = PHASE3_ENCODE_TO_SERIAL;
 				break;
 			case PHASE3_ENCODE_TO_SERIAL:
+				if (to_carrier) {
+					// 搬送波データに直接変換
+					carrier_parser.EncodeToCarrier(bin_data, c_data);
+					phase3 = start_phase;
+					if (c_data->IsFull(SERIAL_BYTE_BITS_MAX * 16)) {
+						phase3 = PHASE3_PUT_L3C_SAMPLE;
+					}
+					if (b_data->IsLastData()) {
+						phase3 = PHASE3_PUT_L3C_SAMPLE;
+					}
+					break;
+				}
 				// シリアルデータに変換
 				serial_parser.EncodeToSerial(bin_data, s_data);
 				phase3 = start_phase;
@@ -1127,6 +1158,27 @@ int ParseWav::encode_phase3(BinaryData *b_data, SerialData *s_data, CarrierData
 					encode_phase2(s_data, c_data, PHASE2_ENCODE_TO_CARRIER, last);
 				}
 
+				if (last) {
+					phase3 = PHASE_NONE;
+					break;
+				}
+				phase3 = start_phase;
+				break;
+			case PHASE3_PUT_L3C_SAMPLE:
+				// 次のフェーズへ (encode_phase2 の PHASE2_ENCODE_TO_WAVE と同じ)
+				if (phase2 > PHASE_NONE) {
+					if (outfile.GetType() == FILETYPE_L3C) {
+						carrier_parser.WriteL3CData(outfile, c_data);
+						c_data->Clear();
+					}
+					if (outfile.GetType() < FILETYPE_L3C) {
+						encode_phase1(c_data, last);
+					}
+					if (last) {
+						phase2 = PHASE_NONE;
+					}
+				}
+
 				if (last) {
 					phase3 = PHASE_NONE;
 					break;
@@ -1242,7 +1294,6 @@ int ParseWav::encode_phase2(SerialData *s_data, CarrierData *c_data, enum_phase
 int ParseWav::encode_phase1(CarrierData *c_data, bool end_data)
 {
 //	int pos = 0;
-	int step = 0;
 	bool last = false;
 	bool break_data = false;
 	uint8_t wav_data[20];
@@ -1269,18 +1320,17 @@ int ParseWav::encode_phase1(CarrierData *c_data, bool end_data)
 			break;
 		}
 
-		step = wave_parser.EncodeToWave(c_data, wav_data, 20);
-//		pos += step;
+		if (outfile.GetType() == FILETYPE_WAV) {
+			// 出力レートで直接合成
+			wave_parser.EncodeToWave(c_data, end_data ? 0 : 32, 256, outfile);
+		} else {
+			wave_parser.EncodeToWave(c_data, wav_data, 20);
+		}
 
 		if (c_data->IsTail()) {
 			last = true;
 		}
 
-		if (outfile.GetType() == FILETYPE_WAV) {
-			conv.OutConvSampleData(wav_data, 48000, 1, step, outwav.GetSampleRate(), outwav.GetBlockSize(), outfile);
-//			pos = 0;
-		}
-
 		if (last) {
 			phase1 = PHASE_NONE;
 			break;
@@ -1305,29 +1355,32 @@ void ParseWav::reporting()
 //	size_t len;
 //	int spd = param.GetFskSpeed();
 
-	buff = _T("----- Result Report -----");
+	buff = "----- Result Report -----";
 	write_log(buff, 1);
 
 	// input
-	buff = _T(" [ input ]");
+	buff = " [ input ]";
 	write_log(buff, 1);
-	buff = _T(" ") + infile.GetName();
+	buff = " " + infile.GetName();
 	write_log(buff, 1);
 	if (infile.GetType() == FILETYPE_WAV) {
-		buff.Printf(_T(" %dHz %dbit %dch"),inwav.GetSampleRate(), inwav.GetSampleBits(), inwav.GetChannels());
+		UTILS::str_printf(buff, " %dHz %dbit %dch",inwav.GetSampleRate(), inwav.GetSampleBits(), inwav.GetChannels());
+		if (wave_parser.GetDecimation() > 1) {
+			buff += UTILS::str_format(" (decimated to %dHz)", wave_parser.GetSampleRate());
+		}
 		write_log(buff, 1);
 	}
 
-	write_log(_T(""), 1);
+	write_log("", 1);
 
 	// output
 	if (outfile.GetType() != FILETYPE_NO_FILE) {
-		buff = _T(" [ output ]");
+		buff = " [ output ]";
 		write_log(buff, 1);
-		buff = _T(" ") + outfile.GetName();
+		buff = " " + outfile.GetName();
 		write_log(buff, 1);
 
-		write_log(_T(""), 1);
+		write_log("", 1);
 	}
 	// phase1 report
 	if (infile.GetType() == FILETYPE_WAV && outfile.GetType() >= FILETYPE_WAV) {
@@ -1346,22 +1399,22 @@ void ParseWav::reporting()
 
 	// phase4 report
 	if (infile.GetType() <= FILETYPE_L3 && outfile.GetType() >= FILETYPE_WAV) {
-		binary_parser.DecordingReport(binary_data, buff, logbuf);
+		binary_parser.DecordingReport(buff, logbuf);
 	}
 
 	// phase3 report
 	if (infile.GetType() >= FILETYPE_L3 && outfile.GetType() <= FILETYPE_T9X) {
-		serial_parser.EncordingReport(serial_data, buff, logbuf);
+		serial_parser.EncordingReport(buff);
 	}
 
 	// phase2 report
 	if (infile.GetType() >= FILETYPE_L3B && outfile.GetType() <= FILETYPE_L3C) {
-		carrier_parser.EncordingReport(carrier_data, buff, logbuf);
+		carrier_parser.EncordingReport(buff);
 	}
 
 	// phase1 report
 	if (infile.GetType() >= FILETYPE_L3C && outfile.GetType() <= FILETYPE_WAV) {
-		wave_parser.EncordingReport(outwav, buff, logbuf);
+		wave_parser.EncordingReport(outwav, buff);
 	}
 }
 
@@ -1373,53 +1426,56 @@ void ParseWav::reporting()
 ///
 void ParseWav::reporting_analyze()
 {
-	buff = _T("----- Result Report -----");
+	buff = "----- Result Report -----";
 	write_log(buff, 1);
 
 	// input
-	buff = _T(" [ input ]");
+	buff = " [ input ]";
 	write_log(buff, 1);
-	buff = _T(" ") + infile.GetName();
+	buff = " " + infile.GetName();
 	write_log(buff, 1);
 	if (infile.GetType() == FILETYPE_WAV) {
-		buff.Printf(_T(" %dHz %dbit %dch"), inwav.GetSampleRate(), inwav.GetSampleBits(), inwav.GetChannels());
+		UTILS::str_printf(buff, " %dHz %dbit %dch", inwav.GetSampleRate(), inwav.GetSampleBits(), inwav.GetChannels());
+		if (wave_parser.GetDecimation() > 1) {
+			buff += UTILS::str_format(" (decimated to %dHz)", wave_parser.GetSampleRate());
+		}
 		write_log(buff, 1);
 	}
 
 	for(int spd=0; spd<2; spd++) {
-		write_log(_T(""), 1);
-		buff = _T("  Wave Type: ");
-		buff += spd ? _T("Double Speed FSK") : _T("Standard FSK");
+		write_log("", 1);
+		buff = "  Wave Type: ";
+		buff += spd ? "Double Speed FSK" : "Standard FSK";
 		write_log(buff, 1);
 		for(int cor=0; cor<2; cor++) {
 			switch(cor) {
 				case 0:
-					buff = _T("    Cos Wave:");
+					buff = "    Cos Wave:";
 					break;
 				case 1:
-					buff = _T("    Sin Wave:");
+					buff = "    Sin Wave:";
 					break;
 			}
 			write_log(buff, 1);
-			buff.Printf(_T("      Long(0)  : %8d Cent:%6.1fHz Avg:%6.1fHz")
+			UTILS::str_printf(buff, "      Long(0)  : %8d Cent:%6.1fHz Avg:%6.1fHz"
 				, st_chkwav[spd].sample_num[cor][0]
 				, 1000000.0 / wave_parser.GetLamda().us[spd]
 				, 1000000.0 / st_chkwav[spd].us0avg[cor]
 			);
 			write_log(buff, 1);
-			buff.Printf(_T("      Short(1) : %8d Cent:%6.1fHz Avg:%6.1fHz")
+			UTILS::str_printf(buff, "      Short(1) : %8d Cent:%6.1fHz Avg:%6.1fHz"
 				, st_chkwav[spd].sample_num[cor][1]
 				, 1000000.0 / wave_parser.GetLamda().us[spd+1]
 				, 1000000.0 / st_chkwav[spd].us1avg[cor]
 			);
 			write_log(buff, 1);
-			buff.Printf(_T("      Middle   : %8d"),st_chkwav[spd].sample_num[cor][2]);
+			UTILS::str_printf(buff, "      Middle   : %8d",st_chkwav[spd].sample_num[cor][2]);
 			write_log(buff, 1);
-			buff.Printf(_T("      Too Long : %8d"),st_chkwav[spd].sample_num[cor][3]);
+			UTILS::str_printf(buff, "      Too Long : %8d",st_chkwav[spd].sample_num[cor][3]);
 			write_log(buff, 1);
-			buff.Printf(_T("      Too Short: %8d"),st_chkwav[spd].sample_num[cor][4]);
+			UTILS::str_printf(buff, "      Too Short: %8d",st_chkwav[spd].sample_num[cor][4]);
 			write_log(buff, 1);
-			buff.Printf(_T("      %dbaud: %4d  %dbaud: %4d  %dbaud: %4d  %dbaud: %4d")
+			UTILS::str_printf(buff, "      %dbaud: %4d  %dbaud: %4d  %dbaud: %4d  %dbaud: %4d"
 				,(int)c_baud_rate[0] * (spd + 1)
 				,st_chkwav[spd].baud_num[cor][0]
 				,(int)c_baud_rate[1] * (spd + 1)
@@ -1430,7 +1486,7 @@ void ParseWav::reporting_analyze()
 				,st_chkwav[spd].baud_num[cor][3]
 			);
 			write_log(buff, 1);
-			buff.Printf(_T("      Normal : %4d  Reverse : %4d  AmpMax : %4d  AmpMin : %4d  Serial Err:%d")
+			UTILS::str_printf(buff, "      Normal : %4d  Reverse : %4d  AmpMax : %4d  AmpMin : %4d  Serial Err:%d"
 				,st_chkwav[spd].rev_num[cor][0], st_chkwav[spd].rev_num[cor][1]
 				,st_chkwav[spd].amp_max[cor], st_chkwav[spd].amp_min[cor]
 				,st_chkwav[spd].ser_err[cor]
@@ -1438,31 +1494,31 @@ void ParseWav::reporting_analyze()
 			write_log(buff, 1);
 		}
 	}
-	write_log(_T(""), 1);
+	write_log("", 1);
 
 	// report
 	if (infile.GetType() <= FILETYPE_WAV && outfile.GetType() >= FILETYPE_WAV) {
 		int fsk_spd = param.GetFskSpeed();
 
-		buff = _T(" [ result ]");
+		buff = " [ result ]";
 		write_log(buff, 1);
 
-		buff = _T("  Wave Type: ");
-		buff += fsk_spd ? _T("Double Speed FSK") : _T("Standard FSK");
+		buff = "  Wave Type: ";
+		buff += fsk_spd ? "Double Speed FSK" : "Standard FSK";
 		write_log(buff, 1);
 
-		buff.Printf(_T("  Wave Reverse: %s"),(param.GetReverseWave() ? _T("on") : _T("off")));
+		UTILS::str_printf(buff, "  Wave Reverse: %s",(param.GetReverseWave() ? "on" : "off"));
 		write_log(buff, 1);
-		buff.Printf(_T("  Correct Type: %s"),(param.GetCorrectType() == 2 ? _T("sin wave") : _T("cos wave")));
+		UTILS::str_printf(buff, "  Correct Type: %s",(param.GetCorrectType() == 2 ? "sin wave" : "cos wave"));
 		write_log(buff, 1);
-//		buff.Printf(_T("  Avg: %4dHz  %4dHz")
+//		UTILS::str_printf(buff, "  Avg: %4dHz  %4dHz"
 //			,param.freq1200,param.freq2400);
 //		write_log(buff, 1);
 
-		buff.Printf(_T("  %4d Baud"),(int)c_baud_rate[param.GetBaud()] * (fsk_spd + 1));
+		UTILS::str_printf(buff, "  %4d Baud",(int)c_baud_rate[param.GetBaud()] * (fsk_spd + 1));
 		write_log(buff, 1);
 
-		write_log(_T(""), 1);
+		write_log("", 1);
 	}
 }
 
@@ -1471,18 +1527,18 @@ void ParseWav::reporting_analyze()
 /// @param[in] buff メッセージ
 /// @param[in] crlf 改行する行数
 ///
-void ParseWav::write_log(const wxString &buff, int crlf)
+void ParseWav::write_log(const std::string &buff, int crlf)
 {
-	if (buff.Length() > 0) {
-		gLogFile.Fputs(buff);
+	if (buff.length() > 0) {
+		logfile.Fputs(buff);
 		if (logbuf) *logbuf += buff;
 	}
 	for (int i=0; i<crlf; i++) {
-		gLogFile.Fputts(_T("\n"));
+		logfile.Fputs("\n");
 #ifdef _WIN32
-		if (logbuf) *logbuf += _T("\r\n");
+		if (logbuf) *logbuf += "\r\n";
 #else
-		if (logbuf) *logbuf += _T("\n");
+		if (logbuf) *logbuf += "\n";
 #endif
 	}
 }
@@ -1492,35 +1548,17 @@ void ParseWav::write_log(const wxString &buff, int crlf)
 /// @param[out] filename ファイル名
 ///
 ///
-void ParseWav::GetFileNameBase(wxString &filename)
+void ParseWav::GetFileNameBase(std::string &filename)
 {
 	UTILS::prefix_name(infile.GetName(), filename);
 }
 
-/// @brief 拡張子のチェック
-///
-/// @param[in] filename ファイル名
-/// @param[in] ext 拡張子名
-/// @return true 拡張子が一致 / false 一致しない
-bool ParseWav::check_extension(const wxString &filename, const wxString &ext)
-{
-	size_t nam_len = filename.Length();
-	size_t ext_len = ext.Length();
-
-	if(nam_len >= ext_len) {
-		if (filename.Right(ext_len).IsSameAs(ext, false) == true) {
-			return true;
-		}
-	}
-	return false;
-}
-
 /// @brief ログバッファへのポインタを設定
 ///
 /// @param[in,out] buf バッファポインタ
 ///
 ///
-void ParseWav::SetLogBufferPtr(wxString *buf)
+void ParseWav::SetLogBufferPtr(std::string *buf)
 {
 	logbuf = buf;
 }
@@ -1543,9 +1581,7 @@ int  ParseWav::GetRfDataFormat()
 bool ParseWav::ShowRfTypeBox()
 {
 	// ファイルの種類を選択
-	RfTypeBox rftypebox(parent_window, rftypeparam);
-	int rc = rftypebox.showRftypeBox(false);
-	if (rc != 1) {
+	if (!frontend->SelectRfType(rftypeparam, std::string(), false)) {
 		// cancel button
 		return false;
 	}
@@ -1565,12 +1601,9 @@ bool ParseWav::ShowRfTypeBox()
 /// @return true OK / false キャンセル
 ///
 bool ParseWav::ShowMAddressBox(bool hide_no_header_info) {
-	int rc;
 	int addr;
 
-	MAddressBox maddressbox(parent_window, maddressparam);
-	rc = maddressbox.showMAddressBox(hide_no_header_info);
-	if (rc == 1) {
+	if (frontend->InputMAddress(maddressparam, hide_no_header_info)) {
 //		maddress_t val = maddressbox->get();
 		rf_header[0] = 0;
 		addr = (int)maddressparam.GetStartAddr();
@@ -1614,6 +1647,7 @@ PwErrType ParseWav::DecodeData()
 
 	tmp_param.SetHalfWave(param.GetHalfWave());
 	tmp_param.SetAutoBaud(param.GetAutoBaud());
+	tmp_param.SetDemodType(param.GetDemodType());
 	tmp_param.SetCorrectType(param.GetCorrectType());
 	tmp_param.SetReverseWave(param.GetReverseWave());
 	tmp_param.SetViewProgBox(true);
@@ -1630,8 +1664,8 @@ PwErrType ParseWav::DecodeData()
 	serial_parser.ClearResult();
 	binary_parser.ClearResult();
 
-	wave_data->SetRate(inwav.GetSampleRate());
-	wave_correct_data->SetRate(inwav.GetSampleRate());
+	wave_data->SetRate(wave_parser.GetSampleRate());
+	wave_correct_data->SetRate(wave_parser.GetSampleRate());
 	carrier_data->SetRate(carrier_parser.GetSampleRate());
 
 //	memset(&inwav, 0, sizeof(inwav));
@@ -1665,7 +1699,14 @@ PwErrType ParseWav::DecodeData()
 		phase2n = PHASE2N_CONVERT_BAUD_RATE;
 		phase3 = PHASE3_DECODE_TO_BINARY;
 		phase4 = PHASE4_FIND_HEADER;
+		// 長いテープは無音の位置で分割して並列にデコードする
+		if (decode_segments()) {
+			break;
+		}
+		// wavファイルの読み込みと変換は別スレッドで先に進めておく
+		wave_parser.StartReader(tmp_param.GetReverseWave());
 		decode_phase1(fsk_spd, wave_data, wave_correct_data, carrier_data, serial_data, serial_new_data, binary_data, PHASE1_GET_WAV_SAMPLE);
+		wave_parser.StopReader();
 		break;
 	case FILETYPE_L3C:
 		// l3c
@@ -1766,6 +1807,7 @@ PwErrType ParseWav::ViewData(int dir, double spos, CSampleArray *a_data)
 
 		tmp_param.SetHalfWave(param.GetHalfWave());
 		tmp_param.SetAutoBaud(param.GetAutoBaud());
+		tmp_param.SetDemodType(param.GetDemodType());
 		tmp_param.SetCorrectType(param.GetCorrectType());
 		tmp_param.SetReverseWave(param.GetReverseWave());
 
@@ -1781,8 +1823,8 @@ PwErrType ParseWav::ViewData(int dir, double spos, CSampleArray *a_data)
 		serial_parser.ClearResult();
 		binary_parser.ClearResult();
 
-		wave_data->SetRate(inwav.GetSampleRate());
-		wave_correct_data->SetRate(inwav.GetSampleRate());
+		wave_data->SetRate(wave_parser.GetSampleRate());
+		wave_correct_data->SetRate(wave_parser.GetSampleRate());
 		carrier_data->SetRate(carrier_parser.GetSampleRate());
 
 		// 入力ファイル先頭にセット
@@ -2110,7 +2152,10 @@ void ParseWav::set_rf_info()
 
 /// @brief 波形を解析
 ///
-/// @return 0
+/// FSK速度と補正波形の組み合わせごとに別の解析器で並列に解析する。
+/// 入力は最初に一度だけ読み込み、すべての解析器で共有する。
+///
+/// @return 0 / -1:wavファイルが読めない
 ///
 ///
 int ParseWav::AnalyzeWave()
@@ -2123,13 +2168,14 @@ int ParseWav::AnalyzeWave()
 
 	tmp_param.SetHalfWave(true);	// 常に半波で解析
 	tmp_param.SetAutoBaud(true);	// 常に自動
+	tmp_param.SetDemodType(0);	// 常にゼロクロスで解析
 	tmp_param.SetCorrectType(param.GetCorrectType());
 	tmp_param.SetReverseWave(false);
 	tmp_param.SetViewProgBox(true);
 	tmp_param.SetDebugMode(0);
 
 	if (logbuf) {
-		*logbuf = _T("");
+		logbuf->clear();
 	}
 
 	for(int spd=0; spd < 2; spd++) {
@@ -2137,65 +2183,64 @@ int ParseWav::AnalyzeWave()
 	}
 	st_chkwav_analyzed_num = 0;
 
-	progress_div = inwav.GetSampleRate() * ANALYZE_SEC * 4;
+	progress_div = wave_parser.GetSampleRate() * ANALYZE_SEC * 4;
 
 	if (tmp_param.GetViewProgBox()) {
 		initProgress(1, 0, 100);
 	}
 
-	for(int spd=0; spd < 2; spd++) {
-		param.SetFskSpeed(spd);
-		for(int cor=0; cor < 2; cor++) {
-			st_chkwav[spd].num = cor;
-			// fseekする
-			infile.First();
-
-			wave_parser.CheckWaveFormat(infile, inwav.GetHead(), inwav.GetFmtChank(), inwav.GetDataChank(), conv, err_num, *errinfo);
-
-			wave_data->Init();
-			wave_correct_data->Init();
-			carrier_data->Init();
-			serial_data->Init();
-			serial_new_data->Init();
-			binary_data->Init();
-
-			st_chkwav[spd].analyze_num = inwav.GetSampleRate() * ANALYZE_SEC;	// 30秒解析
-
-			wave_parser.InitForDecode(process_mode, inwav, tmp_param, mile_stone);
-			carrier_parser.InitForDecode(process_mode, tmp_param, mile_stone);
-			serial_parser.InitForDecode(process_mode, tmp_param, mile_stone);
-			binary_parser.InitForDecode(process_mode, tmp_param, mile_stone);
-
-			mile_stone.Clear(DATA_ARRAY_SIZE / 2);
-
-			wave_parser.ClearResult();
-			carrier_parser.ClearResult();
-			serial_parser.ClearResult();
-			binary_parser.ClearResult();
-
-			tmp_param.SetCorrectType(cor + 1);
-
-			phase1 = PHASE1_GET_WAV_SAMPLE;
-			phase2 = PHASE2_PARSE_CARRIER;
-			phase2n = PHASE2N_CONVERT_BAUD_RATE;
-			phase3 = PHASE3_DECODE_TO_BINARY;
-			phase4 = PHASE4_FIND_HEADER;
-
-			decode_phase1(spd, wave_data, wave_correct_data, carrier_data, serial_data, serial_new_data, binary_data, PHASE1_GET_WAV_SAMPLE);
-			for(int i=0; i<5; i++) {
-				st_chkwav[spd].sample_num[cor][i]=wave_parser.GetReport().GetSampleNum(i);
-//				st_chkwav[spd].sample_odd[cor][i]=wave_parser.GetReport().GetSampleOdd(i);
-			}
+	// fseekする
+	infile.First();
+
+	if (wave_parser.CheckWaveFormat(infile, inwav.GetHead(), inwav.GetFmtChank(), inwav.GetDataChank(), conv, err_num, *errinfo) != pwOK) {
+		if (tmp_param.GetViewProgBox()) {
+			endProgress();
+		}
+		process_mode = PROCESS_IDLE;
+		return -1;
+	}
+
+	// 試行ごとに別の解析器を用意する
+	ParseWav *trials[ANALYZE_TRIALS];
+	int need_num = 0;
+	for(int i=0; i<ANALYZE_TRIALS; i++) {
+		param.SetFskSpeed(i / 2);
+		trials[i] = new ParseWav(NULL, this);
+		int num = trials[i]->prepare_analyze_trial(i / 2, i % 2);
+		if (need_num < num) need_num = num;
+	}
+
+	// 解析する範囲のサンプルを一度だけ読み込み、すべての試行で共有する
+	size_t frame_size = (size_t)(inwav.GetChannels() * inwav.GetSampleBits() / 8);
+	size_t len = (size_t)need_num * frame_size;
+	if (len > inwav.GetDataChank()->data_len) len = inwav.GetDataChank()->data_len;
+	std::vector<uint8_t> samples;
+	const uint8_t *data = NULL;
+	if (infile.IsMapped()) {
+		data = infile.Fmap(len);
+	} else if (len > 0) {
+		samples.resize(len);
+		len = infile.Fread(&samples[0], sizeof(uint8_t), len);
+		data = &samples[0];
+	}
+
+	// 親の解析器は最後の試行と同じ設定にしておく(レポートで参照する)
+	wave_parser.SetWaveInput(infile, inwav.GetFmtChank(), inwav.GetDataChank());
+	wave_parser.InitForDecode(process_mode, inwav, tmp_param, mile_stone);
+
+	for(int i=0; i<ANALYZE_TRIALS; i++) {
+		trials[i]->infile.Attach(data, len, infile.GetType());
+		trials[i]->infile.First();
+	}
 
-			st_chkwav[spd].us0avg[cor] = wave_parser.GetLamda().us_avg[spd];
-			st_chkwav[spd].us1avg[cor] = wave_parser.GetLamda().us_avg[spd+1];
-			st_chkwav[spd].amp_max[cor] = dft.GetAmpMax();
-			st_chkwav[spd].amp_min[cor] = dft.GetAmpMin();
+	trial_cancel = false;
 
-			st_chkwav[spd].ser_err[cor] = carrier_parser.GetReport().GetErrorNum();
+	run_trials(trials, ANALYZE_TRIALS, &ParseWav::run_analyze_trial, 0);
 
-			st_chkwav_analyzed_num += st_chkwav[spd].analyze_num;
-		}
+	// 結果をまとめる
+	for(int i=0; i<ANALYZE_TRIALS; i++) {
+		merge_analyze_trial(*trials[i]);
+		delete trials[i];
 	}
 
 	if (tmp_param.GetViewProgBox()) {
@@ -2283,6 +2328,326 @@ int ParseWav::AnalyzeWave()
 	return rc;
 }
 
+/// @brief 並列処理用の解析器をそれぞれ別のスレッドで動かし、すべて終わるまで待つ
+///
+/// 進捗の表示はこのスレッドで行う。スレッドを使わない場合は順番に動かす。
+///
+/// @param[in] trials   解析器
+/// @param[in] num      解析器の数
+/// @param[in] func     解析器で動かす関数
+/// @param[in] done_pos 先に終わった分の進捗
+///
+void ParseWav::run_trials(ParseWav **trials, int num, void (ParseWav::*func)(), int done_pos)
+{
+	trial_finished = 0;
+
+#ifdef PARSEWAV_USE_THREAD
+	std::vector<std::thread> threads;
+	for(int i=0; i<num; i++) {
+		threads.push_back(std::thread(func, trials[i]));
+	}
+	while(trial_finished < num) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		if (tmp_param.GetViewProgBox() && needSetProgress()) {
+			int pos = done_pos;
+			for(int i=0; i<num; i++) {
+				pos += trials[i]->trial_pos - trials[i]->trial_top;
+			}
+			if (setProgress(pos, progress_div)) {
+				trial_cancel = true;
+			}
+		}
+	}
+	for(int i=0; i<num; i++) {
+		threads[i].join();
+	}
+#else
+	for(int i=0; i<num && !trial_cancel; i++) {
+		(trials[i]->*func)();
+		done_pos += trials[i]->trial_pos - trials[i]->trial_top;
+		if (tmp_param.GetViewProgBox() && setProgress(done_pos, progress_div)) {
+			trial_cancel = true;
+		}
+	}
+#endif
+}
+
+/// @brief 並列解析用の解析器を親の設定で初期化する
+///
+/// @param[in] fsk_spd 1:倍速FSK
+/// @param[in] cor     0:cos波で補正 1:sin波で補正
+/// @return 解析に必要な入力のサンプル数(間引く前)
+///
+int ParseWav::prepare_analyze_trial(int fsk_spd, int cor)
+{
+	param = owner->param;
+	tmp_param = owner->tmp_param;
+	inwav = owner->inwav;
+	process_mode = owner->process_mode;
+	progress_div = owner->progress_div;
+
+	outfile.SetType(FILETYPE_NO_FILE);	// 出力ファイルなし
+
+	st_chkwav[fsk_spd].Clear();
+	st_chkwav[fsk_spd].num = cor;
+	st_chkwav_analyzed_num = 0;
+
+	wave_parser.SetWaveInput(infile, inwav.GetFmtChank(), inwav.GetDataChank());
+
+	st_chkwav[fsk_spd].analyze_num = wave_parser.GetSampleRate() * ANALYZE_SEC;	// 30秒解析
+
+	// 解析を打ち切るまでにwバッファ分は先に読むので余裕を持たせる
+	return (st_chkwav[fsk_spd].analyze_num + DATA_ARRAY_SIZE * 2) * wave_parser.GetDecimation();
+}
+
+/// @brief 並列解析の１試行分を解析する
+///
+/// 別スレッドで動くので、親のメンバは進捗と中断要求のみ参照する
+///
+void ParseWav::run_analyze_trial()
+{
+	int spd = param.GetFskSpeed();
+	int cor = st_chkwav[spd].num;
+
+	wave_data->Init();
+	wave_correct_data->Init();
+	carrier_data->Init();
+	serial_data->Init();
+	serial_new_data->Init();
+	binary_data->Init();
+
+	wave_parser.InitForDecode(process_mode, inwav, tmp_param, mile_stone);
+	carrier_parser.InitForDecode(process_mode, tmp_param, mile_stone);
+	serial_parser.InitForDecode(process_mode, tmp_param, mile_stone);
+	binary_parser.InitForDecode(process_mode, tmp_param, mile_stone);
+
+	mile_stone.Clear(DATA_ARRAY_SIZE / 2);
+
+	wave_parser.ClearResult();
+	carrier_parser.ClearResult();
+	serial_parser.ClearResult();
+	binary_parser.ClearResult();
+
+	tmp_param.SetCorrectType(cor + 1);
+
+	phase1 = PHASE1_GET_WAV_SAMPLE;
+	phase2 = PHASE2_PARSE_CARRIER;
+	phase2n = PHASE2N_CONVERT_BAUD_RATE;
+	phase3 = PHASE3_DECODE_TO_BINARY;
+	phase4 = PHASE4_FIND_HEADER;
+
+	decode_phase1(spd, wave_data, wave_correct_data, carrier_data, serial_data, serial_new_data, binary_data, PHASE1_GET_WAV_SAMPLE);
+	for(int i=0; i<5; i++) {
+		st_chkwav[spd].sample_num[cor][i]=wave_parser.GetReport().GetSampleNum(i);
+	}
+
+	st_chkwav[spd].us0avg[cor] = wave_parser.GetLamda().us_avg[spd];
+	st_chkwav[spd].us1avg[cor] = wave_parser.GetLamda().us_avg[spd+1];
+	st_chkwav[spd].amp_max[cor] = dft.GetAmpMax();
+	st_chkwav[spd].amp_min[cor] = dft.GetAmpMin();
+
+	st_chkwav[spd].ser_err[cor] = carrier_parser.GetReport().GetErrorNum();
+
+	owner->trial_finished++;
+}
+
+/// @brief 並列解析の結果を取り込む
+///
+/// @param[in] trial 解析し終わった解析器
+///
+void ParseWav::merge_analyze_trial(const ParseWav &trial)
+{
+	int spd = trial.param.GetFskSpeed();
+	const ChkWave &src = trial.st_chkwav[spd];
+	ChkWave &dst = st_chkwav[spd];
+	int cor = src.num;
+
+	dst.num = cor;
+	dst.analyze_num = src.analyze_num;
+	for(int i=0; i<5; i++) {
+		dst.sample_num[cor][i] = src.sample_num[cor][i];
+	}
+	for(int i=0; i<4; i++) {
+		dst.baud_num[cor][i] = src.baud_num[cor][i];
+	}
+	for(int i=0; i<2; i++) {
+		dst.rev_num[cor][i] = src.rev_num[cor][i];
+	}
+	dst.us0avg[cor] = src.us0avg[cor];
+	dst.us1avg[cor] = src.us1avg[cor];
+	dst.amp_max[cor] = src.amp_max[cor];
+	dst.amp_min[cor] = src.amp_min[cor];
+	dst.ser_err[cor] = src.ser_err[cor];
+
+	st_chkwav_analyzed_num += dst.analyze_num;
+}
+
+/// @brief 長いテープを無音の位置で区間に分けて並列にデコードする
+///
+/// 区間ごとに別の解析器でデコードし、出力とレポートは区間の順につなげる。
+/// 区間をまたいで状態を持つ出力形式の場合、入力をマップできない場合、
+/// 分割できる無音がない場合、スレッド数に1を指定した場合は分割しない。
+///
+/// @return true 分割してデコードした / false 分割しないので通常どおりデコードする
+///
+bool ParseWav::decode_segments()
+{
+#ifdef PARSEWAV_USE_THREAD
+	int threads_num = param.GetDecodeThreads();
+	if (threads_num <= 0) threads_num = (int)std::thread::hardware_concurrency();
+	if (threads_num < 2) return false;
+	if (!infile.IsMapped()) return false;
+	// 出力はL3かファイルなしのみ
+	if (outfile.GetType() != FILETYPE_L3 && outfile.GetType() != FILETYPE_NO_FILE) return false;
+	// デバッグログは順番に出す必要がある
+	if (tmp_param.GetDebugMode() > 0) return false;
+
+	std::vector<int> cuts;
+	if (wave_parser.FindSilentCuts(cuts, wave_parser.GetSampleRate() * SEGMENT_MIN_SEC) <= 0) return false;
+	cuts.insert(cuts.begin(), 0);
+	cuts.push_back(infile.SampleNum());
+
+	// 入力は区間ごとにマップした領域を参照する
+	size_t frame_size = (size_t)(inwav.GetChannels() * inwav.GetSampleBits() / 8);
+	size_t len = (size_t)inwav.GetDataChank()->data_len;
+	const uint8_t *data = infile.Fmap(len);
+	size_t frame_len = (size_t)wave_parser.GetDecimation() * frame_size;
+
+	int seg_num = (int)cuts.size() - 1;
+	int done_pos = 0;
+
+	trial_cancel = false;
+
+	for(int top=0; top<seg_num && !trial_cancel; top+=threads_num) {
+		int num = seg_num - top;
+		if (num > threads_num) num = threads_num;
+
+		std::vector<ParseWav *> segs(num);
+		std::vector< std::vector<uint8_t> > out_datas(num);
+		for(int i=0; i<num; i++) {
+			int n = top + i;
+			size_t spos = (size_t)cuts[n] * frame_len;
+			size_t epos = (n + 1 < seg_num ? (size_t)cuts[n + 1] * frame_len : len);
+			if (spos > len) spos = len;
+			if (epos > len) epos = len;
+			segs[i] = new ParseWav(NULL, this);
+			segs[i]->prepare_decode_segment(&data[spos], epos - spos, cuts[n], &out_datas[i]);
+		}
+
+		run_trials(&segs[0], num, &ParseWav::run_decode_segment, done_pos);
+
+		// 区間の順につなげる
+		for(int i=0; i<num; i++) {
+			merge_decode_segment(*segs[i], out_datas[i]);
+			delete segs[i];
+		}
+		done_pos += cuts[top + num] - cuts[top];
+	}
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+/// @brief 区間をデコードする解析器を親の設定で初期化する
+///
+/// サンプル位置は入力全体での位置にする
+///
+/// @param[in]  data      区間の入力データ
+/// @param[in]  len       区間の入力データの長さ(バイト)
+/// @param[in]  start_pos 区間の開始位置(間引いた後のサンプル位置)
+/// @param[out] out_data  L3出力の出力先
+///
+void ParseWav::prepare_decode_segment(const uint8_t *data, size_t len, int start_pos, std::vector<uint8_t> *out_data)
+{
+	param = owner->param;
+	tmp_param = owner->tmp_param;
+	inwav = owner->inwav;
+	process_mode = owner->process_mode;
+	progress_div = owner->progress_div;
+
+	if (owner->outfile.GetType() == FILETYPE_L3) {
+		outfile.OpenMemory(out_data);
+	}
+	outfile.SetType(owner->outfile.GetType());
+
+	infile.Attach(data, len, owner->infile.GetType());
+	infile.First();
+
+	wav_data_chank_t data_chank = *inwav.GetDataChank();
+	data_chank.data_len = (uint32_t)len;
+	wave_parser.SetWaveInput(infile, inwav.GetFmtChank(), &data_chank);
+
+	infile.SampleNum(start_pos + infile.SampleNum());
+	infile.SamplePos(start_pos);
+
+	trial_top = start_pos;
+	trial_pos = start_pos;
+}
+
+/// @brief 区間をデコードする
+///
+/// 別スレッドで動くので、親のメンバは進捗と中断要求のみ参照する
+///
+void ParseWav::run_decode_segment()
+{
+	wave_data->Init();
+	wave_correct_data->Init();
+	carrier_data->Init();
+	serial_data->Init();
+	serial_new_data->Init();
+	binary_data->Init();
+
+	wave_parser.InitForDecode(process_mode, inwav, tmp_param, mile_stone);
+	carrier_parser.InitForDecode(process_mode, tmp_param, mile_stone);
+	serial_parser.InitForDecode(process_mode, tmp_param, mile_stone);
+	binary_parser.InitForDecode(process_mode, tmp_param, mile_stone);
+
+	mile_stone.Clear(DATA_ARRAY_SIZE / 2);
+
+	wave_parser.ClearResult();
+	carrier_parser.ClearResult();
+	serial_parser.ClearResult();
+	binary_parser.ClearResult();
+
+	wave_data->SetRate(wave_parser.GetSampleRate());
+	wave_correct_data->SetRate(wave_parser.GetSampleRate());
+	carrier_data->SetRate(carrier_parser.GetSampleRate());
+
+	phase1 = PHASE1_GET_WAV_SAMPLE;
+	phase2 = PHASE2_DECODE_TO_SERIAL;
+	phase2n = PHASE2N_CONVERT_BAUD_RATE;
+	phase3 = PHASE3_DECODE_TO_BINARY;
+	phase4 = PHASE4_FIND_HEADER;
+	decode_phase1(param.GetFskSpeed(), wave_data, wave_correct_data, carrier_data, serial_data, serial_new_data, binary_data, PHASE1_GET_WAV_SAMPLE);
+
+	// 出力先のメモリに書き出しておく
+	outfile.Fclose();
+
+	owner->trial_finished++;
+}
+
+/// @brief デコードし終わった区間の出力と結果を取り込む
+///
+/// @param[in,out] seg      デコードし終わった解析器
+/// @param[in]     out_data 区間のL3出力
+///
+void ParseWav::merge_decode_segment(ParseWav &seg, const std::vector<uint8_t> &out_data)
+{
+	if (!out_data.empty()) {
+		outfile.Write(&out_data[0], out_data.size());
+	}
+
+	wave_parser.MergeResult(seg.wave_parser);
+	carrier_parser.MergeResult(seg.carrier_parser);
+	serial_parser.MergeResult(seg.serial_parser);
+	binary_parser.MergeResult(seg.binary_parser);
+
+	carrier_data->AddTotalPos(*seg.carrier_data);
+	serial_data->AddTotalPos(*seg.serial_data);
+}
+
 /// @brief 変換したデータをファイルに出力
 ///
 /// @return true 正常 / false エラーあり
@@ -2295,16 +2660,16 @@ bool ParseWav::ExportData(enum_file_type file_type)
 		outfile.SetType(file_type);
 	}
 
-	gLogFile.SetLogBuf(logbuf);
+	logfile.SetLogBuf(logbuf);
 	if (logbuf) {
-		*logbuf = _T("");
+		logbuf->clear();
 	}
 
 	tmp_param.SetDebugMode(param.GetDebugMode());
 
 	// デバッグログオープン
 	if (tmp_param.GetDebugMode() > 0) {
-		if (!gLogFile.Open(logfilename)) {
+		if (!logfile.Open(logfilename)) {
 			err_num = pwErrCannotWriteDebugLog;
 			errinfo->SetInfo(__LINE__, pwWarning, err_num);
 			errinfo->ShowMsgBox();
@@ -2323,7 +2688,7 @@ bool ParseWav::ExportData(enum_file_type file_type)
 
 	reporting();
 
-	gLogFile.Close();
+	logfile.Close();
 
 	if (tmp_param.GetViewProgBox()) {
 		endProgress();
@@ -2342,30 +2707,28 @@ bool ParseWav::ExportData(enum_file_type file_type)
 /// @param[in] outfile_type ファイル種類
 /// @return true:正常 false:エラーあり
 ///
-bool ParseWav::OpenOutFile(const wxString &out_file, enum_file_type outfile_type)
+bool ParseWav::OpenOutFile(const std::string &out_file, enum_file_type outfile_type)
 {
 	// 同じファイルはダメ
-	wxFileName infile_name = wxFileName::FileName(infile.GetName());
-	wxFileName outfile_name = wxFileName::FileName(out_file);
-	if (outfile_name.SameAs(infile_name)) {
+	if (UTILS::same_path(out_file, infile.GetName())) {
 		err_num = pwErrSameFile;
 		errinfo->SetInfo(__LINE__, pwError, err_num);
 		errinfo->ShowMsgBox();
 		return false;
 	}
 
-	logfilename = out_file + _T(".log");
+	logfilename = out_file + ".log";
 
 	if (outfile_type == FILETYPE_UNKNOWN) {
-		if (check_extension(out_file, _T(".WAV"))) {
+		if (UTILS::check_extension(out_file, ".WAV")) {
 			outfile_type = FILETYPE_WAV;
-		} else if (check_extension(out_file, _T(".L3C"))) {
+		} else if (UTILS::check_extension(out_file, ".L3C")) {
 			outfile_type = FILETYPE_L3C;
-		} else if (check_extension(out_file, _T(".L3B"))) {
+		} else if (UTILS::check_extension(out_file, ".L3B")) {
 			outfile_type = FILETYPE_L3B;
-		} else if (check_extension(out_file, _T(".T9X"))) {
+		} else if (UTILS::check_extension(out_file, ".T9X")) {
 			outfile_type = FILETYPE_T9X;
-		} else if (check_extension(out_file, _T(".L3"))) {
+		} else if (UTILS::check_extension(out_file, ".L3")) {
 			outfile_type = FILETYPE_L3;
 		} else {
 			outfile_type = FILETYPE_REAL;
@@ -2375,21 +2738,21 @@ bool ParseWav::OpenOutFile(const wxString &out_file, enum_file_type outfile_type
 	if (param.GetFileSplit() && outfile_type == FILETYPE_REAL) {
 		// 分割する場合
 #ifdef _WIN32
-		int seppos = out_file.Find(wxChar('\\'), true);
+		size_t seppos = out_file.find_last_of("\\/");
 #else
-		int seppos = out_file.Find(wxChar('/'), true);
+		size_t seppos = out_file.rfind('/');
 #endif
-		int pos = out_file.Find(wxChar('.'), true);
-		if (pos != wxNOT_FOUND && seppos < pos) {
-			outsext = out_file.Mid(pos);
-			outsfileb = out_file.Left(pos);
+		size_t pos = out_file.rfind('.');
+		if (pos != std::string::npos && (seppos == std::string::npos || seppos < pos)) {
+			outsext = out_file.substr(pos);
+			outsfileb = out_file.substr(0, pos);
 		} else {
-			outsext = _T("");
+			outsext.clear();
 			outsfileb = out_file;
 		}
 
-		wxString outsfilen = outsfileb;
-		outsfilen += wxString::Format(_T("_%03d"), 1);
+		std::string outsfilen = outsfileb;
+		outsfilen += UTILS::str_format("_%03d", 1);
 		outsfilen += outsext;
 		if (!outsfile.Fopen(outsfilen, File::WRITE_BINARY)) {
 			err_num = pwErrCannotWrite;
@@ -2426,7 +2789,7 @@ void ParseWav::CloseOutFile()
 	outsfile.Fclose();
 	outfile.Fclose();
 
-	logfilename = _T("wavtool.log");
+	logfilename = "wavtool.log";
 }
 
 /// @brief 入力ファイルを開く
@@ -2434,21 +2797,21 @@ void ParseWav::CloseOutFile()
 /// @param[in] in_file ファイルパス名
 /// @return true:正常 false:エラー
 ///
-bool ParseWav::OpenDataFile(const wxString &in_file)
+bool ParseWav::OpenDataFile(const std::string &in_file)
 {
 	PwErrType rc;
 
 
 	enum_file_type infile_type = FILETYPE_UNKNOWN;
-	if (check_extension(in_file, _T(".WAV"))) {
+	if (UTILS::check_extension(in_file, ".WAV")) {
 		infile_type = FILETYPE_WAV;
-	} else if (check_extension(in_file, _T(".L3C"))) {
+	} else if (UTILS::check_extension(in_file, ".L3C")) {
 		infile_type = FILETYPE_L3C;
-	} else if (check_extension(in_file, _T(".L3B"))) {
+	} else if (UTILS::check_extension(in_file, ".L3B")) {
 		infile_type = FILETYPE_L3B;
-	} else if (check_extension(in_file, _T(".T9X"))) {
+	} else if (UTILS::check_extension(in_file, ".T9X")) {
 		infile_type = FILETYPE_T9X;
-	} else if (check_extension(in_file, _T(".L3"))) {
+	} else if (UTILS::check_extension(in_file, ".L3")) {
 		infile_type = FILETYPE_L3;
 	} else {
 		infile_type = FILETYPE_PLAIN;
@@ -2509,55 +2872,42 @@ int ParseWav::OpenedDataFileCount(int *sample_num)
 
 void ParseWav::initProgress(int type, int min_val, int max_val)
 {
-#ifdef USE_PROGRESSBOX
-	progbox->initProgress(type, min_val, max_val);
-#endif
+	frontend->InitProgress(type, min_val, max_val);
 }
 bool ParseWav::needSetProgress() const
 {
-#ifdef USE_PROGRESSBOX
-	return progbox->needSetProgress();
-#else
-	return false;
-#endif
+	if (owner) return true;
+	return frontend->NeedSetProgress();
 }
 bool ParseWav::setProgress(int val)
 {
-#ifdef USE_PROGRESSBOX
-	return progbox->setProgress(val);
-#else
-	return false;
-#endif
+	if (owner) {
+		// 並列解析中は親がまとめて表示する
+		trial_pos = val;
+		return owner->trial_cancel;
+	}
+	return frontend->SetProgress(val);
 }
 bool ParseWav::setProgress(int num, int div)
 {
-#ifdef USE_PROGRESSBOX
-	return progbox->setProgress(num, div);
-#else
-	return false;
-#endif
+	if (owner) {
+		// 並列解析中は親がまとめて表示する
+		trial_pos = num;
+		return owner->trial_cancel;
+	}
+	return frontend->SetProgress(num, div);
 }
 bool ParseWav::incProgress()
 {
-#ifdef USE_PROGRESSBOX
-	return progbox->incProgress();
-#else
-	return false;
-#endif
+	return frontend->IncProgress();
 }
 bool ParseWav::viewProgress()
 {
-#ifdef USE_PROGRESSBOX
-	return progbox->viewProgress();
-#else
-	return false;
-#endif
+	return frontend->ViewProgress();
 }
 void ParseWav::endProgress()
 {
-#ifdef USE_PROGRESSBOX
-	progbox->endProgress();
-#endif
+	frontend->EndProgress();
 }
 
 }; /* namespace PARSEWAV */
@@ -12,8 +12,8 @@
 //#define _USE_MATH_DEFINES
 //#include <math.h>
 #include <vector>
+#include <string>
 #include "common.h"
-#include <wx/wx.h>
 #include "paw_defs.h"
 #include "paw_param.h"
 #include "paw_datas.h"
@@ -22,13 +22,14 @@
 #include "paw_parsecar.h"
 #include "paw_parseser.h"
 #include "paw_parsebin.h"
-#include "progressbox.h"
-#include "rftypebox.h"
-#include "maddressbox.h"
+#include "paw_frontend.h"
 #include "errorinfo.h"
 #include "paw_format.h"
 #include "paw_util.h"
 #include "paw_dft.h"
+#ifdef PARSEWAV_USE_THREAD
+#include <atomic>
+#endif
 
 
 namespace PARSEWAV
@@ -42,23 +43,24 @@ namespace PARSEWAV
 class ParseWav
 {
 private:
-	ProgressBox *progbox;
+	Frontend *frontend;			///< 進捗表示や問い合わせ先
+	Frontend default_frontend;	///< 何も表示しない場合
 	RfTypeParam rftypeparam;
 	MAddressParam maddressparam;
-	wxWindow *parent_window;
 	PwErrInfo *errinfo;
 
 	InputFile infile;
 	OutputFile outfile;
 	OutputFile outsfile;
+	LogFile logfile;			///< デバッグログ(解析器ごとに持つ)
 
-	wxString logfilename;
+	std::string logfilename;
 
-//	wxString outsfilen;
-	wxString outsfileb;
-	wxString outsext;
+//	std::string outsfilen;
+	std::string outsfileb;
+	std::string outsext;
 
-	wxString *logbuf;
+	std::string *logbuf;
 
 	bool include_header;
 	uint8_t rf_header[5];
@@ -99,6 +101,7 @@ private:
 		PHASE3_GET_L3B_SAMPLE,
 		PHASE3_GET_T9X_SAMPLE,
 		PHASE3_PUT_L3B_SAMPLE,
+		PHASE3_PUT_L3C_SAMPLE,
 		PHASE4_FIND_HEADER = 41,
 		PHASE4_PARSE_NAME_SECTION,
 		PHASE4_PARSE_BODY_SECTION,
@@ -139,11 +142,24 @@ private:
 	WaveFormat inwav;
 	WaveFormat outwav;
 
-	wxString buff;
+	std::string buff;
 //	char cbuff[1000];
 
 	int progress_div;
 
+	ParseWav *owner;	///< 並列で解析するために作った場合は親
+	int trial_top;		///< 並列解析中の進捗の開始位置
+
+#ifdef PARSEWAV_USE_THREAD
+	std::atomic<int>  trial_pos;		///< 並列解析中の進捗(サンプル位置)
+	std::atomic<int>  trial_finished;	///< 並列解析が終わった数(親が持つ)
+	std::atomic<bool> trial_cancel;		///< 並列解析の中断要求(親が持つ)
+#else
+	int  trial_pos;
+	int  trial_finished;
+	bool trial_cancel;
+#endif
+
 	PwErrType check_rf_format(InputFile &file);
 	PwErrType get_first_rf_data(InputFile &file);
 
@@ -166,24 +182,33 @@ private:
 
 	void  set_rf_info();
 
+	void  run_trials(ParseWav **trials, int num, void (ParseWav::*func)(), int done_pos);
+
+	int   prepare_analyze_trial(int fsk_spd, int cor);
+	void  run_analyze_trial();
+	void  merge_analyze_trial(const ParseWav &trial);
+
+	bool  decode_segments();
+	void  prepare_decode_segment(const uint8_t *data, size_t len, int start_pos, std::vector<uint8_t> *out_data);
+	void  run_decode_segment();
+	void  merge_decode_segment(ParseWav &seg, const std::vector<uint8_t> &out_data);
+
 	void  reporting();
 	void  reporting_analyze();
-	void  write_log(const wxString &, int);
-
-	bool check_extension(const wxString &filename, const wxString &ext);
+	void  write_log(const std::string &, int);
 
 	void out_dummy_tail_data(OutputFile &file);
 
 public:
-	ParseWav(wxWindow *parent);
+	ParseWav(Frontend *frontend_ = NULL, ParseWav *owner_ = NULL);
 	~ParseWav();
 
-	bool OpenDataFile(const wxString &in_file);
+	bool OpenDataFile(const std::string &in_file);
 	void CloseDataFile();
 	PwErrType CheckFileFormat(InputFile &file);
 	PwErrType SeekFileFormat(InputFile &file);
 
-	bool OpenOutFile(const wxString &out_file, enum_file_type outfile_type);
+	bool OpenOutFile(const std::string &out_file, enum_file_type outfile_type);
 	void CloseOutFile();
 
 	int InitFileHeader(OutputFile &file);
@@ -196,9 +221,9 @@ public:
 	PwErrType EncodeData();
 	int AnalyzeWave();
 
-	void GetFileNameBase(wxString &);
+	void GetFileNameBase(std::string &);
 
-	void SetLogBufferPtr(wxString *);
+	void SetLogBufferPtr(std::string *);
 
 	bool ShowRfTypeBox();
 	bool ShowMAddressBox(bool);
@@ -212,6 +237,8 @@ public:
 	Parameter &GetParam() { return param; }
 	const Parameter &GetParam() const { return param; }
 	void SetParam(const Parameter &data) { param = data; }
+	RfTypeParam &GetRfTypeParam() { return rftypeparam; }
+	MAddressParam &GetMAddressParam() { return maddressparam; }
 
 #if 0
 	void SetSampleRate(int value) { param.SetSampleRate(value); }
@@ -6,6 +6,10 @@
 ///
 #include "paw_datas.h"
 #include <string.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SAMPLEARRAY_USE_SSE2
+#endif
 
 
 namespace PARSEWAV 
@@ -32,6 +36,12 @@ CSampleData::CSampleData(uint8_t data, int spos, int8_t baud, uint8_t err, uint8
 	SnSta(sn_sta);
 	User(user);
 }
+CSampleData::CSampleData(uint8_t data, int spos, uint32_t attr)
+{
+	DataAll(attr);
+	Data(data);
+	SPos(spos);
+}
 CSampleData &CSampleData::operator=(const CSampleData &src)
 {
 	Set(src);
@@ -55,6 +65,13 @@ uint32_t CSampleData::DataAll() const
 {
 	return m_data_all;
 }
+/// @brief データ部分を除いたフラグ類
+uint32_t CSampleData::Attr() const
+{
+	CSampleData d(*this);
+	d.Data(0);
+	return d.DataAll();
+}
 int8_t CSampleData::Baud() const
 {
 	return static_cast<int8_t>(m_baud > 7 ? m_baud | 0xf8 : m_baud);
@@ -129,28 +146,78 @@ void CSampleData::User(uint8_t val)
 
 //
 
+CMultiPattern::CMultiPattern()
+{
+	m_num = 0;
+	m_min_len = 0;
+	m_max_len = 0;
+	m_binary = false;
+}
+
+/// @brief パターンをセットしてマスクを作成する
+/// @param[in] ptns パターン(長さはMAX_LENGTHまで)
+/// @param[in] num  パターン数(MAX_PATTERNSまで)
+void CMultiPattern::Set(const struct st_pattern *ptns, int num)
+{
+	if (num > MAX_PATTERNS) num = MAX_PATTERNS;
+	m_num = num;
+	m_min_len = MAX_LENGTH;
+	m_max_len = 0;
+	m_binary = true;
+	for(int k=0; k<num; k++) {
+		int len = ptns[k].len;
+		if (len > MAX_LENGTH) len = MAX_LENGTH;
+		m_len[k] = len;
+		m_ptns[k] = ptns[k].ptn;
+		m_bits[k] = 0;
+		if (m_min_len > len) m_min_len = len;
+		if (m_max_len < len) m_max_len = len;
+		for(int c=0; c<256; c++) {
+			m_masks[k][c] = ~(uint32_t)0;
+		}
+		for(int i=0; i<len; i++) {
+			uint8_t c = ptns[k].ptn[i];
+			m_masks[k][c] &= ~((uint32_t)1 << i);
+			if (c == '1') m_bits[k] |= ((uint32_t)1 << i);
+			else if (c != '0') m_binary = false;
+		}
+	}
+}
+
+//
+
 CSampleArray::CSampleArray(int init_size)
 {
 #ifdef USE_SAMPLEARRAY_POINTER
 	m_datas = NULL;
+	m_sposs = NULL;
+	m_attrs = NULL;
 	m_size = 0;
 	Init();
 
 	if (init_size > 0) {
 		m_size = init_size;
-		m_datas = new CSampleData[init_size];
+		m_datas = new uint8_t[init_size];
+		m_sposs = new int[init_size];
+		m_attrs = new uint32_t[init_size];
 	}
 #else
 	Init();
 	m_size = DATA_ARRAY_SIZE;
 #endif
+	m_bits = NULL;
+	m_nbins = NULL;
 }
 
 CSampleArray::CSampleArray(const CSampleArray &src)
 {
 #ifdef USE_SAMPLEARRAY_POINTER
 	m_datas = NULL;
+	m_sposs = NULL;
+	m_attrs = NULL;
 #endif
+	m_bits = NULL;
+	m_nbins = NULL;
 	m_size = 0;
 	Init();
 }
@@ -159,7 +226,11 @@ CSampleArray::~CSampleArray()
 {
 #ifdef USE_SAMPLEARRAY_POINTER
 	delete [] m_datas;
+	delete [] m_sposs;
+	delete [] m_attrs;
 #endif
+	delete [] m_bits;
+	delete [] m_nbins;
 }
 
 /// @brief 初期化
@@ -181,17 +252,76 @@ void CSampleArray::Clear()
 	m_w_pos = 0;
 	m_r_pos = 0;
 	m_start_pos = 0;
+	m_spos_sorted = true;
+#ifdef USE_SAMPLEARRAY_RING
+	m_head = 0;
+#endif
+}
+
+/// @brief パターン照合用のビットプレーンを作成する
+///
+/// 作成した後はデータの追加ごとに更新する
+void CSampleArray::UseBits()
+{
+	if (m_bits || m_size <= 0) return;
+	m_bits = new uint32_t[DATA_BITS_SIZE(m_size)];
+	m_nbins = new uint32_t[DATA_BITS_SIZE(m_size)];
+	memset(m_bits, 0, sizeof(uint32_t) * DATA_BITS_SIZE(m_size));
+	memset(m_nbins, 0, sizeof(uint32_t) * DATA_BITS_SIZE(m_size));
+}
+
+/// @brief 追加するsposが前のデータより小さくなるか調べる
+/// @param[in] spos 追加するデータの先頭のサンプル位置
+void CSampleArray::CheckSPos(int spos)
+{
+	if (m_w_pos > 0 && spos < m_sposs[Idx(m_w_pos - 1)]) {
+		m_spos_sorted = false;
+	}
+}
+
+/// @brief ビットプレーンを更新する
+/// @param[in] idx  配列上の位置
+/// @param[in] data データ
+void CSampleArray::SetBits(int idx, uint8_t data)
+{
+	uint32_t bit = ((uint32_t)1 << (idx & 31));
+	int w = (idx >> 5);
+	if (data == '1') m_bits[w] |= bit;
+	else m_bits[w] &= ~bit;
+	if (data == '0' || data == '1') m_nbins[w] &= ~bit;
+	else m_nbins[w] |= bit;
+}
+
+/// @brief ビットプレーンから指定位置以降の32個分を取り出す
+/// @param[in] plane ビットプレーン
+/// @param[in] pos   位置
+/// @return 最下位ビットが指定位置
+uint32_t CSampleArray::GetBits(const uint32_t *plane, int pos) const
+{
+	int idx = Idx(pos % m_size);
+	int w = (idx >> 5);
+	int sh = (idx & 31);
+	uint32_t val = (plane[w] >> sh);
+	if (sh > 0) val |= (plane[w + 1] << (32 - sh));
+	if (idx + 32 > m_size) {
+		// 配列の末尾で折り返す
+		int n = m_size - idx;
+		val &= (((uint32_t)1 << n) - 1);
+		val |= (plane[0] << n);
+	}
+	return val;
 }
 
 /// @brief 指定位置のデータ
 /// @param[in] pos 位置
-const CSampleData &CSampleArray::At(int pos) const
+CSampleData CSampleArray::At(int pos) const
 {
 #ifdef USE_SAMPLEARRAY_POINTER
-	if (!m_datas) return;
+	if (!m_datas) return m_dummy;
 #endif
 	if (0 <= pos && pos < m_size) {
-		return m_datas[pos];
+		int i = Idx(pos);
+		return CSampleData(m_datas[i], m_sposs[i], m_attrs[i]);
 	} else {
 		return m_dummy;
 	}
@@ -199,62 +329,56 @@ const CSampleData &CSampleArray::At(int pos) const
 
 /// @brief リード位置のデータ
 /// @param[in] offset オフセット
-const CSampleData &CSampleArray::GetRead(int offset) const
+CSampleData CSampleArray::GetRead(int offset) const
 {
 	return At(m_r_pos + offset);
 }
 
 /// @brief ライト位置のデータ
 /// @param[in] offset オフセット
-const CSampleData &CSampleArray::GetWrite(int offset) const
+CSampleData CSampleArray::GetWrite(int offset) const
 {
 	return At(m_w_pos + offset);
 }
 
-/// @brief スタート位置からの長さ
-int CSampleArray::Length() const
-{
-	return m_w_pos - m_start_pos;
-}
-
-/// @brief 書き込み可能な残りフリーサイズ
-int CSampleArray::FreeSize() const
-{
-	return m_size - m_w_pos;
-}
-
-/// @brief 指定位置のデータポインタを返す
-CSampleData *CSampleArray::GetPtr(int pos)
+/// @brief 指定位置のサンプルデータのみ
+/// @param[in] pos 位置
+uint8_t CSampleArray::AtData(int pos) const
 {
 #ifdef USE_SAMPLEARRAY_POINTER
-	if (!m_datas) return;
+	if (!m_datas) return m_dummy.Data();
 #endif
 	if (0 <= pos && pos < m_size) {
-		return &m_datas[pos];
+		return m_datas[Idx(pos)];
 	} else {
-		return NULL;
+		return m_dummy.Data();
 	}
 }
 
-/// @brief スタート位置のデータポインタを返す
-/// @param[in] offset オフセット
-CSampleData *CSampleArray::GetStartPtr(int offset)
+/// @brief 指定位置のサンプル位置のみ
+/// @param[in] pos 位置
+int CSampleArray::AtSPos(int pos) const
 {
-	return GetPtr(m_start_pos + offset);
+#ifdef USE_SAMPLEARRAY_POINTER
+	if (!m_datas) return m_dummy.SPos();
+#endif
+	if (0 <= pos && pos < m_size) {
+		return m_sposs[Idx(pos)];
+	} else {
+		return m_dummy.SPos();
+	}
 }
 
-/// @brief リード位置のデータポインタを返す
-/// @param[in] offset オフセット
-CSampleData *CSampleArray::GetReadPtr(int offset)
+/// @brief スタート位置からの長さ
+int CSampleArray::Length() const
 {
-	return GetPtr(m_r_pos + offset);
+	return m_w_pos - m_start_pos;
 }
 
-/// @brief ライト位置のデータポインタを返す
-/// @param[in] offset オフセット
-CSampleData *CSampleArray::GetWritePtr(int offset)
+/// @brief 書き込み可能な残りフリーサイズ
+int CSampleArray::FreeSize() const
 {
-	return GetPtr(m_w_pos + offset);
+	return m_size - m_w_pos;
 }
 
 /// @brief 追加してライト位置を＋１
@@ -265,7 +389,12 @@ void CSampleArray::Add(const CSampleData &val)
 	if (!m_datas) return;
 #endif
 	if (m_w_pos < m_size) {
-		m_datas[m_w_pos] = val;
+		CheckSPos(val.SPos());
+		int i = Idx(m_w_pos);
+		m_datas[i] = val.Data();
+		m_sposs[i] = val.SPos();
+		m_attrs[i] = val.Attr();
+		if (m_bits) SetBits(i, val.Data());
 		m_w_pos++;
 		m_total_w_pos++;
 	}
@@ -298,13 +427,39 @@ void CSampleArray::Add(uint8_t data, int spos, int8_t baud, uint8_t err, uint8_t
 /// @return 追加した文字数
 int CSampleArray::AddString(const uint8_t *str, int len, int spos, int8_t baud, uint8_t err, uint8_t c_phase, uint8_t c_frip, uint8_t sn_sta, uint8_t user)
 {
+#ifdef USE_SAMPLEARRAY_POINTER
+	if (!m_datas) return 0;
+#endif
+	if (len <= 0) return 0;
+	// 終端文字まで
+	const uint8_t *term = (const uint8_t *)memchr(str, 0, len);
+	if (term) len = (int)(term - str);
+	if (len > m_size - m_w_pos) len = m_size - m_w_pos;
+	if (len <= 0) return 0;
+
+	CheckSPos(spos);
+	uint32_t attr = CSampleData(0, 0, baud, err, c_phase ,c_frip, sn_sta, user).Attr();
 	int n = 0;
-	while(*str != 0 && n < len && m_w_pos < m_size) {
-		Add(*str, spos, baud, err, c_phase ,c_frip, sn_sta, user);
-		str++;
-		n++;
+	while(n < len) {
+		// 配列の末尾までまとめてコピー
+		int i = Idx(m_w_pos + n);
+		int seg = m_size - i;
+		if (seg > len - n) seg = len - n;
+		memcpy(&m_datas[i], &str[n], seg);
+		for(int k = 0; k < seg; k++) {
+			m_sposs[i + k] = spos;
+			m_attrs[i + k] = attr;
+		}
+		if (m_bits) {
+			for(int k = 0; k < seg; k++) {
+				SetBits(i + k, str[n + k]);
+			}
+		}
+		n += seg;
 	}
-	return n;
+	m_w_pos += len;
+	m_total_w_pos += len;
+	return len;
 }
 
 /// @brief 繰り返しセット
@@ -328,6 +483,35 @@ int CSampleArray::Repeat(uint8_t data, int len, int spos, int8_t baud, uint8_t e
 	return n;
 }
 
+/// @brief サンプルデータ列を追加
+/// @param[in] data    追加するデータ列
+/// @param[in] len     データ列長さ
+/// @param[in] spos    先頭のサンプリング位置(１データごとに＋１する)
+/// @return 追加したデータ数
+int CSampleArray::AddSamples(const uint8_t *data, int len, int spos)
+{
+#ifdef USE_SAMPLEARRAY_POINTER
+	if (!m_datas) return 0;
+#endif
+	if (len > m_size - m_w_pos) len = m_size - m_w_pos;
+	if (len > 0) CheckSPos(spos);
+	uint32_t attr = CSampleData(0, 0, -1, 0, 0, 0, 0, 0).Attr();
+	for(int n = 0; n < len; n++) {
+		int i = Idx(m_w_pos + n);
+		m_datas[i] = data[n];
+		m_sposs[i] = spos + n;
+		m_attrs[i] = attr;
+	}
+	if (m_bits) {
+		for(int n = 0; n < len; n++) {
+			SetBits(Idx(m_w_pos + n), data[n]);
+		}
+	}
+	m_w_pos += len;
+	m_total_w_pos += len;
+	return len;
+}
+
 /// @brief バッファが書き込めないか
 /// @param[in] offset オフセット
 bool CSampleArray::IsFull(int offset) const
@@ -403,6 +587,13 @@ int CSampleArray::GetTotalWritePos() const
 }
 #endif
 
+/// @brief 別に処理したデータのトータル位置を加算する
+void CSampleArray::AddTotalPos(const CSampleArray &src)
+{
+	m_total_w_pos += src.m_total_w_pos;
+	m_total_r_pos += src.m_total_r_pos;
+}
+
 /// @brief サンプリングレートをセット
 void CSampleArray::SetRate(double val)
 {
@@ -467,12 +658,26 @@ void CSampleArray::Shift()
 }
 
 /// @brief バッファの先頭にシフトする。
+///
+/// リングバッファの場合は先頭位置を移動するだけ
 void CSampleArray::Shift(int offset)
 {
 	if (offset <= 0) return;
-	for(int i=0; i<(m_w_pos - offset); i++) {
-		m_datas[i] = m_datas[i + offset];
+#ifdef USE_SAMPLEARRAY_RING
+	m_head = Idx(offset % m_size);
+#else
+	int len = m_w_pos - offset;
+	if (len > 0) {
+		memmove(&m_datas[0], &m_datas[offset], len * sizeof(uint8_t));
+		memmove(&m_sposs[0], &m_sposs[offset], len * sizeof(int));
+		memmove(&m_attrs[0], &m_attrs[offset], len * sizeof(uint32_t));
+		if (m_bits) {
+			for(int i=0; i<len; i++) {
+				SetBits(i, m_datas[i]);
+			}
+		}
 	}
+#endif
 	m_w_pos -= offset;
 	if (m_w_pos < 0) m_w_pos = 0;
 //	for(int i=m_w_pos; i<m_size; i++) {
@@ -495,6 +700,7 @@ void CSampleArray::Revert()
 
 	m_w_pos = 0;
 	m_r_pos = 0;
+	m_spos_sorted = true;
 }
 
 /// @brief 比較
@@ -512,7 +718,7 @@ int CSampleArray::Compare(int offset, const CSampleArray &dst, int dst_offset, i
 		cmp = -1;
 	} else {
 		for(int n = 0; n < len; n++) {
-			cmp = ((int)dst.m_datas[dst_offset + n].Data() - (int)m_datas[offset + n].Data());
+			cmp = ((int)dst.m_datas[dst.Idx(dst_offset + n)] - (int)m_datas[Idx(offset + n)]);
 			if (cmp != 0) break;
 		}
 	}
@@ -530,9 +736,14 @@ int CSampleArray::Compare(int offset, const uint8_t *ptn, int len)
 	if (offset + len > m_w_pos) {
 		cmp = 1;
 	} else {
-		for(int n = 0; n < len; n++) {
-			cmp = ((int)ptn[n] - (int)m_datas[offset + n].Data());
-			if (cmp != 0) break;
+		// 配列の末尾で折り返す場合は分けて比較
+		int n = 0;
+		while(n < len && cmp == 0) {
+			int i = Idx(offset + n);
+			int seg = m_size - i;
+			if (seg > len - n) seg = len - n;
+			cmp = memcmp(&ptn[n], &m_datas[i], seg);
+			n += seg;
 		}
 	}
 	return cmp > 0 ? 1 : cmp < 0 ? -1 : 0;
@@ -554,13 +765,28 @@ int CSampleArray::CompareRead(int offset, const uint8_t *ptn, int len)
 /// @return 見つかった場合 (offset)を基準とした位置 <0:なし
 int CSampleArray::Find(int offset, const uint8_t *ptn, int len)
 {
+	if (len <= 0) {
+		return (offset <= m_w_pos ? 0 : -1);
+	}
 	int idx = -1;
 	int tail = m_w_pos - len;
-	for(int pos = offset; pos <= tail; pos++) {
+	int pos = offset;
+	while(pos <= tail) {
+		// 先頭バイトが一致する位置まで飛ばす
+		int i = Idx(pos);
+		int seg = m_size - i;
+		if (seg > tail - pos + 1) seg = tail - pos + 1;
+		const uint8_t *p = (const uint8_t *)memchr(&m_datas[i], ptn[0], seg);
+		if (!p) {
+			pos += seg;
+			continue;
+		}
+		pos += (int)(p - &m_datas[i]);
 		if (Compare(pos, ptn, len) == 0) {
 			idx = pos - offset;
 			break;
 		}
+		pos++;
 	}
 	return idx;
 }
@@ -574,12 +800,137 @@ int CSampleArray::FindRead(int offset, const uint8_t *ptn, int len)
 	return Find(m_r_pos + offset, ptn, len);
 }
 
+/// @brief 複数パターンのうち最初に一致するデータ位置をさがす
+///
+/// 全パターンを並行してShift-Or法で照合する
+///
+/// @param[in]  offset 比較を開始するオフセット
+/// @param[in]  ptns   パターン
+/// @param[out] num    一致したパターン番号(同じ位置なら番号の小さいほう)
+/// @return 見つかった場合 (offset)を基準とした位置 <0:なし
+int CSampleArray::Find(int offset, const CMultiPattern &ptns, int &num)
+{
+	if (ptns.m_binary && m_bits) {
+		// '0','1'だけのパターンはビットプレーンで照合
+		return FindBits(offset, ptns, num);
+	}
+
+	uint32_t states[CMultiPattern::MAX_PATTERNS];
+	int best_pos = -1;
+	num = -1;
+
+	for(int k=0; k<ptns.m_num; k++) {
+		states[k] = ~(uint32_t)0;
+	}
+	for(int pos = offset; pos < m_w_pos; pos++) {
+		if (best_pos >= 0 && pos - ptns.m_max_len + 1 > best_pos) {
+			// これ以上前から始まるパターンはない
+			break;
+		}
+		uint8_t c = m_datas[Idx(pos)];
+		for(int k=0; k<ptns.m_num; k++) {
+			states[k] = (states[k] << 1) | ptns.m_masks[k][c];
+			if ((states[k] & ((uint32_t)1 << (ptns.m_len[k] - 1))) == 0) {
+				// 一致
+				int start = pos - ptns.m_len[k] + 1;
+				if (best_pos < 0 || start < best_pos || (start == best_pos && k < num)) {
+					best_pos = start;
+					num = k;
+				}
+			}
+		}
+	}
+	return (best_pos >= 0 ? best_pos - offset : -1);
+}
+/// @brief 複数パターンのうち最初に一致するデータ位置をビットプレーン上でさがす
+///
+/// 32か所の開始位置をまとめて照合する
+///
+/// @param[in]  offset 比較を開始するオフセット
+/// @param[in]  ptns   パターン('0','1'のみ)
+/// @param[out] num    一致したパターン番号(同じ位置なら番号の小さいほう)
+/// @return 見つかった場合 (offset)を基準とした位置 <0:なし
+int CSampleArray::FindBits(int offset, const CMultiPattern &ptns, int &num)
+{
+	uint32_t ones[CMultiPattern::MAX_LENGTH];
+	uint32_t nbins[CMultiPattern::MAX_LENGTH];
+	int best_pos = -1;
+	num = -1;
+
+	for(int top = offset; top + ptns.m_min_len <= m_w_pos; top += 32) {
+		for(int i=0; i<ptns.m_max_len; i++) {
+			ones[i] = GetBits(m_bits, top + i);
+			nbins[i] = GetBits(m_nbins, top + i);
+		}
+		for(int k=0; k<ptns.m_num; k++) {
+			// 開始できる位置の数
+			int limit = m_w_pos - ptns.m_len[k] - top + 1;
+			if (limit <= 0) continue;
+			uint32_t match = (limit < 32 ? ((uint32_t)1 << limit) - 1 : ~(uint32_t)0);
+			for(int i=0; i<ptns.m_len[k] && match != 0; i++) {
+				match &= ~nbins[i];
+				match &= ((ptns.m_bits[k] >> i) & 1) ? ones[i] : ~ones[i];
+			}
+			if (match == 0) continue;
+
+			int j = 0;
+			while((match & 1) == 0) {
+				match >>= 1;
+				j++;
+			}
+			if (best_pos < 0 || top + j < best_pos) {
+				best_pos = top + j;
+				num = k;
+			}
+		}
+		if (best_pos >= 0) break;
+	}
+	return (best_pos >= 0 ? best_pos - offset : -1);
+}
+
+/// @brief リード位置のデータがパターンに一致するか
+/// @param[in] offset リード位置からのオフセット
+/// @param[in] ptns   パターン
+/// @param[in] num    照合するパターン番号
+/// @return true:一致
+bool CSampleArray::MatchRead(int offset, const CMultiPattern &ptns, int num)
+{
+	int pos = m_r_pos + offset;
+	int len = ptns.m_len[num];
+	if (!ptns.m_binary || !m_bits) {
+		return (Compare(pos, ptns.m_ptns[num], len) == 0);
+	}
+	if (pos < 0 || pos + len > m_w_pos) {
+		return false;
+	}
+	uint32_t mask = (len < 32 ? ((uint32_t)1 << len) - 1 : ~(uint32_t)0);
+	if ((GetBits(m_nbins, pos) & mask) != 0) {
+		return false;
+	}
+	return ((GetBits(m_bits, pos) & mask) == ptns.m_bits[num]);
+}
+
+/// @brief リード位置から複数パターンのうち最初に一致するデータ位置をさがす
+/// @param[in]  offset 比較を開始するリード位置からのオフセット
+/// @param[in]  ptns   パターン
+/// @param[out] num    一致したパターン番号
+/// @return 見つかった場合 (ReadPos + offset)を基準とした位置 <0:なし
+int CSampleArray::FindRead(int offset, const CMultiPattern &ptns, int &num)
+{
+	return Find(m_r_pos + offset, ptns, num);
+}
+
 /// @brief 値が指定した範囲で同じデータか
+///
+/// 範囲がライト位置を超える場合は一致しないとする
 bool CSampleArray::SameAsRead(int offset, int len, const CSampleData &dat)
 {
+	if (offset < 0 || offset + len > m_w_pos - m_r_pos) {
+		return false;
+	}
 	bool same = true;
 	for(int i=offset; i<(offset+len); i++) {
-		if (m_datas[m_r_pos + i].Data() != dat.Data()) {
+		if (m_datas[Idx(m_r_pos + i)] != dat.Data()) {
 			same = false;
 			break;
 		}
@@ -587,40 +938,130 @@ bool CSampleArray::SameAsRead(int offset, int len, const CSampleData &dat)
 	return same;
 }
 
+/// @brief spos以上となる最初の位置をさがす
+///
+/// 二分探索はバッファ内のsposが減少しない(m_spos_sortedが立っている)ことが前提。
+/// エンコード時のsposが0のデータや表示中に追加したデータで崩れている場合は
+/// 先頭から順にさがす。
+///
+/// @param[in] offset 検索を開始する位置
+/// @param[in] spos   サンプル位置
+/// @return 位置 なければm_w_pos
+int CSampleArray::LowerSPos(int offset, int spos) const
+{
+	int lo = offset;
+	int hi = m_w_pos;
+	if (!m_spos_sorted) {
+		while(lo < hi && AtSPos(lo) < spos) {
+			lo++;
+		}
+		return lo;
+	}
+	while(lo < hi) {
+		int mid = lo + ((hi - lo) >> 1);
+		if (AtSPos(mid) < spos) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
 /// @brief spos位置をさがす
 int CSampleArray::FindSPos(int offset, int spos)
 {
-	int pos = -1;
-	for(int i=offset; i<m_w_pos; i++) {
-		if (spos <= At(i).SPos()) {
-			pos = i;
-			break;
-		}
-	}
-	return pos;
+	if (offset >= m_w_pos) return -1;
+	int pos = LowerSPos(offset, spos);
+	return (pos < m_w_pos ? pos : -1);
 }
 
 /// @brief 末尾からspos位置をさがす
 int CSampleArray::FindRevSPos(int offset, int spos)
 {
-	int pos = -1;
-	for(int i=(m_w_pos-1); i>=offset; i--) {
-		if (spos > At(i).SPos()) {
-			pos = i + 1;
-			if (pos >= m_w_pos) {
-				pos = m_w_pos - 1;
-			}
-			break;
+	if (offset >= m_w_pos) return -1;
+	int pos;
+	if (m_spos_sorted) {
+		pos = LowerSPos(offset, spos);
+	} else {
+		// 末尾から順にさがす
+		pos = m_w_pos;
+		while(pos > offset && AtSPos(pos - 1) >= spos) {
+			pos--;
+		}
+	}
+	if (pos > offset) {
+		// sposより小さい最後の位置の次
+		if (pos >= m_w_pos) {
+			pos = m_w_pos - 1;
 		}
+		return pos;
 	}
-	if (pos < 0 && m_w_pos > offset + 1) {
-		if (spos == At(offset).SPos()) {
+	pos = -1;
+	if (m_w_pos > offset + 1) {
+		if (spos == AtSPos(offset)) {
 			pos = offset;
 		}
 	}
 	return pos;
 }
 
+/// @brief 波形がゼロをまたぐか
+/// @param[in] prev 前のデータ(-128～127)
+/// @param[in] data データ(-128～127)
+/// @param[in] half 半波の場合true(h -> l も対象)
+static inline bool is_zero_cross(int prev, int data, bool half)
+{
+	return (prev < 0 && data >= 0) || (half && prev > 0 && data <= 0);
+}
+
+/// @brief 波形がゼロをまたぐ位置をさがす
+///
+/// l -> h (半波の場合は h -> l も)になる位置を16サンプルずつまとめて調べる
+///
+/// @param[in] pos  検索を開始する位置
+/// @param[in] prev (pos)の直前のデータ(-128～127)
+/// @param[in] half 半波の場合true
+/// @return 見つかった位置 なければライト位置
+int CSampleArray::FindZeroCross(int pos, int prev, bool half) const
+{
+	if (pos >= m_w_pos) return m_w_pos;
+	if (is_zero_cross(prev, (int)AtData(pos) - 128, half)) return pos;
+
+	int i = pos + 1;
+	while(i < m_w_pos) {
+#ifdef SAMPLEARRAY_USE_SSE2
+		int idx = Idx(i);
+		if (idx > 0 && idx + 16 <= m_size && i + 16 <= m_w_pos) {
+			__m128i cur = _mm_loadu_si128((const __m128i *)&m_datas[idx]);
+			__m128i prv = _mm_loadu_si128((const __m128i *)&m_datas[idx - 1]);
+			// l -> h : 前が128未満で今が128以上
+			int mask = _mm_movemask_epi8(_mm_andnot_si128(prv, cur));
+			if (half) {
+				// h -> l : 前が128より大きく今が128以下
+				__m128i sign = _mm_set1_epi8((char)0x80);
+				__m128i zero = _mm_setzero_si128();
+				__m128i prv_pos = _mm_cmpgt_epi8(_mm_xor_si128(prv, sign), zero);
+				__m128i cur_pos = _mm_cmpgt_epi8(_mm_xor_si128(cur, sign), zero);
+				mask |= _mm_movemask_epi8(_mm_andnot_si128(cur_pos, prv_pos));
+			}
+			if (mask != 0) {
+				while((mask & 1) == 0) {
+					mask >>= 1;
+					i++;
+				}
+				return i;
+			}
+			i += 16;
+			continue;
+		}
+#endif
+		if (is_zero_cross((int)AtData(i - 1) - 128, (int)AtData(i) - 128, half)) return i;
+		i++;
+	}
+	return m_w_pos;
+}
+
 //
 
 CSampleString::CSampleString()
@@ -635,7 +1076,7 @@ CSampleString::CSampleString(const CSampleArray &data, int offset, int len)
 	memset(m_str, 0, len + 1);
 	m_len = len;
 	for(int i=0; i<len; i++) {
-		m_str[i] = (char)data.At(i + offset).Data();
+		m_str[i] = (char)data.AtData(i + offset);
 	}
 }
 CSampleString::~CSampleString()
@@ -665,7 +1106,7 @@ CSampleBytes::CSampleBytes(const CSampleArray &data, int offset, int len)
 	memset(m_str, 0, len + 1);
 	m_len = len;
 	for(int i=0; i<len; i++) {
-		m_str[i] = (uint8_t)data.At(i + offset).Data();
+		m_str[i] = data.AtData(i + offset);
 	}
 }
 CSampleBytes::~CSampleBytes()
@@ -719,6 +1160,8 @@ CarrierData::CarrierData(const CarrierData &src)
 CarrierData::CarrierData(int init_size)
 	: CSampleArray(init_size)
 {
+	// 搬送波のパターン照合に使う
+	UseBits();
 }
 
 //
@@ -8,7 +8,12 @@
 #define _PARSEWAV_DATAS_H_
 
 #include "common.h"
+#include <stddef.h>
 #include <vector>
+#include "paw_defs.h"
+#ifdef PARSEWAV_USE_THREAD
+#include <atomic>
+#endif
 
 
 namespace PARSEWAV
@@ -20,6 +25,11 @@ namespace PARSEWAV
 
 #define USE_SAMPLEDATA_SPOS
 //#define USE_SAMPLEARRAY_POINTER
+/// 配列をリングバッファとして使う(シフト時にコピーしない)
+#define USE_SAMPLEARRAY_RING
+
+/// ビットプレーンの要素数(32ビット単位、末尾の読み出し用に+1)
+#define DATA_BITS_SIZE(size)	(((size) + 31) / 32 + 1)
 
 /// サンプルデータ保持用クラス
 class CSampleData
@@ -44,11 +54,13 @@ public:
 	CSampleData();
 	CSampleData(const CSampleData &src);
 	CSampleData(uint8_t data, int spos, int8_t baud, uint8_t err, uint8_t c_phase, uint8_t c_frip, uint8_t sn_sta, uint8_t user);
+	CSampleData(uint8_t data, int spos, uint32_t attr);
 	CSampleData &operator=(const CSampleData &src);
 	void Clear();
 	uint8_t  Data() const;
 	int      SPos() const;
 	uint32_t DataAll() const;
+	uint32_t Attr() const;
 	int8_t   Baud() const;
 	uint8_t  Err() const;
 	uint8_t  CPhase() const;
@@ -67,19 +79,58 @@ public:
 	void User(uint8_t val);
 };
 
+class CSampleArray;
+
+/// 複数のパターンを１回の走査でさがす(Shift-Or法)
+class CMultiPattern
+{
+public:
+	enum en_multi_pattern {
+		MAX_PATTERNS = 4,	///< パターン数の最大
+		MAX_LENGTH = 32,	///< パターン長さの最大
+	};
+private:
+	int      m_num;							///< パターン数
+	int      m_len[MAX_PATTERNS];			///< パターン長さ
+	int      m_min_len;						///< 最も短いパターンの長さ
+	int      m_max_len;						///< 最も長いパターンの長さ
+	uint32_t m_masks[MAX_PATTERNS][256];	///< 文字ごとのマスク(一致するビットが0)
+	const uint8_t *m_ptns[MAX_PATTERNS];	///< パターン
+	uint32_t m_bits[MAX_PATTERNS];			///< '1'の位置のビットを立てたパターン
+	bool     m_binary;						///< 全パターンが'0'と'1'のみか
+
+public:
+	CMultiPattern();
+	void Set(const struct st_pattern *ptns, int num);
+
+	friend class CSampleArray;
+};
+
 /// サンプルデータ配列クラス
+///
+/// データ、サンプル位置、フラグ類はそれぞれ別の配列で保持する
 class CSampleArray
 {
 protected:
 	int     m_size;			///< 配列サイズ(要素数)
 
 #ifdef USE_SAMPLEARRAY_POINTER
-	CSampleData *m_datas;
+	uint8_t  *m_datas;		///< サンプルデータ
+	int      *m_sposs;		///< サンプル位置
+	uint32_t *m_attrs;		///< フラグ類(データ部分は0)
 #else
-	CSampleData  m_datas[DATA_ARRAY_SIZE];
+	uint8_t   m_datas[DATA_ARRAY_SIZE];	///< サンプルデータ
+	int       m_sposs[DATA_ARRAY_SIZE];	///< サンプル位置
+	uint32_t  m_attrs[DATA_ARRAY_SIZE];	///< フラグ類(データ部分は0)
 #endif
+	uint32_t *m_bits;		///< データが'1'のビットを立てたビットプレーン(UseBits()で作成)
+	uint32_t *m_nbins;		///< データが'0','1'以外のビットを立てたビットプレーン(UseBits()で作成)
 	CSampleData  m_dummy;
 
+#ifdef USE_SAMPLEARRAY_RING
+	int     m_head;			///< 先頭(位置0)の配列上の位置
+#endif
+
 	double  m_rate;
 
 	int     m_w_pos;		///< 書き込んだ位置
@@ -88,31 +139,47 @@ protected:
 	int     m_total_r_pos;	///< 読み込んだ位置の合計
 	int     m_start_pos;	///< 書き込み開始位置（ファイル出力時に使用）
 	bool    m_last_data;	///< 最後のデータ
+	bool    m_spos_sorted;	///< sposが減少せずに並んでいる(二分探索できる)
 
 	CSampleArray(const CSampleArray &src);
 
+	/// 位置から配列上の位置を返す
+	int Idx(int pos) const {
+#ifdef USE_SAMPLEARRAY_RING
+		pos += m_head;
+		return (pos >= m_size ? pos - m_size : pos);
+#else
+		return pos;
+#endif
+	}
+
+	void UseBits();
+	void SetBits(int idx, uint8_t data);
+	void CheckSPos(int spos);
+	uint32_t GetBits(const uint32_t *plane, int pos) const;
+	int FindBits(int offset, const CMultiPattern &ptns, int &num);
+	int LowerSPos(int offset, int spos) const;
+
 public:
 	CSampleArray(int init_size = DATA_ARRAY_SIZE);
 	~CSampleArray();
 
 	void Init();
 	void Clear();
-	const CSampleData &At(int pos = 0) const;
-	const CSampleData &GetRead(int offset = 0) const;
-	const CSampleData &GetWrite(int offset = 0) const;
+	CSampleData At(int pos = 0) const;
+	CSampleData GetRead(int offset = 0) const;
+	CSampleData GetWrite(int offset = 0) const;
+	uint8_t AtData(int pos) const;
+	int     AtSPos(int pos) const;
 
 	int Length() const;
 	int FreeSize() const;
 
-	CSampleData *GetPtr(int pos = 0);
-	CSampleData *GetStartPtr(int offset = 0);
-	CSampleData *GetReadPtr(int offset = 0);
-	CSampleData *GetWritePtr(int offset = 0);
-
 	void Add(const CSampleData &val);
 	void Add(uint8_t data, int spos, int8_t baud = -1, uint8_t err = 0, uint8_t c_phase = 0, uint8_t c_frip = 0, uint8_t sn_sta = 0, uint8_t user = 0);
 	int AddString(const uint8_t *str, int len, int spos, int8_t baud = -1, uint8_t err = 0, uint8_t c_phase = 0, uint8_t c_frip = 0, uint8_t sn_sta = 0, uint8_t user = 0);
 	int Repeat(uint8_t data, int len, int spos, int8_t baud = -1, uint8_t err = 0, uint8_t c_phase = 0, uint8_t c_frip = 0, uint8_t sn_sta = 0, uint8_t user = 0);
+	int AddSamples(const uint8_t *data, int len, int spos);
 	bool IsFull(int offset = 0) const;
 	bool IsTail(int offset = 0) const;
 	int RemainLength();
@@ -127,6 +194,7 @@ public:
 	int GetWritePos() const;
 	int GetTotalReadPos() const;
 //	int GetTotalWritePos() const;
+	void AddTotalPos(const CSampleArray &src);
 	//
 	void SetRate(double val);
 	void SetStartPos(int pos);
@@ -147,10 +215,14 @@ public:
 	int CompareRead(int offset, const uint8_t *dat, int len);
 	int Find(int offset, const uint8_t *ptn, int len);
 	int FindRead(int offset, const uint8_t *ptn, int len);
+	int Find(int offset, const CMultiPattern &ptns, int &num);
+	int FindRead(int offset, const CMultiPattern &ptns, int &num);
+	bool MatchRead(int offset, const CMultiPattern &ptns, int num);
 	bool SameAsRead(int offset, int len, const CSampleData &dat);
 
 	int FindSPos(int offset, int spos);
 	int FindRevSPos(int offset, int spos);
+	int FindZeroCross(int pos, int prev, bool half) const;
 
 };
 
@@ -247,6 +319,77 @@ public:
 	BinaryData(int init_size = DATA_ARRAY_SIZE);
 };
 
+#ifdef PARSEWAV_USE_THREAD
+
+//
+
+/// スレッド間でデータを受け渡すリングバッファ
+///
+/// 書き手と読み手がそれぞれ１つのスレッドの場合のみ使える。ロックは使わない。
+/// 空き(データ)がなければ書いた(読んだ)数が少なくなるので、待つのは呼び出し側で行う。
+template <typename T>
+class CSpscRing
+{
+private:
+	std::vector<T> m_buf;
+	size_t m_mask;
+	std::atomic<size_t> m_w_pos;	///< 書き込んだ位置(書き手のみ更新)
+	std::atomic<size_t> m_r_pos;	///< 読み込んだ位置(読み手のみ更新)
+	std::atomic<bool>   m_closed;	///< 書き手がもう書かない
+
+	CSpscRing(const CSpscRing &src);
+	CSpscRing &operator=(const CSpscRing &src);
+
+public:
+	/// @param[in] size 要素数(2のべき乗に切り上げる)
+	CSpscRing(size_t size) {
+		size_t n = 1;
+		while(n < size) n <<= 1;
+		m_buf.resize(n);
+		m_mask = n - 1;
+		Clear();
+	}
+	/// 空にする(スレッドを開始する前に呼ぶこと)
+	void Clear() {
+		m_w_pos = 0;
+		m_r_pos = 0;
+		m_closed = false;
+	}
+	/// 書く
+	/// @return 書いた数
+	size_t Write(const T *data, size_t num) {
+		size_t w = m_w_pos.load(std::memory_order_relaxed);
+		size_t space = m_buf.size() - (w - m_r_pos.load(std::memory_order_acquire));
+		if (num > space) num = space;
+		for(size_t i = 0; i < num; i++) {
+			m_buf[(w + i) & m_mask] = data[i];
+		}
+		m_w_pos.store(w + num, std::memory_order_release);
+		return num;
+	}
+	/// 読む
+	/// @return 読んだ数
+	size_t Read(T *data, size_t num) {
+		size_t r = m_r_pos.load(std::memory_order_relaxed);
+		size_t avail = m_w_pos.load(std::memory_order_acquire) - r;
+		if (num > avail) num = avail;
+		for(size_t i = 0; i < num; i++) {
+			data[i] = m_buf[(r + i) & m_mask];
+		}
+		m_r_pos.store(r + num, std::memory_order_release);
+		return num;
+	}
+	/// 書き手の終了を通知
+	void Close() { m_closed.store(true, std::memory_order_release); }
+	/// 書き手が終了していて、読めるデータも残っていないか
+	bool IsDrained() const {
+		return m_closed.load(std::memory_order_acquire)
+			&& m_r_pos.load(std::memory_order_relaxed) == m_w_pos.load(std::memory_order_acquire);
+	}
+};
+
+#endif /* PARSEWAV_USE_THREAD */
+
 }; /* namespace PARSEWAV */
 
 #endif /* _PARSEWAV_DATAS_H_ */
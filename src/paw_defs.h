@@ -21,6 +21,14 @@ namespace PARSEWAV
 
 //#define PARSEWAV_FILL_BUFFER	1
 
+/// 入力ファイルをメモリにマップして読む
+#define PARSEWAV_USE_MMAP	1
+
+/// 複数のスレッドで並列に処理する(C++11以降のコンパイラのみ)
+#if (defined(__cplusplus) && __cplusplus >= 201103L) || (defined(_MSC_VER) && _MSC_VER >= 1700)
+#define PARSEWAV_USE_THREAD	1
+#endif
+
 enum enum_process_mode {
 	PROCESS_IDLE = 0,
 	PROCESS_ANALYZING,
@@ -10,10 +10,106 @@
 #include <math.h>
 #include "paw_dft.h"
 
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#define DFT_FIR_X86
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define DFT_FIR_X86
+#endif
+#if defined(DFT_FIR_X86) && defined(__GNUC__)
+#define DFT_FIR_TARGET(name) __attribute__((target(name)))
+#else
+#define DFT_FIR_TARGET(name)
+#endif
+
 
 namespace PARSEWAV
 {
 
+/// @brief 積和(スカラー)
+/// @param[in] x データ
+/// @param[in] k 係数
+/// @param[in] n 長さ(8の倍数)
+static float fir_dot_scalar(const float *x, const float *k, int n)
+{
+	float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	for(int i = 0; i < n; i += 4) {
+		sum[0] += x[i] * k[i];
+		sum[1] += x[i + 1] * k[i + 1];
+		sum[2] += x[i + 2] * k[i + 2];
+		sum[3] += x[i + 3] * k[i + 3];
+	}
+	return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+
+#if defined(DFT_FIR_X86)
+/// @brief 積和(SSE2)
+DFT_FIR_TARGET("sse2")
+static float fir_dot_sse2(const float *x, const float *k, int n)
+{
+	__m128 sum0 = _mm_setzero_ps();
+	__m128 sum1 = _mm_setzero_ps();
+	for(int i = 0; i < n; i += 8) {
+		sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(k + i)));
+		sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(x + i + 4), _mm_loadu_ps(k + i + 4)));
+	}
+	sum0 = _mm_add_ps(sum0, sum1);
+	sum0 = _mm_add_ps(sum0, _mm_movehl_ps(sum0, sum0));
+	sum0 = _mm_add_ss(sum0, _mm_shuffle_ps(sum0, sum0, 1));
+	return _mm_cvtss_f32(sum0);
+}
+
+/// @brief 積和(AVX2)
+DFT_FIR_TARGET("avx2")
+static float fir_dot_avx2(const float *x, const float *k, int n)
+{
+	__m256 sum = _mm256_setzero_ps();
+	for(int i = 0; i < n; i += 8) {
+		sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(k + i)));
+	}
+	__m128 s = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+	s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+	s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+	return _mm_cvtss_f32(s);
+}
+
+/// @brief AVX2が使えるか
+static bool cpu_has_avx2()
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) return false;
+	__cpuid(info, 1);
+	// OSがYMMレジスタを保存するか
+	if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) return false;
+	if ((_xgetbv(0) & 6) != 6) return false;
+	__cpuidex(info, 7, 0);
+	return ((info[1] & (1 << 5)) != 0);
+#else
+	__builtin_cpu_init();
+	return (__builtin_cpu_supports("avx2") != 0);
+#endif
+}
+
+/// @brief SSE2が使えるか
+static bool cpu_has_sse2()
+{
+#if defined(_M_X64) || defined(__x86_64__)
+	return true;
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return ((info[3] & (1 << 26)) != 0);
+#else
+	__builtin_cpu_init();
+	return (__builtin_cpu_supports("sse2") != 0);
+#endif
+}
+#endif /* DFT_FIR_X86 */
+
 /// @brief コンストラクタ
 ///
 Dft::Dft()
@@ -22,6 +118,40 @@ Dft::Dft()
 	memset(h, 0, sizeof(h));
 	amp[0] = 0.0;
 	amp[1] = 0.0;
+	a_max = 0;
+	a_min = 0;
+	taps = 0;
+	method = DFT_METHOD_FFT;
+
+	memset(fir_kernel, 0, sizeof(fir_kernel));
+	fir_taps = 0;
+	memset(fir_buf, 0, sizeof(fir_buf));
+	fir_dot = fir_dot_scalar;
+#if defined(DFT_FIR_X86)
+	if (cpu_has_avx2()) {
+		fir_dot = fir_dot_avx2;
+	} else if (cpu_has_sse2()) {
+		fir_dot = fir_dot_sse2;
+	}
+#endif
+#if defined(USE_DFT_OVERLAP_SAVE)
+	memset(kernel_re, 0, sizeof(kernel_re));
+	memset(kernel_im, 0, sizeof(kernel_im));
+	for(int i = 0; i < DFT_FFT_SIZE / 2; i++) {
+		double rag = -2.0 * M_PI * i / DFT_FFT_SIZE;
+		twiddle_re[i] = cos(rag);
+		twiddle_im[i] = sin(rag);
+	}
+	int bits = 0;
+	while((1 << bits) < DFT_FFT_SIZE) bits++;
+	for(int i = 0; i < DFT_FFT_SIZE; i++) {
+		int r = 0;
+		for(int b = 0; b < bits; b++) {
+			if (i & (1 << b)) r |= (1 << (bits - 1 - b));
+		}
+		bitrev[i] = r;
+	}
+#endif
 }
 
 /// @brief デストラクタ
@@ -35,8 +165,9 @@ Dft::~Dft()
 /// @param[in] type 1:cos 2:sin
 /// @param[in] amp0 1200Hz波の振幅
 /// @param[in] amp1 2400Hz波の振幅
+/// @param[in] method_ 計算方法(en_dft_method)
 ///
-void Dft::Init(double samples, int type, int amp0, int amp1)
+void Dft::Init(double samples, int type, int amp0, int amp1, int method_)
 {
 	int half[2];
 	half[0] = (int)(samples / 2.0);
@@ -61,9 +192,151 @@ void Dft::Init(double samples, int type, int amp0, int amp1)
 	a_max = 0;
 	a_min = 0;
 
+	taps = half[0] * 2;
+	method = method_;
+
+	if (method == DFT_METHOD_FIR) {
+		// 2つの係数に振幅を掛けて1200Hzの窓の先頭にそろえて足しておく
+		memset(fir_kernel, 0, sizeof(fir_kernel));
+		for(n = 0; n < taps; n++) {
+			fir_kernel[n] += (float)(h[0][n] * amp[0] / samples / 1000.0);
+		}
+		for(n = 0; n < half[1] * 2; n++) {
+			fir_kernel[n + half[0] - half[1]] += (float)(h[1][n] * amp[1] / samples / 1000.0);
+		}
+		fir_taps = (taps + 7) & ~7;
+		return;
+	}
+
+#if defined(USE_DFT_OVERLAP_SAVE)
+	// 2つの係数を1つの複素数列にまとめて変換しておく
+	// 1200Hzの窓の先頭にそろえ、実部に1200Hz、虚部に2400Hzの係数を置く
+	memset(buf_re, 0, sizeof(buf_re));
+	memset(buf_im, 0, sizeof(buf_im));
+	for(n = 0; n < taps; n++) {
+		buf_re[n] = h[0][n];
+	}
+	for(n = 0; n < half[1] * 2; n++) {
+		buf_im[n + half[0] - half[1]] = h[1][n];
+	}
+	Fft(buf_re, buf_im, false);
+	// 相関にするため周波数を反転しておく
+	for(n = 0; n < DFT_FFT_SIZE; n++) {
+		int m = (DFT_FFT_SIZE - n) & (DFT_FFT_SIZE - 1);
+		kernel_re[n] = buf_re[m];
+		kernel_im[n] = buf_im[m];
+	}
+#endif
+
 	return;
 }
 
+/// @brief FIR用に元の波形データを連続した領域にコピーする
+/// @param[in] w_data 元の波形データ
+/// @param[in] top    窓の先頭位置
+void Dft::FillFirBlock(WaveData *w_data, int top)
+{
+	int len = DFT_FIR_BLOCK + fir_taps;
+	int w_pos = w_data->GetWritePos();
+	for(int n = 0; n < len; n++) {
+		fir_buf[n] = (top + n < w_pos ? (float)((int)w_data->AtData(top + n) - 128) : 0.0f);
+	}
+}
+
+#if defined(USE_DFT_OVERLAP_SAVE)
+/// @brief 高速フーリエ変換(基数2)
+/// @param[in,out] re 実部
+/// @param[in,out] im 虚部
+/// @param[in] inverse 逆変換か
+void Dft::Fft(double *re, double *im, bool inverse) const
+{
+	int i, j;
+	for(i = 0; i < DFT_FFT_SIZE; i++) {
+		j = bitrev[i];
+		if (i < j) {
+			double t;
+			t = re[i]; re[i] = re[j]; re[j] = t;
+			t = im[i]; im[i] = im[j]; im[j] = t;
+		}
+	}
+	for(int len = 2; len <= DFT_FFT_SIZE; len <<= 1) {
+		int half = len >> 1;
+		int step = DFT_FFT_SIZE / len;
+		for(i = 0; i < DFT_FFT_SIZE; i += len) {
+			for(j = 0; j < half; j++) {
+				double wr = twiddle_re[j * step];
+				double wi = inverse ? -twiddle_im[j * step] : twiddle_im[j * step];
+				int a = i + j;
+				int b = a + half;
+				double tr = re[b] * wr - im[b] * wi;
+				double ti = re[b] * wi + im[b] * wr;
+				re[b] = re[a] - tr;
+				im[b] = im[a] - ti;
+				re[a] += tr;
+				im[a] += ti;
+			}
+		}
+	}
+	if (inverse) {
+		for(i = 0; i < DFT_FFT_SIZE; i++) {
+			re[i] /= DFT_FFT_SIZE;
+			im[i] /= DFT_FFT_SIZE;
+		}
+	}
+}
+
+/// @brief 重畳保存法で1ブロック分を計算
+///
+/// 計算結果はbuf_re(1200Hz),buf_im(2400Hz)に入る。
+/// 窓の先頭が(top + j)の結果がj番目(0 <= j <= DFT_FFT_SIZE - taps)
+///
+/// @param[in] w_data 元の波形データ
+/// @param[in] top    窓の先頭位置
+void Dft::CalcrateBlock(WaveData *w_data, int top)
+{
+	int n;
+	int w_pos = w_data->GetWritePos();
+	for(n = 0; n < DFT_FFT_SIZE; n++) {
+		buf_re[n] = (top + n < w_pos ? (double)((int)w_data->AtData(top + n) - 128) : 0.0);
+		buf_im[n] = 0.0;
+	}
+	Fft(buf_re, buf_im, false);
+	for(n = 0; n < DFT_FFT_SIZE; n++) {
+		double re = buf_re[n] * kernel_re[n] - buf_im[n] * kernel_im[n];
+		double im = buf_re[n] * kernel_im[n] + buf_im[n] * kernel_re[n];
+		buf_re[n] = re;
+		buf_im[n] = im;
+	}
+	Fft(buf_re, buf_im, true);
+}
+#endif
+
+/// @brief 1サンプル分を直接計算
+/// @param[in]  w_data 元の波形データ
+/// @param[in]  p      位置
+/// @param[out] fdata  1200Hz,2400Hzの結果
+void Dft::CalcrateDirect(WaveData *w_data, int p, int *fdata) const
+{
+	int k;
+	int n, n_min, n_max;
+	double dat;
+
+	int half[2];
+	half[0] = (int)(samples / 2.0);
+	half[1] = (int)(samples / 4.0);
+
+	for (k = 0; k < 2; k++) {
+		dat = 0.0;
+		n_min = p - half[k];
+		if (n_min < 0) n_min = 0;
+		n_max = p + half[k];
+		for (n = n_min; n < n_max; n++) {
+			dat += (double)((int)w_data->AtData(n) - 128) * h[k][n - n_min];
+		}
+		fdata[k] = (int)(dat * amp[k] / samples);
+	}
+}
+
 /// @brief フーリエ変換
 /// 1200Hz, 2400Hz,4800Hzの正弦波or余弦波を合成して補正する
 ///
@@ -72,32 +345,44 @@ void Dft::Init(double samples, int type, int amp0, int amp1)
 /// @return 変換したデータ数
 int Dft::Calcrate(WaveData *w_data, WaveData *wc_data)
 {
-	int k;
-	int n, n_min, n_max;
-	int p;
+	int p, p_end;
 	int wc;
-	double dat;
 	int fdata[2];
 
 	int half[2];
 	half[0] = (int)(samples / 2.0);
 	half[1] = (int)(samples / 4.0);
 
-	for (p = w_data->GetReadPos(); p < (w_data->GetWritePos() - half[0]); p++) {
-		for (k = 0; k < 2; k++) {
-			fdata[k] = 0;
+	// 計算済みのブロックの範囲
+	int blk_top = 0;
+	int blk_end = 0;
 
-			dat = 0.0;
-			n_min = p - half[k];
-			if (n_min < 0) n_min = 0;
-			n_max = p + half[k];
-			for (n = n_min; n < n_max; n++) {
-				dat += (double)((int)w_data->At(n).Data() - 128) * h[k][n - n_min];
+	p_end = w_data->GetWritePos() - half[0];
+	for (p = w_data->GetReadPos(); p < p_end; p++) {
+		// 先頭付近は窓がずれるので直接計算する
+		if (method == DFT_METHOD_FIR && p >= half[0]) {
+			if (p >= blk_end) {
+				FillFirBlock(w_data, p - half[0]);
+				blk_top = p;
+				blk_end = p + DFT_FIR_BLOCK;
+			}
+			wc = (int)fir_dot(&fir_buf[p - blk_top], fir_kernel, fir_taps);
+		} else {
+#if defined(USE_DFT_OVERLAP_SAVE)
+			if (method == DFT_METHOD_FFT && p >= half[0] && p >= blk_end && p_end - p >= DFT_FFT_MIN_OUTPUTS) {
+				CalcrateBlock(w_data, p - half[0]);
+				blk_top = p;
+				blk_end = p + DFT_FFT_SIZE - taps + 1;
 			}
-			int idat = (int)(dat * amp[k] / samples);
-			fdata[k] = idat;
+			if (p >= half[0] && p < blk_end) {
+				fdata[0] = (int)(buf_re[p - blk_top] * amp[0] / samples);
+				fdata[1] = (int)(buf_im[p - blk_top] * amp[1] / samples);
+			} else
+#endif
+			CalcrateDirect(w_data, p, fdata);
+
+			wc = (fdata[0] + fdata[1]) / 1000;
 		}
-		wc = (fdata[0] + fdata[1]) / 1000;
 		if (a_max < wc) a_max = wc;
 		if (a_min > wc) a_min = wc;
 		if (wc >= 128) wc = 127;
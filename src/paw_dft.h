@@ -16,6 +16,25 @@
 namespace PARSEWAV
 {
 
+/// 補正をFFT(重畳保存法)で計算する
+#define USE_DFT_OVERLAP_SAVE
+
+/// FFTのサイズ(2のべき乗)
+#define DFT_FFT_SIZE	1024
+/// FFTで計算する最小の出力数(これより少ない場合は直接計算)
+#define DFT_FFT_MIN_OUTPUTS	(DFT_FFT_SIZE / 4)
+
+/// 補正の計算方法
+enum en_dft_method {
+	DFT_METHOD_FFT = 0,	///< FFT(重畳保存法) USE_DFT_OVERLAP_SAVEがなければ直接計算
+	DFT_METHOD_FIR,		///< 1つにまとめた係数のFIR(SIMD) 結果は直接計算と±1の誤差がある
+};
+
+/// FIRの係数の最大長(8の倍数)
+#define DFT_FIR_TAPS_MAX	104
+/// FIRで一度に計算する出力数
+#define DFT_FIR_BLOCK	1024
+
 /// @brief フーリエ変換クラス
 class Dft
 {
@@ -25,6 +44,29 @@ private:
 
 	double amp[2];
 
+	int    taps;							///< 係数の長さ(1200Hz側)
+	int    method;							///< 計算方法(en_dft_method)
+
+	float  fir_kernel[DFT_FIR_TAPS_MAX];	///< 1200Hz,2400Hzの係数に振幅を掛けて合成したもの
+	int    fir_taps;						///< 係数の長さ(8の倍数)
+	float  fir_buf[DFT_FIR_BLOCK + DFT_FIR_TAPS_MAX];	///< 元の波形データ(連続した領域)
+	float  (*fir_dot)(const float *x, const float *k, int n);	///< 積和の計算(CPUにより切り替え)
+
+	void FillFirBlock(WaveData *w_data, int top);
+#if defined(USE_DFT_OVERLAP_SAVE)
+	double kernel_re[DFT_FFT_SIZE];			///< 係数のスペクトル(実部:1200Hz 虚部:2400Hz)
+	double kernel_im[DFT_FFT_SIZE];
+	double twiddle_re[DFT_FFT_SIZE / 2];	///< 回転因子
+	double twiddle_im[DFT_FFT_SIZE / 2];
+	int    bitrev[DFT_FFT_SIZE];			///< ビット反転した位置
+	double buf_re[DFT_FFT_SIZE];			///< 計算用バッファ(実部:1200Hz 虚部:2400Hz)
+	double buf_im[DFT_FFT_SIZE];
+
+	void Fft(double *re, double *im, bool inverse) const;
+	void CalcrateBlock(WaveData *w_data, int top);
+#endif
+	void CalcrateDirect(WaveData *w_data, int p, int *fdata) const;
+
 	//	Buf_t<int> freq_data[2];
 	int a_max;
 	int a_min;
@@ -33,7 +75,7 @@ public:
 	Dft();
 	~Dft();
 
-	void Init(double samples, int type, int amp0, int amp1);
+	void Init(double samples, int type, int amp0, int amp1, int method_ = DFT_METHOD_FFT);
 	int  Calcrate(WaveData *w_data, WaveData *wc_data);
 
 	int GetAmpMax() { return a_max; }
@@ -7,16 +7,25 @@
 ///
 #include "paw_file.h"
 #include "utils.h"
+#include <string.h>
+#ifdef PARSEWAV_USE_MMAP
+#if defined(_WIN32)
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#endif
+#endif
 
 
 namespace PARSEWAV 
 {
 
-static const _TCHAR *c_open_mode[] = {
-	_T("r"),
-	_T("rb"),
-	_T("w"),
-	_T("wb"),
+static const char *c_open_mode[] = {
+	"r",
+	"rb",
+	"w",
+	"wb",
 	NULL
 };
 
@@ -30,7 +39,7 @@ File::File()
 File::~File()
 {
 }
-bool File::Fopen(const wxString &file_name, enum_open_mode mode)
+bool File::Fopen(const std::string &file_name, enum_open_mode mode)
 {
 	Fclose();
 	name = file_name;
@@ -82,15 +91,10 @@ int File::Fputc(int c)
 	if (!fio) return 0;
 	return fputc(c, fio);
 }
-int File::Fputs(const wxString &str)
-{
-	if (!fio) return 0;
-	return _fputts(str.t_str(), fio);
-}
-int File::Fputts(const _TCHAR *str)
+int File::Fputs(const std::string &str)
 {
 	if (!fio) return 0;
-	return _fputts(str, fio);
+	return fputs(str.c_str(), fio);
 }
 long File::Ftell()
 {
@@ -210,6 +214,268 @@ void SamplePosition::SampleRate(double rate)
 InputFile::InputFile()
 	: File(), SamplePosition()
 {
+	m_buf = NULL;
+	m_buf_top = 0;
+	m_buf_len = 0;
+	m_buf_pos = 0;
+	m_file_size = 0;
+
+	m_window = NULL;
+	m_map = NULL;
+	m_attached = false;
+	m_text = false;
+#if defined(_WIN32)
+	m_map_handle = NULL;
+#endif
+}
+InputFile::~InputFile()
+{
+	Fclose();
+	delete [] m_window;
+}
+/// ファイルを開く
+///
+/// バイナリモードでマップできればファイル全体をマップし、
+/// できなければ読み込みウィンドウを使用する
+bool InputFile::Fopen(const std::string &file_name, enum_open_mode mode)
+{
+	Fclose();
+	if (!File::Fopen(file_name, mode)) {
+		return false;
+	}
+	m_text = (mode == READ_ASCII);
+	if (m_text) {
+		m_file_size = CountTextSize();
+	} else {
+		fseek(fio, 0, SEEK_END);
+		m_file_size = ftell(fio);
+		fseek(fio, 0, SEEK_SET);
+	}
+	if (m_file_size < 0) m_file_size = 0;
+
+	m_buf_top = 0;
+	m_buf_pos = 0;
+	m_buf_len = 0;
+
+	if (!m_text && MapFile()) {
+		m_buf = (const uint8_t *)m_map;
+		m_buf_len = (size_t)m_file_size;
+	} else {
+		if (!m_window) m_window = new uint8_t[INPUTFILE_WINDOW_SIZE];
+		m_buf = m_window;
+	}
+	return true;
+}
+/// 読み込み済みのメモリ上の領域をファイルとして扱う
+///
+/// 領域は参照するだけなので、閉じるまで呼び出し元で保持すること
+/// @param[in] data 参照する領域
+/// @param[in] len  領域の長さ
+/// @param[in] type_ ファイル種類
+bool InputFile::Attach(const uint8_t *data, size_t len, enum_file_type type_)
+{
+	Fclose();
+	m_buf = data;
+	m_buf_len = len;
+	m_file_size = (long)len;
+	m_attached = true;
+	type = type_;
+	return true;
+}
+void InputFile::Fclose()
+{
+	UnmapFile();
+	File::Fclose();
+	m_attached = false;
+	m_text = false;
+	m_buf = NULL;
+	m_buf_top = 0;
+	m_buf_len = 0;
+	m_buf_pos = 0;
+	m_file_size = 0;
+}
+/// ファイル全体をメモリにマップする
+/// @return false:マップできない
+bool InputFile::MapFile()
+{
+#ifdef PARSEWAV_USE_MMAP
+	if (!fio || m_file_size <= 0) return false;
+#if defined(_WIN32)
+	HANDLE fh = (HANDLE)_get_osfhandle(_fileno(fio));
+	if (fh == INVALID_HANDLE_VALUE) return false;
+	HANDLE mh = CreateFileMapping(fh, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!mh) return false;
+	void *p = MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0);
+	if (!p) {
+		CloseHandle(mh);
+		return false;
+	}
+	m_map_handle = mh;
+	m_map = p;
+#else
+	void *p = mmap(NULL, (size_t)m_file_size, PROT_READ, MAP_PRIVATE, fileno(fio), 0);
+	if (p == MAP_FAILED) return false;
+	m_map = p;
+#endif
+	return true;
+#else
+	return false;
+#endif
+}
+/// マップを解除する
+void InputFile::UnmapFile()
+{
+#ifdef PARSEWAV_USE_MMAP
+	if (!m_map) return;
+#if defined(_WIN32)
+	UnmapViewOfFile(m_map);
+	CloseHandle((HANDLE)m_map_handle);
+	m_map_handle = NULL;
+#else
+	munmap(m_map, (size_t)m_file_size);
+#endif
+	m_map = NULL;
+#endif
+}
+/// 未読データをウィンドウの先頭に寄せて続きを読み込む
+/// @param[in] len 必要な長さ
+/// @return 現在位置から参照できる長さ(最大でlen)
+size_t InputFile::FillWindow(size_t len)
+{
+	if (!IsReadable()) return 0;
+
+	if (!m_map && !m_attached) {
+		size_t remain = 0;
+		if (m_buf_pos < m_buf_len) {
+			remain = m_buf_len - m_buf_pos;
+			memmove(m_window, &m_window[m_buf_pos], remain);
+		} else if (m_buf_pos > m_buf_len) {
+			// 読み込み範囲の外を指している
+			if (m_text) {
+				// テキストモードは変換後の位置でシークできないので読み飛ばす
+				size_t skip = m_buf_pos - m_buf_len;
+				while(skip > 0) {
+					size_t n = fread(m_window, sizeof(uint8_t), skip < INPUTFILE_WINDOW_SIZE ? skip : INPUTFILE_WINDOW_SIZE, fio);
+					if (n == 0) break;
+					skip -= n;
+				}
+			} else {
+				fseek(fio, m_buf_top + (long)m_buf_pos, SEEK_SET);
+			}
+		}
+		m_buf_top += (long)m_buf_pos;
+		m_buf_pos = 0;
+		m_buf_len = remain + fread(&m_window[remain], sizeof(uint8_t), INPUTFILE_WINDOW_SIZE - remain, fio);
+	}
+
+	size_t avail = (m_buf_pos < m_buf_len ? m_buf_len - m_buf_pos : 0);
+	return (len < avail ? len : avail);
+}
+/// テキストモードで読んだ場合のサイズ(改行コード変換後)
+/// @note ファイル位置は先頭になる
+long InputFile::CountTextSize()
+{
+	if (!fio) return 0;
+	if (!m_window) m_window = new uint8_t[INPUTFILE_WINDOW_SIZE];
+	long size = 0;
+	size_t n;
+	while((n = fread(m_window, sizeof(uint8_t), INPUTFILE_WINDOW_SIZE, fio)) > 0) {
+		size += (long)n;
+	}
+	fseek(fio, 0, SEEK_SET);
+	return size;
+}
+/// バッファが空の時の1バイト読み込み
+/// @return EOF:ファイル終端
+int InputFile::FgetcSlow()
+{
+	if (!IsReadable()) return 0;
+	if (FillWindow(1) == 0) return EOF;
+	return m_buf[m_buf_pos++];
+}
+size_t InputFile::Fread(void *buf, size_t buf_siz, size_t cnt)
+{
+	if (!IsReadable() || buf_siz == 0) return 0;
+	uint8_t *dst = (uint8_t *)buf;
+	size_t total = buf_siz * cnt;
+	size_t done = 0;
+	while(done < total) {
+		size_t len = total - done;
+		const uint8_t *src = Fmap(len);
+		if (len == 0) break;
+		memcpy(&dst[done], src, len);
+		Fskip(len);
+		done += len;
+	}
+	return done / buf_siz;
+}
+/// ファイル位置を移動
+/// ウィンドウ内なら読み直さない
+/// テキストモードで前に戻る場合は先頭から読み直す
+int InputFile::Fseek(long offset, int origin)
+{
+	if (!IsReadable()) return 0;
+	long pos;
+	switch(origin) {
+	case SEEK_SET:
+		pos = offset;
+		break;
+	case SEEK_CUR:
+		pos = Ftell() + offset;
+		break;
+	case SEEK_END:
+		pos = m_file_size + offset;
+		break;
+	default:
+		return -1;
+	}
+	if (pos < 0) return -1;
+
+	if (m_map || m_attached || (pos >= m_buf_top && (m_text || pos <= m_buf_top + (long)m_buf_len))) {
+		m_buf_pos = (size_t)(pos - m_buf_top);
+		return 0;
+	}
+	if (m_text) {
+		m_buf_top = 0;
+		m_buf_pos = (size_t)pos;
+		m_buf_len = 0;
+		return fseek(fio, 0, SEEK_SET);
+	}
+	m_buf_top = pos;
+	m_buf_pos = 0;
+	m_buf_len = 0;
+	return fseek(fio, pos, SEEK_SET);
+}
+long InputFile::Ftell()
+{
+	if (!IsReadable()) return 0;
+	return m_buf_top + (long)m_buf_pos;
+}
+/// ファイル全体にある改行コード(CR,LF)の数を数える
+/// @note ファイル位置は先頭になる
+int InputFile::CountLineBreaks()
+{
+	int count = 0;
+	Fseek(0, SEEK_SET);
+	for(;;) {
+		size_t len = INPUTFILE_WINDOW_SIZE;
+		const uint8_t *p = Fmap(len);
+		if (len == 0) break;
+		for(size_t i=0; i<len; i++) {
+			count += (p[i] == '\r' || p[i] == '\n') ? 1 : 0;
+		}
+		Fskip(len);
+	}
+	Fseek(0, SEEK_SET);
+	return count;
+}
+/// ファイルサイズを返す
+/// @note ファイル位置は先頭になる
+int InputFile::GetSize()
+{
+	if (!IsReadable()) return 0;
+	Fseek(0, SEEK_SET);
+	return (int)m_file_size;
 }
 /// ファイル先頭にセット
 void InputFile::First()
@@ -222,14 +488,128 @@ void InputFile::First()
 OutputFile::OutputFile()
 	: File()
 {
+	m_buf = new uint8_t[OUTPUTFILE_BUFFER_SIZE];
+	m_buf_len = 0;
+	m_buf_pos = 0;
+	m_mem = NULL;
+}
+OutputFile::~OutputFile()
+{
+	Fclose();
+	delete [] m_buf;
+}
+bool OutputFile::Fopen(const std::string &file_name, enum_open_mode mode)
+{
+	Fclose();
+	return File::Fopen(file_name, mode);
+}
+/// ファイルの代わりにメモリに出力する
+/// @param[in] mem 出力先 書いたデータは末尾に追加する
+void OutputFile::OpenMemory(std::vector<uint8_t> *mem)
+{
+	Fclose();
+	m_mem = mem;
+}
+void OutputFile::Fclose()
+{
+	Flush();
+	m_mem = NULL;
+	File::Fclose();
+}
+/// バッファにたまったデータをファイルに出力する
+/// メモリに出力する場合はバッファ内で戻った位置は保持しない
+void OutputFile::Flush()
+{
+	if (fio && m_buf_len > 0) {
+		fwrite(m_buf, sizeof(uint8_t), m_buf_len, fio);
+		if (m_buf_pos < m_buf_len) {
+			// バッファ内で戻っていた場合
+			fseek(fio, (long)m_buf_pos - (long)m_buf_len, SEEK_CUR);
+		}
+	} else if (m_mem && m_buf_len > 0) {
+		m_mem->insert(m_mem->end(), m_buf, m_buf + m_buf_len);
+	}
+	m_buf_len = 0;
+	m_buf_pos = 0;
+}
+/// バッファがいっぱいの時の1バイト書き込み
+int OutputFile::FputcSlow(int c)
+{
+	Flush();
+	m_buf[m_buf_pos++] = (uint8_t)c;
+	if (m_buf_len < m_buf_pos) m_buf_len = m_buf_pos;
+	return (c & 0xff);
+}
+/// データ列を書く
+/// @param[in] buf 書き込むデータ
+/// @param[in] len 長さ(バイト)
+/// @return 書き込んだ長さ
+size_t OutputFile::Write(const void *buf, size_t len)
+{
+	const uint8_t *src = (const uint8_t *)buf;
+	size_t done = 0;
+	while(done < len) {
+		size_t n = len - done;
+		uint8_t *dst = Freserve(n);
+		memcpy(dst, &src[done], n);
+		Fcommit(n);
+		done += n;
+	}
+	return done;
+}
+size_t OutputFile::Fwrite(const void *buf, size_t buf_siz, size_t cnt)
+{
+	if (!IsWritable()) return 0;
+	Write(buf, buf_siz * cnt);
+	return cnt;
+}
+int OutputFile::Vfprintf(const char *format, va_list ap)
+{
+	Flush();
+	return File::Vfprintf(format, ap);
+}
+int OutputFile::Fputs(const std::string &str)
+{
+	Flush();
+	return File::Fputs(str);
+}
+/// ファイル位置を移動
+/// バッファ内の移動ならファイルに出力しない
+int OutputFile::Fseek(long offset, int origin)
+{
+	if (!IsWritable()) return 0;
+	if (origin == SEEK_CUR) {
+		long pos = (long)m_buf_pos + offset;
+		if (pos >= 0 && pos <= (long)m_buf_len) {
+			m_buf_pos = (size_t)pos;
+			return 0;
+		}
+	}
+	Flush();
+	if (!fio) return -1;
+	return fseek(fio, offset, origin);
+}
+long OutputFile::Ftell()
+{
+	if (!IsWritable()) return 0;
+	if (!fio) return (long)m_mem->size() + (long)m_buf_pos;
+	return ftell(fio) + (long)m_buf_pos;
 }
 
 int OutputFile::WriteData(CSampleArray &data)
 {
 	int len = 0;
-	for(int i=data.GetStartPos(); i<data.GetWritePos(); i++) {
-		Fputc(data.At(i).Data());
-		len++;
+	int pos = data.GetStartPos();
+	int end = data.GetWritePos();
+	while(pos < end) {
+		size_t n = (size_t)(end - pos);
+		uint8_t *p = Freserve(n);
+		for(size_t i=0; i<n; i++) {
+			p[i] = data.At(pos + (int)i).Data();
+		}
+		Fcommit(n);
+		pos += (int)n;
+		len += (int)n;
 	}
 	data.SetStartPos(data.GetWritePos());
 	return len;
@@ -240,8 +620,9 @@ int OutputFile::WriteData(CSampleArray &data)
 LogFile::LogFile()
 	: File()
 {
+	m_logbuf = NULL;
 }
-bool LogFile::Open(const wxString &file_name)
+bool LogFile::Open(const std::string &file_name)
 {
 	return Fopen(file_name, WRITE_ASCII);
 }
@@ -249,12 +630,9 @@ void LogFile::Close()
 {
 	Fclose();
 }
-void LogFile::Write(const wxString &buff, int crlf)
+void LogFile::Write(const std::string &buff, int crlf)
 {
 	UTILS::write_log(buff, crlf, fio, m_logbuf);
 }
 
-/// ログファイル実体
-LogFile gLogFile;
-
 }; /* namespace PARSEWAV */
@@ -11,32 +11,35 @@
 #include "common.h"
 #include <stdio.h>
 #include "paw_defs.h"
-#include <wx/string.h>
-#if defined(_WIN32)
-#include <tchar.h>
-#else
-#include "tchar.h"
-#endif
 #include "paw_datas.h"
+#include <vector>
+#include <string>
 
 
 namespace PARSEWAV 
 {
 
+/// 入力ファイルの読み込みウィンドウサイズ(マップできない場合に使用)
+#define INPUTFILE_WINDOW_SIZE	(1024 * 1024)
+/// 出力ファイルの書き込みバッファサイズ
+#define OUTPUTFILE_BUFFER_SIZE	(1024 * 1024)
+
 /// ファイルラッパ
+///
+/// 派生クラスで読み書きをバッファ経由にするため、入出力は仮想関数にする
 class File
 {
 protected:
 	FILE *fio;
 	enum_file_type type;
 
-	wxString name;
+	std::string name;	///< ファイル名 (UTF-8)
 
 	int opened_file_count;
 
 public:
 	File();
-	~File();
+	virtual ~File();
 
 	enum enum_open_mode {
 		READ_ASCII = 0,
@@ -45,32 +48,31 @@ public:
 		WRITE_BINARY,
 	};
 
-	bool Fopen(const wxString &file_name, enum_open_mode mode);
-	void Fclose();
+	virtual bool Fopen(const std::string &file_name, enum_open_mode mode);
+	virtual void Fclose();
 
-	int Fgetc();
-	size_t Fread(void *buf, size_t buf_siz, size_t cnt);
-	size_t Fwrite(const void *buf, size_t buf_siz, size_t cnt);
+	virtual int Fgetc();
+	virtual size_t Fread(void *buf, size_t buf_siz, size_t cnt);
+	virtual size_t Fwrite(const void *buf, size_t buf_siz, size_t cnt);
 	int Fprintf(const char *format, ...);
-	int Vfprintf(const char *format, va_list ap);
+	virtual int Vfprintf(const char *format, va_list ap);
 
-	int Fseek(long offset, int origin);
+	virtual int Fseek(long offset, int origin);
 
-	int Fputc(int c);
-	int Fputs(const wxString &str);
-	int Fputts(const _TCHAR *str);
+	virtual int Fputc(int c);
+	virtual int Fputs(const std::string &str);
 
-	long Ftell();
-	int GetSize();
+	virtual long Ftell();
+	virtual int GetSize();
 
 	bool IsOpened() { return (fio != NULL); }
 	int  OpenedFileCount();
 
 	FILE *Fio() { return fio; }
 	enum_file_type GetType() { return type; }
-	const wxString &GetName() const { return name; }
+	const std::string &GetName() const { return name; }
 	void SetType(enum_file_type val) { type = val; }
-	void SetName(const wxString &str) { name = str; }
+	void SetName(const std::string &str) { name = str; }
 };
 
 /// サンプル位置保持用
@@ -115,19 +117,127 @@ public:
 };
 
 /// 入力ファイルクラス
+///
+/// ファイル全体をメモリにマップするか、大きなウィンドウに読み込んで
+/// バッファから直接データを返す。ファイル位置はウィンドウ内で管理する。
+/// テキストモードで開いた場合は改行コードを変換させるためマップせず、
+/// ウィンドウに読み込んだ変換後のデータで位置を管理する。
 class InputFile : public File, public SamplePosition
 {
+private:
+	const uint8_t *m_buf;	///< 参照中のデータ(マップした領域 or ウィンドウ)
+	long     m_buf_top;		///< m_buf先頭のファイル位置
+	size_t   m_buf_len;		///< m_buf内の有効データ長
+	size_t   m_buf_pos;		///< m_buf内の現在位置
+	long     m_file_size;	///< ファイルサイズ
+
+	uint8_t *m_window;		///< 読み込みウィンドウ
+	void    *m_map;			///< マップした領域
+	bool     m_attached;	///< 他で読み込んだ領域を参照している
+	bool     m_text;		///< テキストモードで開いている
+#if defined(_WIN32)
+	void    *m_map_handle;
+#endif
+
+	bool   MapFile();
+	void   UnmapFile();
+	size_t FillWindow(size_t len);
+	long   CountTextSize();
+	int    FgetcSlow();
+	bool   IsReadable() const { return (fio != NULL || m_attached); }
+
 public:
 	InputFile();
+	virtual ~InputFile();
+
+	virtual bool Fopen(const std::string &file_name, enum_open_mode mode);
+	bool Attach(const uint8_t *data, size_t len, enum_file_type type_);
+	virtual void Fclose();
+
+	/// 1バイト読む
+	virtual int Fgetc() {
+		if (m_buf_pos < m_buf_len) return m_buf[m_buf_pos++];
+		return FgetcSlow();
+	}
+	virtual size_t Fread(void *buf, size_t buf_siz, size_t cnt);
+	virtual int Fseek(long offset, int origin);
+	virtual long Ftell();
+	virtual int GetSize();
+
+	/// 現在位置のデータを直接参照する
+	/// @param[in,out] len 入力:必要な長さ 出力:参照できる長さ
+	/// @return データへのポインタ
+	const uint8_t *Fmap(size_t &len) {
+		if (m_buf_pos + len <= m_buf_len) return &m_buf[m_buf_pos];
+		len = FillWindow(len);
+		return &m_buf[m_buf_pos];
+	}
+	/// Fmapで参照したデータを読み飛ばす
+	void Fskip(size_t len) { m_buf_pos += len; }
+
+	bool IsMapped() const { return (m_map != NULL); }
+
+	int CountLineBreaks();
 
 	void First();
 };
 
 /// 出力ファイルクラス
+///
+/// 書き込みはいったんバッファにためて、Flush()でまとめてファイルに出力する。
+/// バッファ内の位置へのシークはバッファ上で行う。
+/// OpenMemory()で開いた場合はファイルの代わりにメモリに追加していく。
 class OutputFile : public File
 {
+private:
+	uint8_t *m_buf;		///< 書き込みバッファ
+	size_t   m_buf_len;	///< バッファ内の有効データ長
+	size_t   m_buf_pos;	///< バッファ内の書き込み位置
+	std::vector<uint8_t> *m_mem;	///< メモリに出力する場合の出力先
+
+	int FputcSlow(int c);
+	bool IsWritable() const { return (fio != NULL || m_mem != NULL); }
+
 public:
 	OutputFile();
+	virtual ~OutputFile();
+
+	virtual bool Fopen(const std::string &file_name, enum_open_mode mode);
+	void OpenMemory(std::vector<uint8_t> *mem);
+	virtual void Fclose();
+	void Flush();
+
+	/// 1バイト書く
+	virtual int Fputc(int c) {
+		if (m_buf_pos < OUTPUTFILE_BUFFER_SIZE) {
+			m_buf[m_buf_pos++] = (uint8_t)c;
+			if (m_buf_len < m_buf_pos) m_buf_len = m_buf_pos;
+			return (c & 0xff);
+		}
+		return FputcSlow(c);
+	}
+	size_t Write(const void *buf, size_t len);
+	virtual size_t Fwrite(const void *buf, size_t buf_siz, size_t cnt);
+	virtual int Vfprintf(const char *format, va_list ap);
+	virtual int Fputs(const std::string &str);
+	virtual int Fseek(long offset, int origin);
+	virtual long Ftell();
+
+	/// 書き込みバッファを直接参照する
+	/// @param[in,out] len 入力:書き込みたい長さ 出力:書き込める長さ
+	/// @return 書き込み位置へのポインタ
+	uint8_t *Freserve(size_t &len) {
+		if (m_buf_pos + len > OUTPUTFILE_BUFFER_SIZE) {
+			Flush();
+			if (len > OUTPUTFILE_BUFFER_SIZE) len = OUTPUTFILE_BUFFER_SIZE;
+		}
+		return &m_buf[m_buf_pos];
+	}
+	/// Freserveで書き込んだ長さだけ位置を進める
+	void Fcommit(size_t len) {
+		m_buf_pos += len;
+		if (m_buf_len < m_buf_pos) m_buf_len = m_buf_pos;
+	}
 
 	int WriteData(CSampleArray &data);
 };
@@ -136,23 +246,20 @@ public:
 class LogFile : public File
 {
 private:
-	wxString *m_logbuf;
+	std::string *m_logbuf;
 
 public:
 	LogFile();
 
-	bool Open(const wxString &file_name);
+	bool Open(const std::string &file_name);
 	void Close();
 
-	void Write(const wxString &buff, int crlf);
+	void Write(const std::string &buff, int crlf);
 
-	void SetLogBuf(wxString *logbuf) { m_logbuf = logbuf; }
+	void SetLogBuf(std::string *logbuf) { m_logbuf = logbuf; }
 
 };
 
-/// ログファイル
-extern LogFile gLogFile;
-
 }; /* namespace PARSEWAV */
 
 #endif /* _PARSEWAV_FILE_H_ */
@@ -0,0 +1,82 @@
+﻿/// @file paw_frontend.h
+///
+/// @brief 変換処理から呼び出す表示・入力用のインタフェース
+///
+/// @author Copyright (c) Sasaji. All rights reserved.
+///
+#ifndef _PARSEWAV_FRONTEND_H_
+#define _PARSEWAV_FRONTEND_H_
+
+#include "common.h"
+#include <string>
+#include "paw_param.h"
+
+class PwErrInfo;
+
+namespace PARSEWAV
+{
+
+/// @brief 変換処理からの進捗表示や問い合わせを受けるクラス
+///
+/// GUI版・コマンドライン版はこれを継承して必要な関数を上書きする。
+/// 既定の実装は何も表示せず、設定済みのパラメータをそのまま使う。
+class Frontend
+{
+public:
+	Frontend() {}
+	virtual ~Frontend() {}
+
+	/// 進捗表示開始 type 0:変換中 1:解析中
+	virtual void InitProgress(int /* type */, int /* min_val */, int /* max_val */) {}
+	/// 進捗を更新する時期か
+	virtual bool NeedSetProgress() const { return false; }
+	/// 進捗を更新 @return true:中断要求あり
+	virtual bool SetProgress(int /* val */) { return false; }
+	/// 進捗を更新 (num / div) @return true:中断要求あり
+	virtual bool SetProgress(int /* num */, int /* div */) { return false; }
+	/// 進捗を進める @return true:中断要求あり
+	virtual bool IncProgress() { return false; }
+	/// 進捗を表示 @return true:中断要求あり
+	virtual bool ViewProgress() { return false; }
+	/// 進捗表示終了
+	virtual void EndProgress() {}
+
+	/// @brief 実ファイルの種類を選択
+	///
+	/// @param[in,out] param     種類
+	/// @param[in]     name      内部ファイル名の元にする名前 (UTF-8) 空なら変更しない
+	/// @param[in]     init_data 新しく開いたファイルか
+	/// @return true:OK false:キャンセル
+	virtual bool SelectRfType(RfTypeParam &param, const std::string &name, bool /* init_data */) {
+		if (!name.empty() && param.GetRfName().empty()) {
+			std::string nname;
+			RfTypeParam::TrimName(name, nname);
+			param.SetRfName(nname);
+		}
+		return (param.GetRfDataFileType() == 0 || RfTypeParam::CheckName(param.GetRfName()));
+	}
+
+	/// @brief マシン語の開始アドレスを入力
+	///
+	/// @param[in,out] param               アドレス
+	/// @param[in]     hide_no_header_info ヘッダなし情報を表示しないか
+	/// @return true:OK false:キャンセル
+	virtual bool InputMAddress(MAddressParam &param, bool /* hide_no_header_info */) {
+		if (!param.Valid() && !param.Submitted()) {
+			return false;
+		}
+		if (!param.IncludeHeader()) {
+			param.SetDataSize(param.GetFileSize());
+		}
+		param.Valid(true);
+		param.Submitted(true);
+		return true;
+	}
+
+	/// エラー・警告メッセージを表示
+	virtual void ShowMessage(const PwErrInfo & /* info */) {}
+};
+
+}; /* namespace PARSEWAV */
+
+#endif /* _PARSEWAV_FRONTEND_H_ */
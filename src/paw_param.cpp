@@ -6,6 +6,7 @@
 /// @date   2011.7.1
 ///
 #include "paw_param.h"
+#include <string.h>
 
 
 namespace PARSEWAV
@@ -41,9 +42,11 @@ void Parameter::Clear()
 	reverse = false;
 
 	half_wave = true;
+	demod_type = 0;
 	correct_type = 0;
 	correct_amp[0] = 1000;
 	correct_amp[1] = 1000;
+	correct_calc = 0;
 
 	baud = 0;
 	auto_baud = true;
@@ -53,11 +56,13 @@ void Parameter::Clear()
 
 	sample_rate = 3;	// 48000
 	sample_bits = 0;	// 8bit
+	decimate_rate = 0;	// auto
 
 	file_split = 0;
 	del_mhead = 0;
 
 	out_err_ser = false;
+	decode_threads = 0;
 }
 
 void Parameter::SetFrequency(int magnify)
@@ -81,6 +86,17 @@ int Parameter::GetSampleRate(void) const
 	return GetSampleRate(sample_rate);
 }
 
+/// 高いレートの入力を間引いた後の最低レート
+/// @return サンプルレート 0:自動(FSK速度で決める)
+int Parameter::GetDecimateRate(void) const
+{
+	if (decimate_rate > 0 && decimate_rate <= 4) {
+		return c_sample_rate[decimate_rate - 1];
+	} else {
+		return 0;
+	}
+}
+
 int Parameter::GetBaseFreq(void) const
 {
 	return 1200 * (fsk_speed + 1);
@@ -133,9 +149,108 @@ void TempParameter::Clear()
 	half_wave = true;
 	auto_baud = true;
 	reverse = false;
+	demod_type = 0;
 	correct_type = 0;
 	view_progbox = true;
 	debug_log = 0;
 }
 
+//////////////////////////////////////////////////////////////////////
+
+RfTypeParam::RfTypeParam()
+{
+	Initialize();
+}
+
+void RfTypeParam::Initialize()
+{
+	data_format = 0;
+	data_type   = 0;
+	sel_file_type = 0;
+
+	rf_name.clear();
+	rf_name_real[0] = '\0';
+}
+
+int RfTypeParam::GetRfDataName(uint8_t *name) const
+{
+	strncpy((char *)name, rf_name.c_str(), 8);
+
+	for(int i=0; i<8; i++) {
+		if (name[i] == 0) name[i] = 0x20;
+	}
+	return 0;
+}
+
+const uint8_t *RfTypeParam::GetRfDataName()
+{
+	memset(rf_name_real, 0, sizeof(rf_name_real));
+	GetRfDataName(rf_name_real);
+	return rf_name_real;
+}
+
+int RfTypeParam::GetRfDataNameLen() const
+{
+	return 8;
+}
+
+bool RfTypeParam::CheckName(const std::string &str)
+{
+	bool rc = true;
+	size_t len;
+
+	len = str.length();
+
+	if (len <= 0) {
+			rc = false;
+	}
+	for(size_t i=0; i < len; i++) {
+		uint8_t c = (uint8_t)str[i];
+		if (c < ' ' || c == '(' || c == ')' || c == ':') {
+			rc = false;
+			break;
+		}
+	}
+	return rc;
+}
+
+void RfTypeParam::TrimName(const std::string &str, std::string &nstr)
+{
+	size_t len;
+
+	nstr.clear();
+
+	len = str.length();
+	for(size_t i=0; i < len && i < 8; ) {
+		uint8_t c = (uint8_t)str[i];
+		if (c < ' ' || c == '.' || c == '(' || c == ')' || c == ':') {
+			break;
+		}
+		// UTF-8の途中で切らない
+		size_t clen = (c >= 0xf0 ? 4 : (c >= 0xe0 ? 3 : (c >= 0xc0 ? 2 : 1)));
+		if (i + clen > 8 || i + clen > len) {
+			break;
+		}
+		nstr.append(str, i, clen);
+		i += clen;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+
+MAddressParam::MAddressParam()
+{
+	Initialize();
+}
+
+void MAddressParam::Initialize()
+{
+	p.start_addr = 0;
+	p.exec_addr  = 0;
+	p.data_size  = 0;
+	p.file_size  = 0;
+	p.valid      = false;
+	submitted    = false;
+}
+
 }; /* namespace PARSEWAV */
@@ -8,6 +8,9 @@
 #ifndef _PARSEWAV_PARAM_H_
 #define _PARSEWAV_PARAM_H_
 
+#include "common.h"
+#include <string>
+#include "paw_defs.h"
 
 namespace PARSEWAV
 {
@@ -24,15 +27,19 @@ private:
 	bool auto_baud;	///< auto judgement of baud rate
 	int  word_select;	///< bit structure of one data
 	bool half_wave;	///< parse half wave
+	int  demod_type;	///< 0:zero cross 1:correlation (I/Q)
 	int  correct_type;	///< 0:none 1: cos wave 2:sin wave
 	int  correct_amp[2];	///< amplitude of correct wave
+	int  correct_calc;	///< 補正の計算方法 0:FFT(重畳保存法) 1:FIR(SIMD)
 	int  debug_log;
 	int  sample_bits;	///< 0:8bits 1:16bits
 	int  sample_rate;	///< 0:11025  1:22050  2:44100  3:48000
+	int  decimate_rate;	///< 高いレートの入力を間引いた後の最低レート 0:auto 1:11025 2:22050 3:44100 4:48000
 	int  file_split;
 	int  del_mhead;
 	int  chg_gap_size;
 	bool out_err_ser;
+	int  decode_threads;	///< 区間に分けてデコードするスレッド数 0:自動 1:分けない
 
 public:
 	Parameter();
@@ -41,12 +48,15 @@ public:
 
 	void SetSampleRatePos(int value)	{ sample_rate = value; }
 	void SetSampleBitsPos(int value)	{ sample_bits = value; }
+	void SetDecimateRatePos(int value)	{ decimate_rate = value; }
 	void SetBaud(int value)			{ baud = value; }
 	void SetAutoBaud(bool value)	{ auto_baud = value; }
 	void SetReverseWave(bool value)	{ reverse = value; }
 	void SetHalfWave(bool value)		{ half_wave = value; }
+	void SetDemodType(int value)	{ demod_type = value; }
 	void SetCorrectType(int value)	{ correct_type = value; }
 	void SetCorrectAmp(int num, int value) { correct_amp[num] = value; }
+	void SetCorrectCalc(int value)	{ correct_calc = value; }
 	void SetFskSpeed(int value)		{ fsk_speed = value; }
 	void SetFreq(int num, int value) { freq[num] = value; }
 	void SetFrequency(int magnify);
@@ -57,17 +67,22 @@ public:
 	void SetChangeGapSize(int value) { chg_gap_size = value; }
 	void SetOutErrSerial(bool val)	{ out_err_ser = val; }
 	void SetDebugMode(int value)	{ debug_log = value; }
+	void SetDecodeThreads(int value)	{ decode_threads = value; }
 
 	static int GetSampleRate(int val);
 	int GetSampleRate(void) const;
 	int GetSampleRatePos(void) const	{ return sample_rate; }
 	int GetSampleBitsPos(void) const	{ return sample_bits; }
+	int GetDecimateRatePos(void) const	{ return decimate_rate; }
+	int GetDecimateRate(void) const;
 	int GetBaud(void) const			{ return baud; }
 	bool GetAutoBaud(void) const		{ return auto_baud; }
 	bool GetReverseWave(void) const	{ return reverse; }
 	bool GetHalfWave(void) const		{ return half_wave; }
+	int GetDemodType(void) const	{ return demod_type; }
 	int GetCorrectType(void) const	{ return correct_type; }
 	int GetCorrectAmp(int num) const { return correct_amp[num]; }
+	int GetCorrectCalc(void) const	{ return correct_calc; }
 	int GetFskSpeed(void) const		{ return fsk_speed; }
 	int GetFreq(int num) const		{ return freq[num]; }
 	int	GetRange(int num) const		{ return range[num]; }
@@ -77,6 +92,7 @@ public:
 	int GetChangeGapSize(void) const { return chg_gap_size; }
 	bool GetOutErrSerial() const	{ return out_err_ser; }
 	int GetDebugMode(void) const	{ return debug_log; }
+	int GetDecodeThreads(void) const	{ return decode_threads; }
 	int GetBaseFreq(void) const;
 
 	int GetWordAllBitLen(void) const;
@@ -92,6 +108,7 @@ private:
 	bool half_wave;
 	bool auto_baud;
 	bool reverse;	///< reverse wave
+	int  demod_type;	///< 0:zero cross 1:correlation (I/Q)
 	int  correct_type;	///< 0:none 1: cos wave 2:sin wave
 	bool view_progbox;
 	int debug_log;
@@ -103,6 +120,7 @@ public:
 	void SetAutoBaud(bool value)	{ auto_baud = value; }
 	void SetHalfWave(bool value)	{ half_wave = value; }
 	void SetReverseWave(bool value)	{ reverse = value; }
+	void SetDemodType(int value)	{ demod_type = value; }
 	void SetCorrectType(int value)	{ correct_type = value; }
 	void SetViewProgBox(bool value)	{ view_progbox = value; }
 	void SetDebugMode(int value)	{ debug_log = value; }
@@ -110,11 +128,76 @@ public:
 	bool GetAutoBaud(void) const	{ return auto_baud; }
 	bool GetHalfWave(void) const	{ return half_wave; }
 	bool GetReverseWave(void) const	{ return reverse; }
+	int GetDemodType(void) const	{ return demod_type; }
 	int GetCorrectType(void) const	{ return correct_type; }
 	bool GetViewProgBox(void) const	{ return view_progbox; }
 	int GetDebugMode(void) const	{ return debug_log; }
 };
 
+/// 実ファイル種類選択パラメータ
+class RfTypeParam
+{
+private:
+	uint8_t  data_format;
+	uint8_t  data_type;
+
+	std::string rf_name;	///< 内部ファイル名 (UTF-8)
+	uint8_t rf_name_real[12];
+
+	int sel_file_type;
+
+public:
+	RfTypeParam();
+	~RfTypeParam() {}
+
+	void Initialize();
+
+	int		GetRfDataName(uint8_t *) const;
+	const uint8_t *GetRfDataName();
+	int		GetRfDataNameLen() const;
+	const std::string &GetRfName() const { return rf_name; }
+	uint8_t	GetRfDataFormat() const { return data_format; }
+	uint8_t	GetRfDataType() const { return data_type; }
+	int     GetRfDataFileType() const { return sel_file_type; }
+	void    SetRfDataFormat(uint8_t val) { data_format = val; }
+	void    SetRfDataType(uint8_t val) { data_type = val; }
+	void    SetRfName(const std::string &val) { rf_name = val; }
+	void    SetRfDataFileType(int val) { sel_file_type = val; }
+
+	/// 内部ファイル名として使える文字か
+	static bool CheckName(const std::string &str);
+	/// ファイル名から内部ファイル名を作る
+	static void TrimName(const std::string &str, std::string &nstr);
+};
+
+/// マシン語開始アドレス設定パラメータ
+class MAddressParam
+{
+private:
+	maddress_t p;
+	bool  submitted;
+
+public:
+	MAddressParam();
+	~MAddressParam() {}
+
+	void Initialize();
+
+	long GetStartAddr() const { return p.start_addr; }
+	void SetStartAddr(long val) { p.start_addr = val; }
+	long GetExecAddr() const { return p.exec_addr; }
+	void SetExecAddr(long val) { p.exec_addr = val; }
+	long GetDataSize() const { return p.data_size; }
+	void SetDataSize(long val) { p.data_size = val; }
+	long GetFileSize() const { return p.file_size; }
+	void SetFileSize(long val) { p.file_size = val; }
+	bool IncludeHeader() const { return p.include_header; }
+	void IncludeHeader(bool val) { p.include_header = val; }
+	bool Valid() const { return p.valid; }
+	void Valid(bool val) { p.valid = val; }
+	bool Submitted() const { return submitted; }
+	void Submitted(bool val) { submitted = val; }
+};
 
 }; /* namespace PARSEWAV */
 
@@ -132,6 +132,7 @@ ParserBase::ParserBase()
 	tmp_param = NULL;
 	infile = NULL;
 	mile_stone = NULL;
+	logfile = NULL;
 }
 
 void ParserBase::Init(enum_process_mode process_mode_, TempParameter &tmp_param_, MileStoneList &mile_stone_)
@@ -151,4 +152,9 @@ void ParserBase::SetInputFile(InputFile &infile_)
 	infile = &infile_;
 }
 
+void ParserBase::SetLogFile(LogFile &logfile_)
+{
+	logfile = &logfile_;
+}
+
 }; /* namespace PARSEWAV */
@@ -90,6 +90,8 @@ protected:
 	InputFile *infile;
 	/// 一定間隔で位置を覚えておく
 	MileStoneList *mile_stone;
+	/// デバッグログ
+	LogFile *logfile;
 
 public:
 	ParserBase();
@@ -97,6 +99,7 @@ public:
 
 	void SetParameter(Parameter &param_);
 	void SetInputFile(InputFile &infile_);
+	void SetLogFile(LogFile &logfile_);
 
 };
 
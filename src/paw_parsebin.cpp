@@ -6,6 +6,7 @@
 /// @date   2019.08.01
 ///
 #include "paw_parsebin.h"
+#include <string.h>
 #include "paw_file.h"
 #include "utils.h"
 
@@ -88,6 +89,16 @@ void BinaryParser::ClearResult()
 	rep4_itm = NULL;
 }
 
+/// @brief 後に続く区間を別に解析した結果を加える
+///
+/// @param[in,out] src 後の区間を解析したもの 結果は移すので空になる
+void BinaryParser::MergeResult(BinaryParser &src)
+{
+	rep4.insert(rep4.end(), src.rep4.begin(), src.rep4.end());
+	src.rep4.clear();
+	src.rep4_itm = NULL;
+}
+
 /// @brief デコード時の初期処理
 ///
 void BinaryParser::InitForDecode(enum_process_mode process_mode_, TempParameter &tmp_param_, MileStoneList &mile_stone_)
@@ -198,7 +209,7 @@ int BinaryParser::FindHeader(BinaryData *b_data)
 /// @param[in]     outsext   分割時の出力ファイル拡張子
 /// @param[in,out] outsfile  分割時の出力ファイル
 /// @return -1:フラッシュが必要 0>サイズ
-int BinaryParser::ParseNameSection(BinaryData *b_data, OutputFile &outfile, const wxString &outsfileb, const wxString &outsext, OutputFile &outsfile)
+int BinaryParser::ParseNameSection(BinaryData *b_data, OutputFile &outfile, const std::string &outsfileb, const std::string &outsext, OutputFile &outsfile)
 {
 	int rc = 0;
 	int data_len = 0;
@@ -249,8 +260,8 @@ int BinaryParser::ParseNameSection(BinaryData *b_data, OutputFile &outfile, cons
 	// 実ファイルを分割して出力する時 open file
 	if (outfile.GetType() == FILETYPE_REAL && outfile.GetType() >= infile->GetType()) {
 		if (param->GetFileSplit()) {
-			wxString outsfilen = outsfileb;
-			outsfilen += wxString::Format(_T("_%03d"), (int)rep4.size());
+			std::string outsfilen = outsfileb;
+			outsfilen += UTILS::str_format("_%03d", (int)rep4.size());
 			outsfilen += outsext;
 			outsfile.Fopen(outsfilen, File::WRITE_BINARY);
 		}
@@ -558,93 +569,93 @@ int BinaryParser::WriteL3Data(OutputFile &outfile, BinaryData *b_data)
 }
 
 /// @brief デコード時のレポート
-void BinaryParser::DecordingReport(BinaryData *b_data, wxString &buff, wxString *logbuf)
+void BinaryParser::DecordingReport(std::string &buff, std::string *logbuf)
 {
 	int spd = param->GetFskSpeed();
 
-	gLogFile.SetLogBuf(logbuf);
+	logfile->SetLogBuf(logbuf);
 
-	buff = _T(" [ l3 -> real data ]");
-	gLogFile.Write(buff, 1);
+	buff = " [ l3 -> real data ]";
+	logfile->Write(buff, 1);
 
 	if (rep4.empty()) {
-		buff = _T(" data cannot parse.");
-		gLogFile.Write(buff, 1);
+		buff = " data cannot parse.";
+		logfile->Write(buff, 1);
 	} else {
 		int idx = 1;
 		std::vector<REPORT4 *>::iterator itm = rep4.begin();
 		while ( itm != rep4.end() ) {
-			buff.Printf(_T("%03d:"), idx);
-			gLogFile.Write(buff, 1);
+			UTILS::str_printf(buff, "%03d:", idx);
+			logfile->Write(buff, 1);
 			if ((*itm)->GetFlags() & 1) {
-				buff = _T(" dataname: \"");
+				buff = " dataname: \"";
 				buff += UTILS::conv_internal_name((*itm)->GetSaveDataName());
-				buff += _T("\"   [");
+				buff += "\"   [";
 				switch((*itm)->GetSaveDataName(8)) {
 					case 0:
-						buff += _T("BASIC");
+						buff += "BASIC";
 						break;
 					case 1:
-						buff += _T("DATA");
+						buff += "DATA";
 						break;
 					case 2:
-						buff += _T("Machine");
+						buff += "Machine";
 						break;
 					default:
-						buff += _T("?");
+						buff += "?";
 						break;
 				}
 				switch((*itm)->GetSaveDataName(9)) {
 					case 0:
-						buff += _T(" - Binary save");
+						buff += " - Binary save";
 						break;
 					case 0xff:
-						buff += _T(" - Ascii save");
+						buff += " - Ascii save";
 						break;
 					default:
-						buff += _T(" ?");
+						buff += " ?";
 						break;
 				}
-				buff += _T("]");
+				buff += "]";
 
 				int idx = ((*itm)->GetBaud());
 				if (idx >= 0 && idx < 4) {
-					buff += wxString::Format(_T(" (%4dbaud)"), (int)c_baud_rate[idx] * (spd + 1));
+					buff += UTILS::str_format(" (%4dbaud)", (int)c_baud_rate[idx] * (spd + 1));
 				} else {
-					buff += _T(" (----baud)");
+					buff += " (----baud)";
 				}
-				gLogFile.Write(buff, 1);
+				logfile->Write(buff, 1);
 			} else {
-				buff = _T(" no filename");
-				gLogFile.Write(buff, 1);
-				buff = _T(" header section not found.");
-				gLogFile.Write(buff, 1);
+				buff = " no filename";
+				logfile->Write(buff, 1);
+				buff = " header section not found.";
+				logfile->Write(buff, 1);
 			}
 			if (((*itm)->GetFlags() & 2) == 0) {
-				buff = _T(" data section not found.");
-				gLogFile.Write(buff, 1);
+				buff = " data section not found.";
+				logfile->Write(buff, 1);
 			}
 			if (((*itm)->GetFlags() & 4) == 0) {
-				buff = _T(" footer section not found.");
-				gLogFile.Write(buff, 1);
+				buff = " footer section not found.";
+				logfile->Write(buff, 1);
 			}
 
 			if ((*itm)->GetChksumErrorNum() <= 0) {
-				buff = _T(" check sum ok.");
+				buff = " check sum ok.";
 			} else {
-				buff = _T(" check sum error exists.");
+				buff = " check sum error exists.";
 			}
-			gLogFile.Write(buff, 1);
+			logfile->Write(buff, 1);
 			for(int i=0; i<(*itm)->GetChksumErrorNum(); i++) {
 				int start_pos, end_pos;
 				(*itm)->GetChksumError(i, start_pos, end_pos);
-				buff.Printf(_T(" pos: %d-%d (")
+				UTILS::str_printf(buff, " pos: %d-%d ("
 					,start_pos, end_pos);
 				buff += UTILS::get_time_str(infile->CalcrateSampleUSec(start_pos));
-				buff += _T("-");
+				buff += "-";
 				buff += UTILS::get_time_str(infile->CalcrateSampleUSec(end_pos));
-				buff += _T(")");
-				gLogFile.Write(buff, 1);
+				buff += ")";
+				logfile->Write(buff, 1);
 			}
 
 			itm++;
@@ -652,7 +663,7 @@ void BinaryParser::DecordingReport(BinaryData *b_data, wxString &buff, wxString
 		}
 	}
 
-	gLogFile.Write(_T(""), 1);
+	logfile->Write("", 1);
 }
 
 }; /* namespace PARSEWAV */
@@ -11,7 +11,7 @@
 #include "common.h"
 #include <stdio.h>
 #include <vector>
-#include <wx/string.h>
+#include <string>
 #include "paw_parse.h"
 #include "errorinfo.h"
 #include "paw_defs.h"
@@ -79,6 +79,7 @@ public:
 	~BinaryParser();
 
 	void ClearResult();
+	void MergeResult(BinaryParser &src);
 	void InitForDecode(enum_process_mode process_mode_, TempParameter &tmp_param_, MileStoneList &mile_stone_);
 	void InitForEncode(enum_process_mode process_mode_, TempParameter &tmp_param_, MileStoneList &mile_stone_);
 
@@ -88,7 +89,7 @@ public:
 	uint8_t GetL3Sample();
 
 	int FindHeader(BinaryData *b_data);
-	int ParseNameSection(BinaryData *b_data, OutputFile &outfile, const wxString &outsfileb, const wxString &outsext, OutputFile &outsfile);
+	int ParseNameSection(BinaryData *b_data, OutputFile &outfile, const std::string &outsfileb, const std::string &outsext, OutputFile &outsfile);
 	int ParseBodySection(BinaryData *b_data, OutputFile &outfile, OutputFile &outsfile);
 	int ParseFooterSection(BinaryData *b_data, OutputFile &outfile, OutputFile &outsfile);
 
@@ -104,7 +105,7 @@ public:
 
 	int WriteL3Data(OutputFile &outfile, BinaryData *b_data);
 
-	void DecordingReport(BinaryData *b_data, wxString &buff, wxString *logbuf);
+	void DecordingReport(std::string &buff, std::string *logbuf);
 
 	uint8_t GetSaveDataFormat() { return save_data_name[8]; }
 	bool IsMachineData() { return (save_data_name[8] == 2); }
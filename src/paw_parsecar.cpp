@@ -6,6 +6,7 @@
 /// @date   2019.08.01
 ///
 #include "paw_parsecar.h"
+#include <string.h>
 #include "paw_defs.h"
 #include "paw_file.h"
 #include "utils.h"
@@ -70,6 +71,15 @@ CarrierParser::CarrierParser()
 	phase = 0;
 	frip = 0;
 	baud24_frip = 0;
+
+	enc_word_select = -1;
+	enc_baud = -1;
+	enc_ptn_len = 0;
+
+	edge_matcher.Set(carrier_edge_pattern, 4);
+	for(int i=0; i<4; i++) {
+		carrier_matcher[i].Set(carrier_pattern[i], 4);
+	}
 }
 
 void CarrierParser::ClearResult()
@@ -79,6 +89,14 @@ void CarrierParser::ClearResult()
 #endif
 }
 
+/// @brief 後に続く区間を別に解析した結果を加える
+void CarrierParser::MergeResult(const CarrierParser &src)
+{
+#ifdef PARSEWAV_USE_REPORT
+	rep2.Add(src.rep2);
+#endif
+}
+
 /// @brief デコード時の初期処理
 ///
 void CarrierParser::InitForDecode(enum_process_mode process_mode_, TempParameter &tmp_param_, MileStoneList &mile_stone_)
@@ -107,26 +125,15 @@ void CarrierParser::InitForEncode(enum_process_mode process_mode_, TempParameter
 	prev_data = 0;
 	prev_width = 0;
 	over_pos = 0;
+
+	enc_word_select = -1;
 }
 
 /// @brief l3cファイル(搬送波ビットデータ)からサイズを計算
 int CarrierParser::CalcL3CSize(InputFile &file)
 {
-	int l;
-	int sample_num = 0;
-	int file_size = file.GetSize();
-	file.Fseek(0, SEEK_SET);
-	while(file_size > 0) {
-		file_size--;
-
-		l = file.Fgetc();
-		l &= 0xff;
-
-		if (l == '\r' || l == '\n') {
-			continue;
-		}
-		sample_num++;
-	}
+	// 改行以外のデータ数
+	int sample_num = file.GetSize() - file.CountLineBreaks();
 	file.SampleNum(sample_num);
 	file.Fseek(0, SEEK_SET);
 	return sample_num;
@@ -252,7 +259,7 @@ int CarrierParser::Decode(CarrierData *c_data, SerialData *s_data, int8_t baud,
 ///   
 int CarrierParser::FindStartCarrierBit(CarrierData *c_data, SerialData *s_data, int8_t baud, int &step)
 {
-	int pos1[4];
+	int pos1;
 	int pos = -1;
 	int idx_ptn = (baud & 3);
 	int best_num = -1;
@@ -266,14 +273,10 @@ int CarrierParser::FindStartCarrierBit(CarrierData *c_data, SerialData *s_data,
 
 	// 2400ボーの時はエッジを探す
 	if (idx_ptn == IDX_PTN_2400) {
-		for(i=0; i<4; i++) {
-			pos1[i]=c_data->FindRead(0, carrier_edge_pattern[i].ptn, carrier_edge_pattern[i].len);
-		}
-		for(i=0; i<4; i++) {
-			if (pos1[i] >= 0 && best_pos > pos1[i]) {
-				best_pos = pos1[i];
-				best_num = i;
-			}
+		pos1 = c_data->FindRead(0, edge_matcher, i);
+		if (pos1 >= 0 && best_pos > pos1) {
+			best_pos = pos1;
+			best_num = i;
 		}
 		if (best_num >= 0) {
 			// あり
@@ -306,14 +309,10 @@ int CarrierParser::FindStartCarrierBit(CarrierData *c_data, SerialData *s_data,
 
 	// 一致するパターンを探す
 	if (best_num < 0) {
-		for(i=0; i<4; i++) {
-			pos1[i]=c_data->FindRead(0, carrier_pattern[idx_ptn][i].ptn, carrier_pattern[idx_ptn][i].len);
-		}
-		for(i=0; i<4; i++) {
-			if (pos1[i] >= 0 && best_pos > pos1[i]) {
-				best_pos = pos1[i];
-				best_num = i;
-			}
+		pos1 = c_data->FindRead(0, carrier_matcher[idx_ptn], i);
+		if (pos1 >= 0 && best_pos > pos1) {
+			best_pos = pos1;
+			best_num = i;
 		}
 		if (best_num >= 0) {
 			// あり
@@ -344,13 +343,13 @@ int CarrierParser::FindStartCarrierBit(CarrierData *c_data, SerialData *s_data,
 		// データ有り
 		if (tmp_param->GetDebugMode() > 1) {
 			// デバッグログ
-			gLogFile.Fprintf("p2 fst c:%12d(%s) pos:%d frip:%d ("
+			logfile->Fprintf("p2 fst c:%12d(%s) pos:%d frip:%d ("
 				, samples[0].SPos()
-				, UTILS::get_time_cstr(infile->CalcrateSampleUSec(samples[0].SPos()))
+				, UTILS::get_time_str(infile->CalcrateSampleUSec(samples[0].SPos())).c_str()
 				, best_pos, frip);
 			CSampleString str(*c_data, c_data->GetReadPos() + best_pos, pos - best_pos);
-			gLogFile.Fputs(str.Get());
-			gLogFile.Fputs(")\n");
+			logfile->Fputs(str.Get());
+			logfile->Fputs(")\n");
 		}
 
 		for(int i=0; i<samples_len; i++) {
@@ -410,17 +409,15 @@ int CarrierParser::DecodeToSerial(CarrierData *c_data, SerialData *s_data, int8_
 	int len;
 
 	CSampleData sample;
-	const uint8_t *ptn;
 
 
 	len = carrier_pattern[idx_ptn][frip].len;
-	ptn = carrier_pattern[idx_ptn][frip].ptn;
 	sample.Set(c_data->GetRead());
 	sample.Baud(baud);
 	sample.CPhase(phase);
 	sample.CFrip(frip);
 
-	if (c_data->CompareRead(0, ptn, len) == 0) {	// 0
+	if (c_data->MatchRead(0, carrier_matcher[idx_ptn], frip)) {	// 0
 		// 0
 		sample.Data('0');
 
@@ -433,8 +430,7 @@ int CarrierParser::DecodeToSerial(CarrierData *c_data, SerialData *s_data, int8_
 	if (pos < 0 && idx_ptn == IDX_PTN_2400) {
 		// 2400 ボーのときはfripして再度0を検索
 		len = carrier_pattern[idx_ptn][1 - frip].len;
-		ptn = carrier_pattern[idx_ptn][1 - frip].ptn;
-		if (c_data->CompareRead(0, ptn, len) == 0) {	// 0
+		if (c_data->MatchRead(0, carrier_matcher[idx_ptn], 1 - frip)) {	// 0
 			sample.Data('0');
 
 			pos = len;
@@ -446,8 +442,7 @@ int CarrierParser::DecodeToSerial(CarrierData *c_data, SerialData *s_data, int8_
 	}
 	if (pos < 0) {
 		len = carrier_pattern[idx_ptn][2 + frip].len;
-		ptn = carrier_pattern[idx_ptn][2 + frip].ptn;
-		if (c_data->CompareRead(0, ptn, len) == 0)	{ // 1
+		if (c_data->MatchRead(0, carrier_matcher[idx_ptn], 2 + frip))	{ // 1
 			// 1
 			sample.Data('1');
 
@@ -481,13 +476,13 @@ int CarrierParser::DecodeToSerial(CarrierData *c_data, SerialData *s_data, int8_
 
 		if (tmp_param->GetDebugMode() > 1) {
 			// デバッグログ
-			gLogFile.Fprintf("p2 c2s c:%12d(%s) error ("
+			logfile->Fprintf("p2 c2s c:%12d(%s) error ("
 				, sample.SPos()
-				, UTILS::get_time_cstr(infile->CalcrateSampleUSec(sample.SPos()))
+				, UTILS::get_time_str(infile->CalcrateSampleUSec(sample.SPos())).c_str()
 			);
 			CSampleString str(*c_data, c_data->GetReadPos(), c_data->RemainLength() >= len ? len : c_data->RemainLength());
-			gLogFile.Fputs(str.Get());
-			gLogFile.Fputs(")\n");
+			logfile->Fputs(str.Get());
+			logfile->Fputs(")\n");
 		}
 	}	
 
@@ -618,6 +613,69 @@ int CarrierParser::EncodeToCarrier(SerialData *s_data, CarrierData *c_data)
 	return len;
 }
 
+/// @brief バイナリデータ1バイトを搬送波ビットデータに変換する
+///
+/// シリアル変換を経由せずテーブルからまとめて追加する
+///
+/// @param[in] bin_data バイナリデータ1バイト
+/// @param[out] c_data 搬送波データ
+/// @return 搬送波データに変換した長さ
+int CarrierParser::EncodeToCarrier(uint8_t bin_data, CarrierData *c_data)
+{
+	int word_select = param->GetWordSelect();
+	int baud = (param->GetBaud() & 3);
+
+	if (enc_word_select != word_select || enc_baud != baud) {
+		MakeEncodeTable(word_select, baud);
+	}
+	int len = c_data->AddString(&enc_ptns[baud24_frip][bin_data * enc_ptn_len], enc_ptn_len, 0);
+	baud24_frip = enc_next_frip[baud24_frip][bin_data];
+
+	return len;
+}
+
+/// @brief バイナリデータ→搬送波ビットデータ変換テーブルを作成する
+///
+/// 搬送波ビット列はFSK速度によらないので、ワードセレクトとボーレートごとに作る。
+/// フリップ有無は2400ボーの時のみ変化する。
+///
+/// @param[in] word_select ワードセレクト
+/// @param[in] baud        ボーレート(0-3)
+void CarrierParser::MakeEncodeTable(int word_select, int baud)
+{
+	uint8_t bits[SERIAL_BYTE_BITS_MAX];
+	int bits_len = SerialParser::MakeSerialBits(0, word_select, bits);
+	int plen = carrier_pattern[baud][0].len;
+
+	enc_ptn_len = bits_len * plen;
+	for(int f = 0; f < 2; f++) {
+		enc_ptns[f].resize(256 * enc_ptn_len);
+		for(int i = 0; i < 256; i++) {
+			uint8_t *ptn = &enc_ptns[f][i * enc_ptn_len];
+			int fr = f;
+			SerialParser::MakeSerialBits((uint8_t)i, word_select, bits);
+			for(int n = 0; n < bits_len; n++) {
+				const st_pattern *pattern;
+				if (bits[n] & 0x01) {
+					// 1
+					pattern = &carrier_pattern[baud][2 + fr];
+				} else {
+					// 0
+					pattern = &carrier_pattern[baud][fr];
+					if (baud == IDX_PTN_2400) {
+						// 2400ボーの時 fripする
+						fr = (1 - fr);
+					}
+				}
+				memcpy(&ptn[n * plen], pattern->ptn, plen);
+			}
+			enc_next_frip[f][i] = (uint8_t)fr;
+		}
+	}
+	enc_word_select = word_select;
+	enc_baud = baud;
+}
+
 /// @brief L3Cデータをファイルに出力
 ///
 /// @param[in,out] outfile ファイル
@@ -696,32 +754,32 @@ int CarrierParser::WriteL3CData(OutputFile &outfile, CarrierData *c_data, int wi
 
 #ifdef PARSEWAV_USE_REPORT
 /// @brief デコード時のレポート
-void CarrierParser::DecordingReport(CarrierData *c_data, wxString &buff, wxString *logbuf)
+void CarrierParser::DecordingReport(CarrierData *c_data, std::string &buff, std::string *logbuf)
 {
 //	int spd = param->GetFskSpeed();
 
-	gLogFile.SetLogBuf(logbuf);
+	logfile->SetLogBuf(logbuf);
 
-	buff = _T(" [ l3c -> l3b, t9x ]");
-	gLogFile.Write(buff, 1);
+	buff = " [ l3c -> l3b, t9x ]";
+	logfile->Write(buff, 1);
 
 	if (c_data->GetTotalReadPos() > 0) {
-		buff.Printf(_T(" %d / %d errors. (%.2f%%)"),rep2.GetErrorNum(), c_data->GetTotalReadPos(), (rep2.GetErrorNum() * 100.0 / c_data->GetTotalReadPos()));
-		gLogFile.Write(buff, 1);
+		UTILS::str_printf(buff, " %d / %d errors. (%.2f%%)",rep2.GetErrorNum(), c_data->GetTotalReadPos(), (rep2.GetErrorNum() * 100.0 / c_data->GetTotalReadPos()));
+		logfile->Write(buff, 1);
 	}
 
-	gLogFile.Write(_T(""), 1);
+	logfile->Write("", 1);
 }
 
 /// @brief エンコード時のレポート
-void CarrierParser::EncordingReport(CarrierData *c_data, wxString &buff, wxString *logbuf)
+void CarrierParser::EncordingReport(std::string &buff)
 {
-	buff = _T(" [ l3b, t9x -> l3c ]");
-	gLogFile.Write(buff, 1);
-	buff.Printf(_T(" %4d Baud"),(int)c_baud_rate[param->GetBaud()] * (param->GetFskSpeed() + 1));
-	gLogFile.Write(buff, 1);
+	buff = " [ l3b, t9x -> l3c ]";
+	logfile->Write(buff, 1);
+	UTILS::str_printf(buff, " %4d Baud",(int)c_baud_rate[param->GetBaud()] * (param->GetFskSpeed() + 1));
+	logfile->Write(buff, 1);
 
-	gLogFile.Write(_T(""), 1);
+	logfile->Write("", 1);
 }
 #endif
 
@@ -10,12 +10,14 @@
 
 #include "common.h"
 #include <stdio.h>
-#include <wx/string.h>
+#include <vector>
+#include <string>
 #include "paw_parse.h"
 #include "errorinfo.h"
 #include "paw_datas.h"
 #include "paw_param.h"
 #include "paw_file.h"
+#include "paw_parseser.h"
 
 
 namespace PARSEWAV 
@@ -32,6 +34,7 @@ public:
 	~REPORT2() {}
 
 	void Clear();
+	void Add(const REPORT2 &src) { error_num += src.error_num; }
 	void IncErrorNum() { error_num++; }
 	int GetErrorNum() const { return error_num; }
 };
@@ -49,6 +52,17 @@ private:
 	/// 2400ボーエンコード時のフリップ有無
 	int baud24_frip;
 
+	/// エンコード用テーブル
+	int enc_word_select;	///< テーブルを作成した時のワードセレクト -1:未作成
+	int enc_baud;			///< テーブルを作成した時のボーレート
+	int enc_ptn_len;		///< 1バイトの搬送波ビット数
+	std::vector<uint8_t> enc_ptns[2];	///< バイトごとの搬送波ビット列 [フリップ有無][バイト * enc_ptn_len]
+	uint8_t enc_next_frip[2][256];		///< 変換後のフリップ有無 [フリップ有無][バイト]
+
+	/// スタートビット検索用のパターン
+	CMultiPattern edge_matcher;
+	CMultiPattern carrier_matcher[4];
+
 #ifdef PARSEWAV_USE_REPORT
 	REPORT2 rep2;
 #endif
@@ -65,10 +79,13 @@ private:
 	int DecodeToSerial(CarrierData *c_data, SerialData *s_data, int8_t baud, int &step);
 	int WriteL3CData(OutputFile &outfile, CarrierData *c_data, int width, uint32_t &pdata, int &pwidth);
 
+	void MakeEncodeTable(int word_select, int baud);
+
 public:
 	CarrierParser();
 
 	void ClearResult();
+	void MergeResult(const CarrierParser &src);
 	void InitForDecode(enum_process_mode process_mode, TempParameter &tmp_param_, MileStoneList &mile_stone_);
 	void InitForEncode(enum_process_mode process_mode, TempParameter &tmp_param_, MileStoneList &mile_stone_);
 
@@ -83,6 +100,7 @@ public:
 	int ParseBaudRate(int fsk_spd, CarrierData *c_data, ChkWave *st_chkwav, int &step);
 
 	int EncodeToCarrier(SerialData *s_data, CarrierData *c_data);
+	int EncodeToCarrier(uint8_t bin_data, CarrierData *c_data);
 
 	int WriteL3CData(OutputFile &outfile, CarrierData *c_data);
 
@@ -90,8 +108,8 @@ public:
 	void SetFrip(int val) { frip = val; }
 
 #ifdef PARSEWAV_USE_REPORT
-	void DecordingReport(CarrierData *c_data, wxString &buff, wxString *logbuf);
-	void EncordingReport(CarrierData *c_data, wxString &buff, wxString *logbuf);
+	void DecordingReport(CarrierData *c_data, std::string &buff, std::string *logbuf);
+	void EncordingReport(std::string &buff);
 #endif
 
 	double GetSampleRate();
@@ -6,6 +6,7 @@
 /// @date   2019.08.01
 ///
 #include "paw_parseser.h"
+#include <string.h>
 #include "paw_file.h"
 #include "paw_format.h"
 #include "utils.h"
@@ -54,6 +55,16 @@ void REPORT3::AddError(int pos)
 	err_pos.push_back(pos);
 }
 
+/// @brief 後に続く区間のエラーを加える
+void REPORT3::Add(const REPORT3 &src)
+{
+	int cnt = (int)src.err_pos.size();
+	for(int i=0; i<src.err_num; i++) {
+		// 位置を保存していない分は件数のみ
+		AddError(i < cnt ? src.err_pos[i] : 0);
+	}
+}
+
 int REPORT3::GetError(int idx) const
 {
 	return err_pos[idx];
@@ -78,6 +89,8 @@ SerialParser::SerialParser()
 {
 	param = NULL;
 	tmp_param = NULL;
+	enc_word_select = -1;
+	enc_bits_len = 0;
 }
 
 void SerialParser::ClearResult()
@@ -85,6 +98,12 @@ void SerialParser::ClearResult()
 	rep3.Clear();
 }
 
+/// @brief 後に続く区間を別に解析した結果を加える
+void SerialParser::MergeResult(const SerialParser &src)
+{
+	rep3.Add(src.rep3);
+}
+
 /// @brief デコード時の初期処理
 ///
 void SerialParser::InitForDecode(enum_process_mode process_mode_, TempParameter &tmp_param_, MileStoneList &mile_stone_) 
@@ -97,6 +116,7 @@ void SerialParser::InitForDecode(enum_process_mode process_mode_, TempParameter
 
 	data_pos = -1;
 	parity_count = 0;
+	last_spos = 0;
 
 	write_pos = 0;
 	over_pos = 0;
@@ -114,6 +134,8 @@ void SerialParser::InitForEncode(enum_process_mode process_mode_, TempParameter
 	over_pos = 0;
 
 	prev_err.Clear();
+
+	enc_word_select = -1;
 }
 
 /// @brief l3bファイルのフォーマットをチェック（チェックしていないが）
@@ -169,21 +191,8 @@ PwErrType SerialParser::CheckT9XFormat(InputFile &file, PwErrCode &err_num, PwEr
 /// @brief l3bファイルファイルのビットサイズを計算
 int SerialParser::CalcL3BSize(InputFile &file)
 {
-	int l;
-	int sample_num = 0;
-	int file_size = file.GetSize();
-	file.Fseek(0, SEEK_SET);
-	while(file_size > 0) {
-		file_size--;
-
-		l = file.Fgetc();
-		l &= 0xff;
-
-		if (l == '\r' || l == '\n') {
-			continue;
-		}
-		sample_num++;
-	}
+	// 改行以外のデータ数
+	int sample_num = file.GetSize() - file.CountLineBreaks();
 	file.SampleNum(sample_num);
 	file.Fseek(0, SEEK_SET);
 	return sample_num;
@@ -265,22 +274,11 @@ int SerialParser::SkipL3BSample(int dir)
 /// @brief t9xファイルのビットサイズを計算
 int SerialParser::CalcT9XSize(InputFile &file)
 {
-//	int l;
 	int sample_num = 0;
-	int file_size = file.GetSize();
-	file.Fseek(sizeof(t9x_header_t), SEEK_SET);
-	file_size -= (int)sizeof(t9x_header_t);
-	while(file_size > 0) {
-		file_size--;
-
-		file.Fgetc();
-//		l = file.Fgetc();
-//		l &= 0xff;
-
-//		for(int i=0; i<8; i++) {
-//			char c = (l & (1 << i)) ? '1' : '0';
-		sample_num += 8;
-//		}
+	// 1バイトで8ビット分
+	int file_size = file.GetSize() - (int)sizeof(t9x_header_t);
+	if (file_size > 0) {
+		sample_num = file_size * 8;
 	}
 	file.SampleNum(sample_num);
 	file.Fseek(sizeof(t9x_header_t), SEEK_SET);
@@ -487,7 +485,7 @@ int SerialParser::ConvertBaudRate(SerialData *s_data, SerialData *sn_data)
 			int df = s_data->Compare(s_data->GetReadPos() - s_r_pos, *sn_data, sn_data->GetWritePos() - sn_w_pos, sn_w_pos);
 
 			CSampleString str(*sn_data, sn_data->GetWritePos() - sn_w_pos, sn_w_pos);
-			gLogFile.Fprintf("p2n cnv b:%d cnt:%04x df:%2d s:%2d:%s -> sn:%2d:%s\n"
+			logfile->Fprintf("p2n cnv b:%d cnt:%04x df:%2d s:%2d:%s -> sn:%2d:%s\n"
 				,phase3_baud, (int)prev_bcnt.Cnt(), df, s_r_pos
 				, buf_s
 				, sn_w_pos
@@ -599,9 +597,9 @@ int SerialParser::FindStartSerialBit(SerialData *s_data, BinaryData *b_data)
 		data_pos = -1;
 
 		if (tmp_param->GetDebugMode() > 1) {
-			gLogFile.Fprintf("p3 s:% 8d %s: skip [%c]\n"
+			logfile->Fprintf("p3 s:% 8d %s: skip [%c]\n"
 				, s_data->GetTotalReadPos()
-				, UTILS::get_time_cstr(infile->CalcrateSampleUSec(s_data->GetRead().SPos()))
+				, UTILS::get_time_str(infile->CalcrateSampleUSec(s_data->GetRead().SPos())).c_str()
 				, s_data->GetRead().Data());
 		}
 
@@ -631,6 +629,19 @@ int SerialParser::DecodeToBinary(SerialData *s_data, BinaryData *b_data)
 
 	CSampleData d = s_data->GetRead();
 
+	// 無音などで搬送波が途切れた場合、変換中のバイトは捨てて
+	// スタートビットからさがしなおす
+	if (data_pos > 0 && IsCarrierGap(d)) {
+		if (tmp_param->GetDebugMode() > 1) {
+			logfile->Fprintf("p3 s:% 8d %s: drop at gap\n"
+				, s_data->GetTotalReadPos()
+				, UTILS::get_time_str(infile->CalcrateSampleUSec(d.SPos())).c_str());
+		}
+		data_pos = -1;
+		return data_pos;
+	}
+	last_spos = d.SPos();
+
 	// skip
 	if (d.Data() == '?') {
 		s_data->IncreaseReadPos();
@@ -693,9 +704,9 @@ int SerialParser::DecodeToBinary(SerialData *s_data, BinaryData *b_data)
 			// エラーの場合
 			if (tmp_param->GetDebugMode() > 0) {
 				// デバッグログ
-				gLogFile.Fprintf("p3 s:%12d(%s) %s error.\n"
+				logfile->Fprintf("p3 s:%12d(%s) %s error.\n"
 					, start_data.SPos()
-					, UTILS::get_time_cstr(infile->CalcrateSampleUSec(start_data.SPos()))
+					, UTILS::get_time_str(infile->CalcrateSampleUSec(start_data.SPos())).c_str()
 					, (bin_err & 0xc0) == 0xc0 ? "parity" : "frame"
 				);
 			}
@@ -720,53 +731,84 @@ int SerialParser::DecodeToBinary(SerialData *s_data, BinaryData *b_data)
 	return data_pos;
 }
 
+/// @brief 直前のシリアルデータから搬送波が途切れているか
+///
+/// 区間に分けてデコードした場合と同じく、途切れをまたいでバイトを作らないようにする
+///
+/// @param[in] d 次のシリアルデータ
+/// @return true 途切れている
+bool SerialParser::IsCarrierGap(const CSampleData &d)
+{
+	if (infile->GetType() != FILETYPE_WAV) return false;
+	uint32_t usec = infile->CalcrateSampleUSec(d.SPos()) - infile->CalcrateSampleUSec(last_spos);
+	return (d.SPos() > last_spos && usec >= SERIAL_GAP_MSEC * 1000);
+}
+
 /// @brief バイナリデータをシリアルデータに変換する
 ///
+/// ワードセレクトごとに全バイトのビット列を作っておき、まとめて追加する
+///
 /// @param[in] bin_data バイナリデータ1バイト
 /// @param[out] s_data  シリアルデータ
 /// @return シリアルデータに変換した長さ
 int SerialParser::EncodeToSerial(uint8_t bin_data, SerialData *s_data)
+{
+	int word_select = param->GetWordSelect();
+
+	if (enc_word_select != word_select) {
+		for(int i = 0; i < 256; i++) {
+			enc_bits_len = MakeSerialBits((uint8_t)i, word_select, enc_bits[i]);
+		}
+		enc_word_select = word_select;
+	}
+	s_data->AddString(enc_bits[bin_data], enc_bits_len, 0);
+
+	return enc_bits_len;
+}
+
+/// @brief バイナリデータ1バイトのシリアルビット列を作成する
+///
+/// @param[in]  bin_data    バイナリデータ1バイト
+/// @param[in]  word_select ワードセレクト
+/// @param[out] bits        シリアルビット列 ('0' or '1' SERIAL_BYTE_BITS_MAX 以下)
+/// @return ビット数
+int SerialParser::MakeSerialBits(uint8_t bin_data, int word_select, uint8_t *bits)
 {
 	int pos = 0;
+	int len = 0;
 	int h_count = 0;	// H bitcount (use for parity check)
 	uint8_t val;
 
 	// start bit
-	val = '0';
-	s_data->Add(val, 0);
+	bits[len++] = '0';
 
 	// data bit
-	for(pos = 0; pos < 7 + ((param->GetWordSelect() & 0x04) ? 1 : 0); pos++) {
+	for(pos = 0; pos < 7 + ((word_select & 0x04) ? 1 : 0); pos++) {
 		val = (bin_data & (1 << pos)) ? '1' : '0';
-		s_data->Add(val, 0);
+		bits[len++] = val;
 		h_count += (val == '1') ? 1 : 0;
 	}
-	pos++;
 
 	// parity bit
-	if ((param->GetWordSelect() & 0x07) != 0x04 && (param->GetWordSelect() & 0x07) != 0x05) {
-		if (param->GetWordSelect() & 0x01) {
+	if ((word_select & 0x07) != 0x04 && (word_select & 0x07) != 0x05) {
+		if (word_select & 0x01) {
 			// odd parity
 			val = (h_count & 0x01) ? '1' : '0';
 		} else {
 			// even parity
 			val = (h_count & 0x01) ? '0' : '1';
 		}
-		s_data->Add(val, 0);
-		pos++;
+		bits[len++] = val;
 	}
 
 	// stop bit
-	val = '1';
-	s_data->Add(val, 0);
-	pos++;
-	if ((param->GetWordSelect() & 0x07) == 0x04 || (param->GetWordSelect() & 0x06) == 0x00) {
+	bits[len++] = '1';
+	if ((word_select & 0x07) == 0x04 || (word_select & 0x06) == 0x00) {
 		// 2 stop bit
-		s_data->Add(val, 0);
-		pos++;
+		bits[len++] = '1';
 	}
 
-	return pos;
+	return len;
 }
 
 /// @brief L3Bデータをファイルに出力
@@ -879,116 +921,116 @@ int SerialParser::WriteT9XData(OutputFile &outfile, SerialData *s_data, int &red
 }
 
 /// @brief デコード時のレポート
-void SerialParser::DecordingReport(SerialData *s_data, wxString &buff, wxString *logbuf)
+void SerialParser::DecordingReport(SerialData *s_data, std::string &buff, std::string *logbuf)
 {
 //	int spd = param->GetFskSpeed();
 
-	gLogFile.SetLogBuf(logbuf);
+	logfile->SetLogBuf(logbuf);
 
-	buff = _T(" [ l3b, t9x -> l3 ]");
-	gLogFile.Write(buff, 1);
+	buff = " [ l3b, t9x -> l3 ]";
+	logfile->Write(buff, 1);
 
 	if (param->GetWordDataBitLen() == 7) {
 		// 7bit
-		buff = _T(" 7bits");
+		buff = " 7bits";
 	} else {
 		// 8bit
-		buff = _T(" 8bits");
+		buff = " 8bits";
 	}
 
 	switch(param->GetWordParityBit()) {
 	case 1:
-		buff += _T(" OddParity");
+		buff += " OddParity";
 		break;
 	case 0:
-		buff += _T(" EvenParity");
+		buff += " EvenParity";
 		break;
 	default:
-		buff += _T(" NoParity");
+		buff += " NoParity";
 		break;
 	}
 	if (param->GetWordStopBitLen() == 1) {
-		buff += _T(" 1stopbit");
+		buff += " 1stopbit";
 	} else {
-		buff += _T(" 2stopbit");
+		buff += " 2stopbit";
 	}
-	gLogFile.Write(buff, 1);
+	logfile->Write(buff, 1);
 
 	if (s_data->GetTotalReadPos() > 0) {
-		buff.Printf(_T(" %d / %d errors. (%.2f%%)"),rep3.GetErrorNum(), s_data->GetTotalReadPos(), (rep3.GetErrorNum() * 100.0 / s_data->GetTotalReadPos()));
-		gLogFile.Write(buff, 1);
+		UTILS::str_printf(buff, " %d / %d errors. (%.2f%%)",rep3.GetErrorNum(), s_data->GetTotalReadPos(), (rep3.GetErrorNum() * 100.0 / s_data->GetTotalReadPos()));
+		logfile->Write(buff, 1);
 		int col_max = 5;
 		int col = 0;
-		buff.Empty();
+		buff.clear();
 		for(int i=0; i<rep3.GetErrorCount(); i++) {
 			int start_pos = rep3.GetError(i);
-			buff += (col == 0 ? _T("  ") : _T(", "));
-			buff += wxString::Format(_T("%d (")
+			buff += (col == 0 ? "  " : ", ");
+			buff += UTILS::str_format("%d ("
 				,start_pos);
 			buff += UTILS::get_time_str(infile->CalcrateSampleUSec(start_pos));
-			buff += _T(")");
+			buff += ")";
 			col++;
 			if (col == col_max) {
-				gLogFile.Write(buff, 1);
+				logfile->Write(buff, 1);
 				col = 0;
-				buff.Empty();
+				buff.clear();
 			}
 		}
 		for(int i=0; i<(rep3.IsOverError() ? 1 : 0); i++) {
-			buff += _T("  and more...");
+			buff += "  and more...";
 			col++;
 			if (col == col_max) {
-				gLogFile.Write(buff, 1);
+				logfile->Write(buff, 1);
 				col = 0;
-				buff.Empty();
+				buff.clear();
 			}
 		}
 		if (col > 0) {
-			gLogFile.Write(buff, 1);
+			logfile->Write(buff, 1);
 		}
 	}
 
-	gLogFile.Write(_T(""), 1);
+	logfile->Write("", 1);
 }
 
 /// @brief エンコード時のレポート
-void SerialParser::EncordingReport(SerialData *s_data, wxString &buff, wxString *logbuf)
+void SerialParser::EncordingReport(std::string &buff)
 {
 	if (infile->GetType() == FILETYPE_PLAIN) {
-		buff = _T(" [ plain");
+		buff = " [ plain";
 	} else {
-		buff = _T(" [ l3");
+		buff = " [ l3";
 	}
-	buff += _T(" -> l3b, t9x ]");
-	gLogFile.Write(buff, 1);
+	buff += " -> l3b, t9x ]";
+	logfile->Write(buff, 1);
 
 	if (param->GetWordDataBitLen() == 7) {
 		// 7bit
-		buff = _T(" 7bits");
+		buff = " 7bits";
 	} else {
 		// 8bit
-		buff = _T(" 8bits");
+		buff = " 8bits";
 	}
 
 	switch(param->GetWordParityBit()) {
 	case 1:
-		buff += _T(" OddParity");
+		buff += " OddParity";
 		break;
 	case 2:
-		buff += _T(" EvenParity");
+		buff += " EvenParity";
 		break;
 	default:
-		buff += _T(" NoParity");
+		buff += " NoParity";
 		break;
 	}
 	if (param->GetWordStopBitLen() == 1) {
-		buff += _T(" 1stopbit");
+		buff += " 1stopbit";
 	} else {
-		buff += _T(" 2stopbit");
+		buff += " 2stopbit";
 	}
-	gLogFile.Write(buff, 1);
+	logfile->Write(buff, 1);
 
-	gLogFile.Write(_T(""), 1);
+	logfile->Write("", 1);
 }
 
 }; /* namespace PARSEWAV */
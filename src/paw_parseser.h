@@ -11,7 +11,7 @@
 #include "common.h"
 #include <stdio.h>
 #include <vector>
-#include <wx/string.h>
+#include <string>
 #include "paw_parse.h"
 #include "errorinfo.h"
 #include "paw_defs.h"
@@ -41,6 +41,13 @@ public:
 
 #define REPORT3_MAX_ERROR 50
 
+/// 1バイトのシリアルビット数の最大
+#define SERIAL_BYTE_BITS_MAX 12
+
+/// 変換中のバイトを捨てる搬送波の途切れ(ms)
+/// 区間に分けてデコードする時の無音(SEGMENT_SILENCE_MSEC)より短くすること
+#define SERIAL_GAP_MSEC 100
+
 /// @brief 結果レポート用クラス
 class REPORT3
 {
@@ -54,6 +61,7 @@ public:
 
 	void Clear();
 	void AddError(int pos);
+	void Add(const REPORT3 &src);
 
 	int GetErrorNum() const { return err_num; }
 	int GetErrorCount() const { return (int)err_pos.size(); }
@@ -84,6 +92,7 @@ private:
 	int8_t data_pos;
 	int parity_count;
 	CSampleData prev_err;
+	int last_spos;	///< 直前に変換したシリアルデータのサンプル位置
 
 	uint16_t bin_data;
 	uint8_t bin_err;
@@ -94,6 +103,11 @@ private:
 	uint8_t over_buf[128];
 	int over_pos;
 
+	/// エンコード用テーブル
+	int enc_word_select;	///< テーブルを作成した時のワードセレクト -1:未作成
+	int enc_bits_len;		///< 1バイトのシリアルビット数
+	uint8_t enc_bits[256][SERIAL_BYTE_BITS_MAX];	///< バイトごとのシリアルビット列
+
 	int CalcL3BSize(InputFile &file);
 	int CalcT9XSize(InputFile &file);
 	int WriteL3BData(OutputFile &outfile, SerialData *s_data, int width, int &redata);
@@ -105,6 +119,7 @@ public:
 	SerialParser();
 
 	void ClearResult();
+	void MergeResult(const SerialParser &src);
 	void InitForDecode(enum_process_mode process_mode_, TempParameter &tmp_param_, MileStoneList &mile_stone_);
 	void InitForEncode(enum_process_mode process_mode_, TempParameter &tmp_param_, MileStoneList &mile_stone_);
 
@@ -123,8 +138,10 @@ public:
 
 	int FindStartSerialBit(SerialData *s_data, BinaryData *b_data);
 	int DecodeToBinary(SerialData *s_data, BinaryData *b_data);
+	bool IsCarrierGap(const CSampleData &d);
 
 	int EncodeToSerial(uint8_t bin_data, SerialData *s_data);
+	static int MakeSerialBits(uint8_t bin_data, int word_select, uint8_t *bits);
 
 	int WriteL3BData(OutputFile &outfile, SerialData *s_data);
 	int WriteT9XData(OutputFile &outfile, SerialData *s_data);
@@ -133,8 +150,8 @@ public:
 	void SetDataPos(int val) { data_pos = val; }
 	void SetPhase3Baud(int8_t val) { phase3_baud = val; }
 
-	void DecordingReport(SerialData *s_data, wxString &buff, wxString *logbuf);
-	void EncordingReport(SerialData *s_data, wxString &buff, wxString *logbuf);
+	void DecordingReport(SerialData *s_data, std::string &buff, std::string *logbuf);
+	void EncordingReport(std::string &buff);
 };
 
 }; /* namespace PARSEWAV */
@@ -6,8 +6,15 @@
 /// @date   2019.08.01
 ///
 #include "paw_parsewav.h"
+#include <string.h>
 #include "paw_file.h"
 #include "utils.h"
+#define _USE_MATH_DEFINES
+#include <math.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WAVEPARSER_USE_SSE2
+#endif
 
 
 namespace PARSEWAV 
@@ -56,6 +63,78 @@ void parse_carrier_t::clear()
 
 //
 
+parse_iq_t::parse_iq_t()
+{
+	win = 0;
+	win4 = 0;
+	step = 1;
+	unit[0] = 0.0;
+	unit[1] = 0.0;
+	thres = 0.0f;
+	clear();
+}
+
+void parse_iq_t::clear()
+{
+	tone = 0;
+	cand = 0;
+	cand_cnt = 0;
+	cand_spos = 0;
+	cand_phase = 1;
+	run_len = 0.0;
+	run_spos = 0;
+	run_phase = 1;
+	carry = 0.0;
+	pend_tone = 0;
+	pend_num = 0;
+	pend_spos = 0.0;
+	phase = 1;
+}
+
+//
+
+synth_wave_t::synth_wave_t()
+{
+	rate = 48000;
+	blk_size = 1;
+	fsk_spd = -1;
+	sym_len = 0;
+	out_len = 0;
+	phase_unit = 1;
+	width = 0;
+	clear();
+}
+
+void synth_wave_t::clear()
+{
+	start = 0;
+	prev = -1;
+	acc.assign(acc.size(), 0);
+}
+
+//
+
+decimate_wave_t::decimate_wave_t()
+{
+	factor = 1;
+	in_rate = 0;
+	in_num = 0;
+	in_pos = 0;
+	taps = 0;
+	half = 0;
+	clear();
+}
+
+void decimate_wave_t::clear()
+{
+	pos = 0;
+	len = 0;
+	primed = false;
+	last = 0;
+}
+
+//
+
 PrevCross::PrevCross()
 {
 	Clear();
@@ -83,22 +162,50 @@ void REPORT1::Clear()
 //		sample_odd[i] = 0;
 	}
 }
+
+void REPORT1::Add(const REPORT1 &src)
+{
+	for(int i=0; i<6; i++) {
+		sample_num[i] += src.sample_num[i];
+	}
+}
 #endif
 
 //
 
 WaveParser::WaveParser()
 	: ParserBase()
+#ifdef PARSEWAV_USE_THREAD
+	, reader_ring(WAVE_READER_RING_SIZE)
+#endif
 {
+	lamda_table_scale = 0.0;
+	lamda_table_spd = -1;
+	lamda_table_half = false;
+	decoder = NULL;
+	decoder_spd = -1;
 #ifdef PARSEWAV_USE_REPORT
 	rep1.Clear();
 #endif
+#ifdef PARSEWAV_USE_THREAD
+	reader_stop = false;
+	reader_running = false;
+	reader_pos = 0;
+	reader_end = 0;
+#endif
+}
+
+WaveParser::~WaveParser()
+{
+	StopReader();
 }
 
 void WaveParser::Clear()
 {
 	st_pa_carr.clear();
 	st_lamda.clear();
+	lamda_table.clear();
+	lamda_table_spd = -1;
 }
 
 void WaveParser::ClearResult()
@@ -108,6 +215,29 @@ void WaveParser::ClearResult()
 #endif
 }
 
+/// @brief 後に続く区間を別に解析した結果を加える
+///
+/// 波長の平均値は直前の波ほど重みが大きいので、波があれば後の区間のものにする
+///
+/// @param[in] src 後の区間を解析したもの
+void WaveParser::MergeResult(const WaveParser &src)
+{
+#ifdef PARSEWAV_USE_REPORT
+	rep1.Add(src.rep1);
+	int num = 0;
+	for(int i=0; i<3; i++) {
+		num += src.rep1.GetSampleNum(i);
+	}
+	if (num == 0) return;
+#endif
+	for(int n=0; n<3; n++) {
+		st_lamda.us_avg[n] = src.st_lamda.us_avg[n];
+	}
+	for(int n=0; n<2; n++) {
+		st_lamda.us_mid_avg[n] = src.st_lamda.us_mid_avg[n];
+	}
+}
+
 /// @brief デコード時の初期処理
 ///
 void WaveParser::InitForDecode(enum_process_mode process_mode_, WaveFormat &inwav_, TempParameter &tmp_param_, MileStoneList &mile_stone_)
@@ -116,11 +246,14 @@ void WaveParser::InitForDecode(enum_process_mode process_mode_, WaveFormat &inwa
 	inwav = &inwav_;
 
 	st_pa_carr.clear();
+	st_pa_iq.clear();
 	prev_cross.Clear();
 
-	st_lamda.us_delta = 1000000.0 / (double)inwav->GetSampleRate();
+	InitDecimation(inwav->GetSampleRate());
+
+	st_lamda.us_delta = 1000000.0 / (double)GetSampleRate();
 	for(int n=0; n<3; n++) {
-		st_lamda.samples[n] = (double)inwav->GetSampleRate() / (double)(1200 << n);
+		st_lamda.samples[n] = (double)GetSampleRate() / (double)(1200 << n);
 
 		st_lamda.us_range[n] = 1000000.0 / (double)(1200 << n) / (double)(tmp_param->GetHalfWave() ? 2 : 1);
 		st_lamda.us[n] = 1000000.0 / (double)param->GetFreq(n) / (double)(tmp_param->GetHalfWave() ? 2 : 1);
@@ -145,6 +278,111 @@ void WaveParser::InitForDecode(enum_process_mode process_mode_, WaveFormat &inwa
 			st_lamda.us_max[ns] = st_lamda.us[ns] + st_lamda.us_range[ns] * param->GetRange(n) / 100.0;
 		}
 	}
+
+	MakeLamdaTable(param->GetFskSpeed(), tmp_param->GetHalfWave());
+
+	SetDecoder(param->GetFskSpeed());
+}
+
+/// @brief 波長の分類テーブルを作成
+///
+/// 波長を1/LAMDA_TABLE_RESサンプル単位に量子化した位置ごとに分類を求めておく。
+/// しきい値を含む位置はLAMDA_EXACTにして、デコード時に比較で求める。
+///
+/// @param[in] fsk_spd 1:倍速FSK
+/// @param[in] half    半波の場合true
+void WaveParser::MakeLamdaTable(int fsk_spd, bool half)
+{
+	lamda_table_spd = fsk_spd;
+	lamda_table_half = half;
+	lamda_table_scale = (double)LAMDA_TABLE_RES / st_lamda.us_delta;
+
+	double thres[6];
+	thres[0] = st_lamda.us_min[fsk_spd];
+	thres[1] = st_lamda.us_max[fsk_spd];
+	thres[2] = st_lamda.us_min[fsk_spd + 1];
+	thres[3] = st_lamda.us_max[fsk_spd + 1];
+	thres[4] = st_lamda.us_mid[fsk_spd];
+	thres[5] = 0.0;
+
+	// 最後の位置はすべてのしきい値より大きい
+	int size = 0;
+	for(int i=0; i<6; i++) {
+		int q = (int)(thres[i] * lamda_table_scale);
+		if (size < q) size = q;
+	}
+	size += 2;
+
+	lamda_table.resize(size);
+	for(int q=0; q<size; q++) {
+		bool exact = false;
+		for(int i=0; i<6; i++) {
+			if ((int)(thres[i] * lamda_table_scale) == q) {
+				exact = true;
+				break;
+			}
+		}
+		if (exact) {
+			lamda_table[q] = LAMDA_EXACT;
+		} else {
+			lamda_table[q] = (uint8_t)ClassifyLamda(fsk_spd, half, ((double)q + 0.5) / lamda_table_scale);
+		}
+	}
+}
+
+/// @brief 波長を分類する
+/// @param[in] fsk_spd 1:倍速FSK
+/// @param[in] half    半波の場合true
+/// @param[in] lamda   波長(us)
+/// @return en_lamda_class
+int WaveParser::ClassifyLamda(int fsk_spd, bool half, double lamda) const
+{
+	if (st_lamda.us_min[fsk_spd] <= lamda && lamda <= st_lamda.us_max[fsk_spd]) {
+		return LAMDA_LONG;
+	}
+	if (st_lamda.us_min[fsk_spd+1] <= lamda && lamda <= st_lamda.us_max[fsk_spd+1]) {
+		return LAMDA_SHORT;
+	}
+	if (!half) {
+		// 全波
+		if (st_lamda.us_mid[fsk_spd] <= lamda && lamda < st_lamda.us_min[fsk_spd]) {
+			return LAMDA_MID_LONG;
+		}
+		if (st_lamda.us_max[fsk_spd+1] < lamda && lamda < st_lamda.us_mid[fsk_spd]) {
+			return LAMDA_MID_SHORT;
+		}
+	} else {
+		// 半波
+		if (st_lamda.us_max[fsk_spd+1] < lamda && lamda < st_lamda.us_min[fsk_spd]) {
+			return LAMDA_MIDDLE;
+		}
+	}
+	if (st_lamda.us_max[fsk_spd] < lamda) {
+		return LAMDA_TOO_LONG;
+	}
+	if (lamda < st_lamda.us_min[fsk_spd+1]) {
+		return LAMDA_TOO_SHORT;
+	}
+	return LAMDA_ERROR;
+}
+
+/// @brief 分類テーブルを引いて波長を分類する
+/// @param[in] fsk_spd 1:倍速FSK
+/// @param[in] half    半波の場合true
+/// @param[in] lamda   波長(us)
+/// @return en_lamda_class
+int WaveParser::LookupLamda(int fsk_spd, bool half, double lamda) const
+{
+	if (fsk_spd != lamda_table_spd || half != lamda_table_half || lamda_table.empty() || lamda < 0.0) {
+		return ClassifyLamda(fsk_spd, half, lamda);
+	}
+	double qd = lamda * lamda_table_scale;
+	int last = (int)lamda_table.size() - 1;
+	int cls = lamda_table[qd < (double)last ? (int)qd : last];
+	if (cls == LAMDA_EXACT) {
+		cls = ClassifyLamda(fsk_spd, half, lamda);
+	}
+	return cls;
 }
 
 /// @brief エンコード時の初期処理
@@ -177,15 +415,80 @@ PwErrType WaveParser::CheckWaveFormat(InputFile &file, wav_header_t *head, wav_f
 		return pwError;
 	}
 
+	SetWaveInput(file, fmt, data);
+
+	return pwOK;
+}
+
+/// @brief チェック済みのwavファイルのサンプル数とレートを入力ファイルに設定する
+///
+/// @param[in] file 入力ファイル(データチャンクの先頭から読む)
+/// @param[in] fmt  WAVファイル FMTチャンク
+/// @param[in] data WAVファイル DATチャンク
+///
+void WaveParser::SetWaveInput(InputFile &file, const wav_fmt_chank_t *fmt, const wav_data_chank_t *data)
+{
+	SetInputFile(file);
+
 	int sample_num = (data->data_len / fmt->channels);
 	if(fmt->sample_bits == 16) {
 		sample_num /= 2;
 	}
-	file.SampleNum(sample_num);
 
-	file.SampleRate(fmt->sample_rate);
+	// 高いサンプルレートの場合は間引いたサンプルを入力とする
+	InitDecimation(fmt->sample_rate);
+	st_decim.in_num = sample_num;
+	st_decim.in_pos = 0;
+	st_decim.clear();
 
-	return pwOK;
+	file.SampleNum(sample_num / st_decim.factor);
+
+	file.SampleRate((double)fmt->sample_rate / st_decim.factor);
+}
+
+/// @brief 入力を間引く数を求める
+///
+/// 間引いた後の最低レートは設定値、自動の場合はFSK速度で決める
+///
+/// @param[in] sample_rate 入力サンプルレート
+/// @return 間引く数 1:間引かない
+int WaveParser::CalcDecimation(int sample_rate) const
+{
+	int min_rate = param->GetDecimateRate();
+	if (min_rate <= 0) {
+		min_rate = (DECIMATE_AUTO_RATE << param->GetFskSpeed());
+	}
+	int factor = Util::CalcDecimation(sample_rate, min_rate);
+	return (factor > 0 ? factor : 1);
+}
+
+/// @brief 入力を間引くフィルタを初期化する
+///
+/// 間引く数が変わった時だけ係数を作り直す
+///
+/// @param[in] sample_rate 入力サンプルレート
+void WaveParser::InitDecimation(int sample_rate)
+{
+	decimate_wave_t &dc = st_decim;
+	int factor = CalcDecimation(sample_rate);
+
+	dc.in_rate = sample_rate;
+	if (factor == dc.factor) return;
+
+	dc.factor = factor;
+	dc.coef.clear();
+	dc.buf.clear();
+	dc.clear();
+	if (factor <= 1) return;
+
+	// 間引いた後のナイキスト周波数で帯域を制限する
+	double cutoff = 1.0 / factor;
+	dc.half = RESAMPLE_ZEROS * factor;
+	if (dc.half > RESAMPLE_MAX_TAPS / 2 - 4) dc.half = RESAMPLE_MAX_TAPS / 2 - 4;
+	dc.taps = (dc.half * 2 + 7) & ~7;
+	dc.coef.resize(dc.taps);
+	Util::MakeLowPassCoef(cutoff, dc.half, 0.0, dc.taps, &dc.coef[0]);
+	dc.buf.resize(WAVE_BLOCK_SIZE * factor + dc.taps * 2);
 }
 
 
@@ -201,12 +504,33 @@ int WaveParser::GetWaveSample(int blk_size, bool reverse)
 	int l = 0;
 	int h = 0;
 	int in_bits = inwav->GetSampleBits();
+	size_t frame_size = (size_t)(inwav->GetChannels() * in_bits / 8);
 
 	// 1サンプルを得る
-	l = infile->Fgetc();
+	size_t len = frame_size;
+	const uint8_t *p = infile->Fmap(len);
+	if (len >= frame_size) {
+		l = p[0];
+		if(in_bits == 16) {
+			h = p[1];
+		}
+		// ステレオの場合、左側を無視する
+		infile->Fskip(frame_size);
+	} else {
+		// ファイル終端付近は1バイトずつ読む
+		l = infile->Fgetc();
+		if(in_bits == 16) {
+			h = infile->Fgetc();
+		}
+		for(int i = 2; i <= inwav->GetChannels(); i++) {
+			infile->Fgetc();
+			if(in_bits == 16) {
+				infile->Fgetc();
+			}
+		}
+	}
 	if(in_bits == 16) {
 		// int16_tの場合
-		h = infile->Fgetc();
 		if (h >= 128) {
 			h = h - 256;
 		}
@@ -221,14 +545,6 @@ int WaveParser::GetWaveSample(int blk_size, bool reverse)
 			if (l >= 256) l = 255;
 		}
 	}
-	// ステレオの場合、左側を無視する
-	for(int i = 2; i <= inwav->GetChannels(); i++) {
-		infile->Fgetc();
-		if(in_bits == 16) {
-			infile->Fgetc();
-		}
-	}
-
 	if (blk_size == 1) {
 		if(in_bits == 16) {
 			// int16_t -> uint8_t
@@ -246,26 +562,161 @@ int WaveParser::GetWaveSample(int blk_size, bool reverse)
 	}
 }
 
+/// ブロック変換用関数
+typedef void (*decode_wave_block_t)(const uint8_t *src, int len, uint8_t *dst);
+
+/// @brief PCMデータをまとめて8ビットデータに変換する
+///
+/// GetWaveSample(1, reverse)と同じ変換を行う。
+/// 形式ごとに展開するのでループ内に分岐がない。
+///
+/// @param[in]  src  PCMデータ(len * CHANNELS * BITS / 8 バイト)
+/// @param[in]  len  サンプル数
+/// @param[out] dst  変換後のデータ(len バイト)
+///
+template<int BITS, int CHANNELS, bool REVERSE>
+static void decode_wave_block(const uint8_t *src, int len, uint8_t *dst)
+{
+	const int frame_size = CHANNELS * BITS / 8;
+	for(int n = 0; n < len; n++) {
+		int v;
+		if (BITS == 16) {
+			// 上位バイトのみ使う
+			v = (int8_t)src[n * frame_size + 1];
+			if (REVERSE) {
+				v = -v;
+				if (v > 127) v = 127;
+			}
+			v += 128;
+		} else {
+			v = src[n * frame_size];
+			if (REVERSE) {
+				v = (v == 0 ? 255 : 256 - v);
+			}
+		}
+		dst[n] = (uint8_t)v;
+	}
+}
+
+/// 16ビットへのブロック変換用関数
+typedef void (*decode_wave_block16_t)(const uint8_t *src, int len, int16_t *dst);
+
+/// @brief PCMデータをまとめて16ビットデータに変換する
+///
+/// GetWaveSample(2, reverse)と同じ値になる。間引く前の入力に使う。
+///
+/// @param[in]  src  PCMデータ(len * CHANNELS * BITS / 8 バイト)
+/// @param[in]  len  サンプル数
+/// @param[out] dst  変換後のデータ(len サンプル)
+///
+template<int BITS, int CHANNELS, bool REVERSE>
+static void decode_wave_block16(const uint8_t *src, int len, int16_t *dst)
+{
+	const int frame_size = CHANNELS * BITS / 8;
+	for(int n = 0; n < len; n++) {
+		int v;
+		if (BITS == 16) {
+			v = (int16_t)(src[n * frame_size] | (src[n * frame_size + 1] << 8));
+		} else {
+			v = ((int)src[n * frame_size] - 128) * 256;
+		}
+		if (REVERSE) {
+			v = -v;
+			if (v > 32767) v = 32767;
+		}
+		dst[n] = (int16_t)v;
+	}
+}
+
+/// @brief フォーマットに合う16ビットへのブロック変換関数を返す
+///
+/// @param[in] bits     サンプルビット数
+/// @param[in] channels チャンネル数
+/// @param[in] reverse  波形を反転
+/// @return 関数 / NULL:未対応
+///
+static decode_wave_block16_t select_decode_wave_block16(int bits, int channels, bool reverse)
+{
+	if (bits == 16) {
+		if (channels == 1) {
+			return reverse ? decode_wave_block16<16, 1, true> : decode_wave_block16<16, 1, false>;
+		} else if (channels == 2) {
+			return reverse ? decode_wave_block16<16, 2, true> : decode_wave_block16<16, 2, false>;
+		}
+	} else if (bits == 8) {
+		if (channels == 1) {
+			return reverse ? decode_wave_block16<8, 1, true> : decode_wave_block16<8, 1, false>;
+		} else if (channels == 2) {
+			return reverse ? decode_wave_block16<8, 2, true> : decode_wave_block16<8, 2, false>;
+		}
+	}
+	return NULL;
+}
+
+/// @brief フォーマットに合うブロック変換関数を返す
+///
+/// @param[in] bits     サンプルビット数
+/// @param[in] channels チャンネル数
+/// @param[in] reverse  波形を反転
+/// @return 関数 / NULL:未対応
+///
+static decode_wave_block_t select_decode_wave_block(int bits, int channels, bool reverse)
+{
+	if (bits == 16) {
+		if (channels == 1) {
+			return reverse ? decode_wave_block<16, 1, true> : decode_wave_block<16, 1, false>;
+		} else if (channels == 2) {
+			return reverse ? decode_wave_block<16, 2, true> : decode_wave_block<16, 2, false>;
+		}
+	} else if (bits == 8) {
+		if (channels == 1) {
+			return reverse ? decode_wave_block<8, 1, true> : decode_wave_block<8, 1, false>;
+		} else if (channels == 2) {
+			return reverse ? decode_wave_block<8, 2, true> : decode_wave_block<8, 2, false>;
+		}
+	}
+	return NULL;
+}
+
 /// @brief wavファイルからサンプルを読んでバッファに追記
 ///
+/// WAVE_BLOCK_SIZE サンプルずつまとめて変換する
+///
 /// @param[in,out] w_data サンプルデータ用のバッファ(追記していく)
 /// @param[in] reverse    波形を反転
 /// @return 読み込んだデータの長さ
 ///
 int WaveParser::GetWaveSample(WaveData *w_data, bool reverse)
 {
-	int l;
-
 	// バッファがいっぱいになるまで読み込む
 	while(!w_data->IsFull() && infile->SamplePos() < infile->SampleNum()) {
-		l = GetWaveSample(1, reverse);
+		int spos = infile->SamplePos();
+		int num = w_data->FreeSize();
+		if (num > infile->SampleNum() - spos) num = infile->SampleNum() - spos;
+		if (num > WAVE_BLOCK_SIZE) num = WAVE_BLOCK_SIZE;
+
+#ifdef PARSEWAV_USE_THREAD
+		if (reader_running) {
+			// 読み込みスレッドが変換したものを受け取る
+			num = PopWaveBlock(block_buf, num);
+			if (num <= 0) break;
+		} else
+#endif
+		num = ReadWaveBlock(block_buf, num, reverse);
 
-		w_data->Add((uint8_t)l, infile->SamplePos());
+		w_data->AddSamples(block_buf, num, spos);
 
-		mile_stone->MarkIfNeed(infile->SamplePos());
+		// 境界に達した位置をマーク
+		int end = spos + num;
+		for(int i = spos; i < end; i++) {
+			if (i < mile_stone->GetNextSPos()) {
+				i = mile_stone->GetNextSPos();
+				if (i >= end) break;
+			}
+			mile_stone->MarkIfNeed(i);
+		}
 
-		infile->IncreaseSamplePos();
-//		infile->CalcrateSampleUSec(inwav->GetSampleRate());
+		infile->AddSamplePos(num);
 	}
 	if (infile->SamplePos() >= infile->SampleNum()) {
 		w_data->LastData(true);
@@ -273,6 +724,285 @@ int WaveParser::GetWaveSample(WaveData *w_data, bool reverse)
 	return w_data->GetWritePos();
 }
 
+/// @brief wavファイルからサンプルをまとめて読んで変換する
+///
+/// @param[out] dst     変換したサンプル(8ビット)
+/// @param[in]  num     変換するサンプル数(WAVE_BLOCK_SIZE以下)
+/// @param[in]  reverse 波形を反転
+/// @return 変換したサンプル数 (ファイル終端付近では num より少ない)
+///
+int WaveParser::ReadWaveBlock(uint8_t *dst, int num, bool reverse)
+{
+	if (st_decim.factor > 1) {
+		// 間引きながら変換
+		DecimateWave(dst, num, reverse);
+		return num;
+	}
+
+	decode_wave_block_t decode_block = select_decode_wave_block(inwav->GetSampleBits(), inwav->GetChannels(), reverse);
+	size_t frame_size = (size_t)(inwav->GetChannels() * inwav->GetSampleBits() / 8);
+
+	const uint8_t *p = NULL;
+	if (decode_block) {
+		size_t len = (size_t)num * frame_size;
+		p = infile->Fmap(len);
+		num = (int)(len / frame_size);
+	} else {
+		num = 0;
+	}
+	if (num > 0) {
+		decode_block(p, num, dst);
+		infile->Fskip((size_t)num * frame_size);
+	} else {
+		// 未対応のフォーマットかファイル終端なので１サンプルずつ
+		num = 1;
+		dst[0] = (uint8_t)GetWaveSample(1, reverse);
+	}
+	return num;
+}
+
+/// @brief 長い入力を分割できる位置を無音の区間からさがす
+///
+/// 間引く前の入力を8ビットに変換して、振幅の小さい状態が続く区間の中央を分割位置とする。
+/// 入力ファイルの位置は変えない。
+///
+/// @param[out] cuts    分割位置(間引いた後のサンプル位置)
+/// @param[in]  min_len 分割した区間の最短の長さ(間引いた後のサンプル数)
+/// @return 分割位置の数
+///
+int WaveParser::FindSilentCuts(std::vector<int> &cuts, int min_len)
+{
+	cuts.clear();
+
+	decode_wave_block_t decode_block = select_decode_wave_block(inwav->GetSampleBits(), inwav->GetChannels(), false);
+	if (!decode_block) return 0;
+
+	size_t frame_size = (size_t)(inwav->GetChannels() * inwav->GetSampleBits() / 8);
+	int factor = st_decim.factor;
+	int min_silence = (int)((double)st_decim.in_rate * SEGMENT_SILENCE_MSEC / 1000.0);
+	long file_pos = infile->Ftell();
+
+	int pos = 0;		// 間引く前のサンプル位置
+	int run_top = -1;	// 無音が始まった位置
+	int last_cut = 0;
+	while(pos < st_decim.in_num) {
+		int num = st_decim.in_num - pos;
+		if (num > WAVE_BLOCK_SIZE) num = WAVE_BLOCK_SIZE;
+		size_t len = (size_t)num * frame_size;
+		const uint8_t *p = infile->Fmap(len);
+		num = (int)(len / frame_size);
+		if (num <= 0) break;
+		decode_block(p, num, block_buf);
+		infile->Fskip((size_t)num * frame_size);
+
+		for(int i=0; i<num; i++, pos++) {
+			int lv = (int)block_buf[i] - 128;
+			if (lv >= -SEGMENT_SILENCE_LEVEL && lv <= SEGMENT_SILENCE_LEVEL) {
+				if (run_top < 0) run_top = pos;
+				continue;
+			}
+			if (run_top >= 0 && pos - run_top >= min_silence) {
+				int cut = (run_top + (pos - run_top) / 2) / factor;
+				if (cut - last_cut >= min_len) {
+					cuts.push_back(cut);
+					last_cut = cut;
+				}
+			}
+			run_top = -1;
+		}
+	}
+	// 最後の区間が短い場合は前の区間につなげる
+	if (!cuts.empty() && infile->SampleNum() - cuts.back() < min_len) {
+		cuts.pop_back();
+	}
+
+	infile->Fseek(file_pos, SEEK_SET);
+
+	return (int)cuts.size();
+}
+
+/// @brief wavファイルの読み込みと変換を別スレッドで始める
+///
+/// 以降のGetWaveSample()は読み込みスレッドが変換したサンプルを受け取る。
+/// 変換したサンプルの並びはスレッドを使わない時と同じになる。
+///
+/// @param[in] reverse 波形を反転
+///
+void WaveParser::StartReader(bool reverse)
+{
+#ifdef PARSEWAV_USE_THREAD
+	StopReader();
+
+	// シングルコアでは待ち合わせが増えるだけなので使わない
+	if (std::thread::hardware_concurrency() < 2) return;
+
+	reader_ring.Clear();
+	reader_stop = false;
+	reader_pos = infile->SamplePos();
+	reader_end = infile->SampleNum();
+	reader_thread = std::thread(&WaveParser::ReaderLoop, this, reverse);
+	reader_running = true;
+#endif
+}
+
+/// @brief 読み込みスレッドを止める
+///
+void WaveParser::StopReader()
+{
+#ifdef PARSEWAV_USE_THREAD
+	if (!reader_running) return;
+
+	reader_stop = true;
+	reader_thread.join();
+	reader_running = false;
+#endif
+}
+
+#ifdef PARSEWAV_USE_THREAD
+/// @brief 読み込みスレッド
+///
+/// 入力ファイルと間引きのワークはこのスレッドだけが使う
+///
+/// @param[in] reverse 波形を反転
+///
+void WaveParser::ReaderLoop(bool reverse)
+{
+	uint8_t buf[WAVE_BLOCK_SIZE];
+	int pos = reader_pos;
+
+	while(pos < reader_end && !reader_stop) {
+		int num = reader_end - pos;
+		if (num > WAVE_BLOCK_SIZE) num = WAVE_BLOCK_SIZE;
+
+		num = ReadWaveBlock(buf, num, reverse);
+
+		// 受け取り側が空けるまで待つ
+		int done = 0;
+		while(done < num && !reader_stop) {
+			done += (int)reader_ring.Write(&buf[done], num - done);
+			if (done < num) std::this_thread::yield();
+		}
+		pos += num;
+	}
+	reader_ring.Close();
+}
+
+/// @brief 読み込みスレッドが変換したサンプルを受け取る
+///
+/// @param[out] dst 変換したサンプル(8ビット)
+/// @param[in]  num 受け取るサンプル数
+/// @return 受け取ったサンプル数 (読み込みスレッドが止まった時は num より少ない)
+///
+int WaveParser::PopWaveBlock(uint8_t *dst, int num)
+{
+	int done = 0;
+	while(done < num) {
+		done += (int)reader_ring.Read(&dst[done], num - done);
+		if (done < num) {
+			if (reader_ring.IsDrained()) break;
+			std::this_thread::yield();
+		}
+	}
+	return done;
+}
+#endif
+
+/// @brief 間引く前の入力サンプルを16ビットで読む
+///
+/// @param[out] dst     読んだサンプル
+/// @param[in]  num     読むサンプル数
+/// @param[in]  reverse 波形を反転
+/// @return 読んだサンプル数 (ファイル終端では num より少ない)
+///
+int WaveParser::ReadDecimateInput(int16_t *dst, int num, bool reverse)
+{
+	decimate_wave_t &dc = st_decim;
+	decode_wave_block16_t decode_block = select_decode_wave_block16(inwav->GetSampleBits(), inwav->GetChannels(), reverse);
+	size_t frame_size = (size_t)(inwav->GetChannels() * inwav->GetSampleBits() / 8);
+
+	if (num > dc.in_num - dc.in_pos) num = dc.in_num - dc.in_pos;
+
+	int cnt = 0;
+	while(cnt < num) {
+		int n = 0;
+		if (decode_block) {
+			size_t len = (size_t)(num - cnt) * frame_size;
+			const uint8_t *p = infile->Fmap(len);
+			n = (int)(len / frame_size);
+			if (n > 0) {
+				decode_block(p, n, &dst[cnt]);
+				infile->Fskip((size_t)n * frame_size);
+			}
+		}
+		if (n <= 0) {
+			// 未対応のフォーマットかファイル終端なので１サンプルずつ
+			n = 1;
+			dst[cnt] = (int16_t)GetWaveSample(2, reverse);
+		}
+		cnt += n;
+	}
+	dc.in_pos += cnt;
+	if (cnt > 0) {
+		dc.last = dst[cnt - 1];
+	}
+	return cnt;
+}
+
+/// @brief 入力をローパスフィルタに通してから間引く
+///
+/// 入力の先頭より前は最初のサンプルが、終端より後は最後のサンプルが続いているとする。
+///
+/// @param[out] dst     間引いたサンプル(8ビット) num個
+/// @param[in]  num     出力するサンプル数
+/// @param[in]  reverse 波形を反転
+///
+void WaveParser::DecimateWave(uint8_t *dst, int num, bool reverse)
+{
+	decimate_wave_t &dc = st_decim;
+	int16_t *buf = &dc.buf[0];
+	const int16_t *coef = &dc.coef[0];
+	const int size = (int)dc.buf.size();
+
+	if (!dc.primed) {
+		int16_t first = 0;
+		ReadDecimateInput(&first, 1, reverse);
+		for(int k = 0; k < dc.half; k++) {
+			buf[k] = first;
+		}
+		dc.pos = 0;
+		dc.len = dc.half;
+		dc.primed = true;
+	}
+
+	for(int n = 0; n < num; n++) {
+		if (dc.pos + dc.taps > dc.len) {
+			if (dc.pos + dc.taps > size) {
+				// 残りをバッファの最初に移す
+				memmove(buf, &buf[dc.pos], (dc.len - dc.pos) * sizeof(int16_t));
+				dc.len -= dc.pos;
+				dc.pos = 0;
+			}
+			dc.len += ReadDecimateInput(&buf[dc.len], size - dc.len, reverse);
+			while(dc.len < dc.pos + dc.taps) {
+				buf[dc.len++] = dc.last;
+			}
+		}
+
+		const int16_t *x = &buf[dc.pos];
+		int32_t sum = 0;
+		for(int k = 0; k < dc.taps; k++) {
+			sum += (int32_t)x[k] * coef[k];
+		}
+		// 16ビット -> 8ビット (四捨五入)
+		int v = (sum + (1 << (RESAMPLE_COEF_BITS + 7))) >> (RESAMPLE_COEF_BITS + 8);
+		if (v < -128) v = -128;
+		else if (v > 127) v = 127;
+		dst[n] = (uint8_t)(v + 128);
+
+		dc.pos += dc.factor;
+	}
+}
+
 /// @brief wavファイルから１サンプルスキップする
 ///
 /// @param[in] dir
@@ -288,7 +1018,15 @@ int WaveParser::SkipWaveSample(int dir)
 	} else if (infile->IsEndPos(dir)) {
 		dir = infile->SampleNum() - infile->SamplePos();
 	}
-	offset = dir * inwav->GetChannels() * in_bits / 8;
+	if (st_decim.factor > 1) {
+		// 先読みした分も含めて間引く前の位置に合わせる
+		int target = (infile->SamplePos() + dir) * st_decim.factor;
+		offset = (target - st_decim.in_pos) * inwav->GetChannels() * in_bits / 8;
+		st_decim.in_pos = target;
+		st_decim.clear();
+	} else {
+		offset = dir * inwav->GetChannels() * in_bits / 8;
+	}
 
 	infile->Fseek(offset, SEEK_CUR);
 
@@ -297,6 +1035,46 @@ int WaveParser::SkipWaveSample(int dir)
 	return dir;
 }
 
+/// 波長の分類ごとのキャリアデータ
+struct lamda_bits_t {
+	int len;			///< キャリアデータの長さ
+	const char *str;	///< キャリアデータ
+	int carr_prev;		///< 波の種類
+	int report;			///< レポートの集計先
+};
+
+/// 波長の分類ごとのキャリアデータ 0:全波 1:半波(l -> h) 2:半波(h -> l)
+static const lamda_bits_t c_lamda_bits[3][LAMDA_CLASS_END] = {
+	{
+		{ 4, "1100",  4, 0 },	// long
+		{ 2, "10",    2, 1 },	// short
+		{ 5, "?1100", 4, 2 },	// middle long
+		{ 3, "?10",   2, 2 },	// middle short
+		{ 2, "??",    0, 5 },	// (middle)
+		{ 5, "?GGLL", 5, 3 },	// too long
+		{ 3, "?GL",   1, 4 },	// too short
+		{ 2, "??",    0, 5 },	// error
+	},{
+		{ 2, "00",   -4, 0 },	// long
+		{ 1, "0",    -2, 1 },	// short
+		{ 2, "??",    0, 5 },	// (middle long)
+		{ 2, "??",    0, 5 },	// (middle short)
+		{ 2, "?0",   -2, 2 },	// middle
+		{ 3, "?LL",  -5, 3 },	// too long
+		{ 2, "?L",   -1, 4 },	// too short
+		{ 2, "??",    0, 5 },	// error
+	},{
+		{ 2, "11",    4, 0 },	// long
+		{ 1, "1",     2, 1 },	// short
+		{ 2, "??",    0, 5 },	// (middle long)
+		{ 2, "??",    0, 5 },	// (middle short)
+		{ 2, "?1",    2, 2 },	// middle
+		{ 3, "?GG",   5, 3 },	// too long
+		{ 2, "?G",    1, 4 },	// too short
+		{ 2, "??",    0, 5 },	// error
+	}
+};
+
 /// @brief 2400Hzと1200Hzの波を見つけてビットデータに変換
 ///
 /// @param[in]   fsk_spd   1:倍速FSK
@@ -304,6 +1082,52 @@ int WaveParser::SkipWaveSample(int dir)
 /// @param[out]  c_data    "10": 2400Hz "1100":1200Hz "?GGLL":Too long
 /// @return bit0:wavバッファのデータが足りない bit1:wavバッファ最後のブロック bit4::carrierバッファに空きがない
 int WaveParser::DecodeToCarrier(int fsk_spd, WaveData *w_data, CarrierData *c_data)
+{
+	if (fsk_spd != decoder_spd || decoder == NULL) {
+		// 初期化時と異なる速度
+		SetDecoder(fsk_spd);
+	}
+	return (this->*decoder)(w_data, c_data);
+}
+
+/// @brief デコード関数を設定
+/// @param[in] fsk_spd 1:倍速FSK
+void WaveParser::SetDecoder(int fsk_spd)
+{
+	decoder_spd = fsk_spd;
+	if (tmp_param->GetDemodType() == 1) {
+		InitIQ(fsk_spd);
+	}
+	decoder = SelectDecoder(fsk_spd, tmp_param->GetHalfWave(), tmp_param->GetDemodType());
+}
+
+/// @brief デコード関数を選択
+/// @param[in] fsk_spd 1:倍速FSK
+/// @param[in] half    半波の場合true
+/// @param[in] demod   0:ゼロクロス 1:相関
+/// @return 関数
+WaveParser::decode_to_carrier_t WaveParser::SelectDecoder(int fsk_spd, bool half, int demod)
+{
+	if (demod == 1) {
+		// 速度ごとの定数はInitIQで設定済み
+		return &WaveParser::DecodeToCarrierIQ;
+	}
+	if (fsk_spd == 1) {
+		return half ? &WaveParser::DecodeToCarrierT<true, 1> : &WaveParser::DecodeToCarrierT<false, 1>;
+	} else {
+		return half ? &WaveParser::DecodeToCarrierT<true, 0> : &WaveParser::DecodeToCarrierT<false, 0>;
+	}
+}
+
+/// @brief 2400Hzと1200Hzの波を見つけてビットデータに変換
+///
+/// 半波/全波とFSK速度ごとに展開する
+///
+/// @param[in]   w_data    WAVサンプルデータ
+/// @param[out]  c_data    "10": 2400Hz "1100":1200Hz "?GGLL":Too long
+/// @return bit0:wavバッファのデータが足りない bit1:wavバッファ最後のブロック bit4::carrierバッファに空きがない
+template<bool HALF, int FSK_SPD>
+int WaveParser::DecodeToCarrierT(WaveData *w_data, CarrierData *c_data)
 {
 	uint8_t bit_data[8];
 	int bit_len = 0;
@@ -319,6 +1143,15 @@ int WaveParser::DecodeToCarrier(int fsk_spd, WaveData *w_data, CarrierData *c_da
 
 	// find next trigger point
 	while(!w_data->IsTail()) {
+		// ゼロをまたがないサンプルはまとめて読み飛ばす
+		int r_pos = w_data->GetReadPos();
+		int skip = w_data->FindZeroCross(r_pos, st_pa_carr.wav_prev, HALF) - r_pos;
+		if (skip > 0) {
+			st_pa_carr.sample_cnt += skip;
+			st_pa_carr.wav_prev = (int)w_data->AtData(r_pos + skip - 1) - 128;
+			w_data->AddReadPos(skip);
+			if (w_data->IsTail()) break;
+		}
 		sample_data = w_data->GetRead();
 		w_data->IncreaseReadPos();
 		data = (int)sample_data.Data() - 128;
@@ -329,19 +1162,19 @@ int WaveParser::DecodeToCarrier(int fsk_spd, WaveData *w_data, CarrierData *c_da
 			x0 = - (st_pa_carr.wav_prev * st_lamda.us_delta / (data - st_pa_carr.wav_prev));
 			lamda = st_pa_carr.x0_prev + (st_pa_carr.sample_cnt * st_lamda.us_delta) + x0;
 			// 波長が短すぎる場合はノイズと判断して処理継続
-			if (lamda >= st_lamda.us_limit[fsk_spd]) {
+			if (lamda >= st_lamda.us_limit[FSK_SPD]) {
 				st_pa_carr.x0_prev = st_lamda.us_delta - x0;
 				st_pa_carr.odd = 1 - st_pa_carr.odd;
 				found = true;
 				break;
 			}
-		} else if (st_pa_carr.wav_prev > 0 && data <= 0 && tmp_param->GetHalfWave()) {
+		} else if (st_pa_carr.wav_prev > 0 && data <= 0 && HALF) {
 			// h -> l になる位置から波長(us)を求める
 			hi = false;
 			x0 = - (st_pa_carr.wav_prev * st_lamda.us_delta / (data - st_pa_carr.wav_prev));
 			lamda = st_pa_carr.x0_prev + (st_pa_carr.sample_cnt * st_lamda.us_delta) + x0;
 			// 波長が短すぎる場合はノイズと判断して処理継続
-			if (lamda >= st_lamda.us_limit[fsk_spd]) {
+			if (lamda >= st_lamda.us_limit[FSK_SPD]) {
 				st_pa_carr.x0_prev = st_lamda.us_delta - x0;
 				st_pa_carr.odd = 1 - st_pa_carr.odd;
 				found = true;
@@ -356,202 +1189,61 @@ int WaveParser::DecodeToCarrier(int fsk_spd, WaveData *w_data, CarrierData *c_da
 		return rc;
 	}
 
-	if (!tmp_param->GetHalfWave()) {
-		// 全波
-		if (st_lamda.us_min[fsk_spd] <= lamda && lamda <= st_lamda.us_max[fsk_spd]) {
-			// long (half wave)
-			bit_len = 4;
-			memcpy(bit_data, "1100", bit_len);
-			st_pa_carr.carr_prev = 4;
-			st_lamda.us_avg[fsk_spd] = (st_lamda.us_avg[fsk_spd] + lamda) / 2.0;
-
-#ifdef PARSEWAV_USE_REPORT
-			rep1.IncSampleNum(0);
-#endif
-		}
-		else if (st_lamda.us_min[fsk_spd+1] <= lamda && lamda <= st_lamda.us_max[fsk_spd+1]) {
-			// short (half wave)
-			bit_len = 2;
-			memcpy(bit_data, "10", bit_len);
-			st_pa_carr.carr_prev = 2;
-			st_lamda.us_avg[fsk_spd+1] = (st_lamda.us_avg[fsk_spd+1] + lamda) / 2.0;
-
-#ifdef PARSEWAV_USE_REPORT
-			rep1.IncSampleNum(1);
-#endif
-		}
-		else if (st_lamda.us_mid[fsk_spd] <= lamda && lamda < st_lamda.us_min[fsk_spd]) {
-			// middle long
-			bit_len = 5;
-			memcpy(bit_data, "?1100", bit_len);
-			st_pa_carr.carr_prev = 4;
-			st_lamda.us_mid_avg[fsk_spd] = (st_lamda.us_mid_avg[fsk_spd] + lamda) / 2.0;
-
-#ifdef PARSEWAV_USE_REPORT
-			rep1.IncSampleNum(2);
-#endif
-		}
-		else if (st_lamda.us_max[fsk_spd+1] < lamda && lamda < st_lamda.us_mid[fsk_spd]) {
-			// middle short
-			bit_len = 3;
-			memcpy(bit_data, "?10", bit_len);
-			st_pa_carr.carr_prev = 2;
-			st_lamda.us_mid_avg[fsk_spd] = (st_lamda.us_mid_avg[fsk_spd] + lamda) / 2.0;
-
-#ifdef PARSEWAV_USE_REPORT
-			rep1.IncSampleNum(2);
-#endif
-		}
-		else if (st_lamda.us_max[fsk_spd] < lamda) {
-			// too long
-			bit_len = 5;
-			memcpy(bit_data, "?GGLL", bit_len);
-			st_pa_carr.carr_prev = 5;
-
-#ifdef PARSEWAV_USE_REPORT
-			rep1.IncSampleNum(3);
-#endif
-		}
-		else if (lamda < st_lamda.us_min[fsk_spd+1]) {
-			// too short
-			bit_len = 3;
-			memcpy(bit_data, "?GL", bit_len);
-			st_pa_carr.carr_prev = 1;
-
-#ifdef PARSEWAV_USE_REPORT
-			rep1.IncSampleNum(4);
-#endif
-		}
-		else {
-			// error
-			bit_len = 2;
-			memcpy(bit_data, "??", bit_len);
-			st_pa_carr.carr_prev = 0;
-
-#ifdef PARSEWAV_USE_REPORT
-			rep1.IncSampleNum(5);
-#endif
-		}
-	} else {
-		// 半波
-		if (st_lamda.us_min[fsk_spd] <= lamda && lamda <= st_lamda.us_max[fsk_spd]) {
-			// long (half wave)
-			if (hi) {
-				bit_len = 2;
-				memcpy(bit_data, "00", bit_len);
-				if (st_pa_carr.carr_prev != 4) st_pa_carr.odd = 1;
+	const bool half = HALF;
+	int cls = LookupLamda(FSK_SPD, half, lamda);
+	const lamda_bits_t *bits = &c_lamda_bits[half ? (hi ? 1 : 2) : 0][cls];
+
+	bit_len = bits->len;
+	memcpy(bit_data, bits->str, bit_len);
+	if (cls == LAMDA_MIDDLE) {
+		// 前の波によって長さが変わる
+		if (hi) {
+			if ((st_pa_carr.odd == 0 && st_pa_carr.carr_prev == 4)
+			 || (st_pa_carr.odd == 1 && st_pa_carr.carr_prev == 2)) {
+				bit_len = 3;
+				memcpy(bit_data, "?00", bit_len);
 				st_pa_carr.carr_prev = -4;
 			} else {
-				bit_len = 2;
-				memcpy(bit_data, "11", bit_len);
-				if (st_pa_carr.carr_prev != -4) st_pa_carr.odd = 1;
-				st_pa_carr.carr_prev = 4;
-			}
-			st_lamda.us_avg[fsk_spd] = (st_lamda.us_avg[fsk_spd] + lamda) / 2.0;
-
-#ifdef PARSEWAV_USE_REPORT
-			rep1.IncSampleNum(0);
-//			check_new_ptn(0);
-#endif
-		}
-		else if (st_lamda.us_min[fsk_spd+1] <= lamda && lamda <= st_lamda.us_max[fsk_spd+1]) {
-			// short (half wave)
-			if (hi) {
-				bit_len = 1;
-				memcpy(bit_data, "0", bit_len);
-				if (st_pa_carr.carr_prev != 2) st_pa_carr.odd = 1;
 				st_pa_carr.carr_prev = -2;
-			} else {
-				bit_len = 1;
-				memcpy(bit_data, "1", bit_len);
-				if (st_pa_carr.carr_prev != -2) st_pa_carr.odd = 1;
-				st_pa_carr.carr_prev = 2;
-			}
-			st_lamda.us_avg[fsk_spd+1] = (st_lamda.us_avg[fsk_spd+1] + lamda) / 2.0;
-
-#ifdef PARSEWAV_USE_REPORT
-			rep1.IncSampleNum(1);
-//			check_new_ptn(1);
-#endif
-		}
-		else if (st_lamda.us_max[fsk_spd+1] < lamda && lamda < st_lamda.us_min[fsk_spd]) {
-			// middle
-			if (hi) {
-				if ((st_pa_carr.odd == 0 && st_pa_carr.carr_prev == 4)
-				 || (st_pa_carr.odd == 1 && st_pa_carr.carr_prev == 2)) {
-					bit_len = 3;
-					memcpy(bit_data, "?00", bit_len);
-					st_pa_carr.carr_prev = -4;
-				} else {
-					bit_len = 2;
-					memcpy(bit_data, "?0", bit_len);
-					st_pa_carr.carr_prev = -2;
-				}
-			} else {
-				if ((st_pa_carr.odd == 0 && st_pa_carr.carr_prev == -4)
-				 || (st_pa_carr.odd == 1 && st_pa_carr.carr_prev == -2)) {
-					bit_len = 3;
-					memcpy(bit_data, "?11", bit_len);
-					st_pa_carr.carr_prev = 4;
-				} else {
-					bit_len = 2;
-					memcpy(bit_data, "?1", bit_len);
-					st_pa_carr.carr_prev = 2;
-				}
 			}
-			st_lamda.us_mid_avg[fsk_spd] = (st_lamda.us_mid_avg[fsk_spd] + lamda) / 2.0;
-
-#ifdef PARSEWAV_USE_REPORT
-			rep1.IncSampleNum(2);
-//			check_new_ptn(2);
-#endif
-		}
-		else if (st_lamda.us_max[fsk_spd] < lamda) {
-			// too long
-			if (hi) {
+		} else {
+			if ((st_pa_carr.odd == 0 && st_pa_carr.carr_prev == -4)
+			 || (st_pa_carr.odd == 1 && st_pa_carr.carr_prev == -2)) {
 				bit_len = 3;
-				memcpy(bit_data, "?LL", bit_len);
-				st_pa_carr.carr_prev = -5;
+				memcpy(bit_data, "?11", bit_len);
+				st_pa_carr.carr_prev = 4;
 			} else {
-				bit_len = 3;
-				memcpy(bit_data, "?GG", bit_len);
-				st_pa_carr.carr_prev = 5;
+				st_pa_carr.carr_prev = 2;
 			}
-
-#ifdef PARSEWAV_USE_REPORT
-			rep1.IncSampleNum(3);
-//			check_new_ptn(3);
-#endif
 		}
-		else if (lamda < st_lamda.us_min[fsk_spd+1]) {
-			// too short
-			if (hi) {
-				bit_len = 2;
-				memcpy(bit_data, "?L", bit_len);
-				st_pa_carr.carr_prev = -1;
-			} else {
-				bit_len = 2;
-				memcpy(bit_data, "?G", bit_len);
-				st_pa_carr.carr_prev = 1;
-			}
-
-#ifdef PARSEWAV_USE_REPORT
-			rep1.IncSampleNum(4);
-//			check_new_ptn(4);
-#endif
+	} else {
+		if (half && (cls == LAMDA_LONG || cls == LAMDA_SHORT)) {
+			// 波の向きが変わっていない
+			if (st_pa_carr.carr_prev != -bits->carr_prev) st_pa_carr.odd = 1;
 		}
-		else {
-			// error
-			bit_len = 2;
-			memcpy(bit_data, "??", bit_len);
-			st_pa_carr.carr_prev = 0;
+		st_pa_carr.carr_prev = bits->carr_prev;
+	}
+
+	// 平均値を更新
+	switch(cls) {
+	case LAMDA_LONG:
+		st_lamda.us_avg[FSK_SPD] = (st_lamda.us_avg[FSK_SPD] + lamda) / 2.0;
+		break;
+	case LAMDA_SHORT:
+		st_lamda.us_avg[FSK_SPD+1] = (st_lamda.us_avg[FSK_SPD+1] + lamda) / 2.0;
+		break;
+	case LAMDA_MID_LONG:
+	case LAMDA_MID_SHORT:
+	case LAMDA_MIDDLE:
+		st_lamda.us_mid_avg[FSK_SPD] = (st_lamda.us_mid_avg[FSK_SPD] + lamda) / 2.0;
+		break;
+	default:
+		break;
+	}
 
 #ifdef PARSEWAV_USE_REPORT
-			rep1.IncSampleNum(5);
-//			check_new_ptn(5);
+	rep1.IncSampleNum(bits->report);
 #endif
-		}
-	}
 
 	// 一定間隔を覚えておく
 	mile_stone->ModifyMarkIfNeed(prev_cross.SPos());
@@ -563,13 +1255,13 @@ int WaveParser::DecodeToCarrier(int fsk_spd, WaveData *w_data, CarrierData *c_da
 
 		if (tmp_param->GetDebugMode() > 1) {
 			// デバッグログ
-			gLogFile.Fprintf("p1 w:%10d(%s) %2d %3.6f "
+			logfile->Fprintf("p1 w:%10d(%s) %2d %3.6f "
 				, prev_cross.SPos()
-				, UTILS::get_time_cstr(infile->CalcrateSampleUSec(prev_cross.SPos()))
+				, UTILS::get_time_str(infile->CalcrateSampleUSec(prev_cross.SPos())).c_str()
 				, st_pa_carr.sample_cnt
 				, lamda);
-			gLogFile.Fwrite(bit_data, sizeof(uint8_t), bit_len);
-			gLogFile.Fputc('\n');
+			logfile->Fwrite(bit_data, sizeof(uint8_t), bit_len);
+			logfile->Fputc('\n');
 		}
 	} else {
 		// NG data
@@ -577,13 +1269,13 @@ int WaveParser::DecodeToCarrier(int fsk_spd, WaveData *w_data, CarrierData *c_da
 
 		if (tmp_param->GetDebugMode() > 1) {
 			// デバッグログ
-			gLogFile.Fprintf("p1 w:%10d(%s) %2d %3.6f "
+			logfile->Fprintf("p1 w:%10d(%s) %2d %3.6f "
 				, prev_cross.SPos()
-				, UTILS::get_time_cstr(infile->CalcrateSampleUSec(prev_cross.SPos()))
+				, UTILS::get_time_str(infile->CalcrateSampleUSec(prev_cross.SPos())).c_str()
 				, st_pa_carr.sample_cnt
 				, lamda);
-			gLogFile.Fwrite(bit_data, sizeof(uint8_t), bit_len);
-			gLogFile.Fputc('\n');
+			logfile->Fwrite(bit_data, sizeof(uint8_t), bit_len);
+			logfile->Fputc('\n');
 		}
 	}
 
@@ -597,6 +1289,269 @@ int WaveParser::DecodeToCarrier(int fsk_spd, WaveData *w_data, CarrierData *c_da
 	return rc;
 }
 
+/// @brief 4組の係数との積和をまとめて求める
+/// @param[in]  x    データ
+/// @param[in]  coef 係数(len個ずつ4組)
+/// @param[in]  len  長さ(4の倍数)
+/// @param[out] sum  4組の積和
+static void iq_correlate(const float *x, const float *coef, int len, float *sum)
+{
+#ifdef WAVEPARSER_USE_SSE2
+	__m128 s[4];
+	for(int k = 0; k < 4; k++) {
+		s[k] = _mm_setzero_ps();
+	}
+	for(int i = 0; i < len; i += 4) {
+		__m128 xv = _mm_loadu_ps(x + i);
+		for(int k = 0; k < 4; k++) {
+			s[k] = _mm_add_ps(s[k], _mm_mul_ps(xv, _mm_loadu_ps(coef + k * len + i)));
+		}
+	}
+	for(int k = 0; k < 4; k++) {
+		float v[4];
+		_mm_storeu_ps(v, s[k]);
+		sum[k] = (v[0] + v[1]) + (v[2] + v[3]);
+	}
+#else
+	for(int k = 0; k < 4; k++) {
+		const float *c = coef + k * len;
+		float v[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for(int i = 0; i < len; i += 4) {
+			v[0] += x[i] * c[i];
+			v[1] += x[i + 1] * c[i + 1];
+			v[2] += x[i + 2] * c[i + 2];
+			v[3] += x[i + 3] * c[i + 3];
+		}
+		sum[k] = (v[0] + v[1]) + (v[2] + v[3]);
+	}
+#endif
+}
+
+/// @brief 相関による復調の初期処理
+///
+/// 長い方の波1周期分を窓として、2つの周波数の余弦・正弦との相関を求める係数を作る
+///
+/// @param[in] fsk_spd 1:倍速FSK
+void WaveParser::InitIQ(int fsk_spd)
+{
+	parse_iq_t &iq = st_pa_iq;
+	double rate = (double)GetSampleRate();
+
+	iq.clear();
+	iq.unit[0] = rate / (double)param->GetFreq(fsk_spd) / 2.0;
+	iq.unit[1] = rate / (double)param->GetFreq(fsk_spd + 1) / 2.0;
+	iq.win = (int)(iq.unit[0] * IQ_WIN_MUL + 0.5);
+	if (iq.win < 4) iq.win = 4;
+	iq.win4 = (iq.win + 3) & ~3;
+	iq.step = (int)(iq.unit[1] / 2.0);
+	if (iq.step < 1) iq.step = 1;
+
+	iq.coef.assign(iq.win4 * 4, 0.0f);
+	iq.xbuf.assign(iq.win4, 0.0f);
+	for(int k = 0; k < 2; k++) {
+		double w = M_PI / iq.unit[k];
+		for(int i = 0; i < iq.win; i++) {
+			iq.coef[(k * 2) * iq.win4 + i] = (float)cos(w * i);
+			iq.coef[(k * 2 + 1) * iq.win4 + i] = (float)sin(w * i);
+		}
+	}
+	// 振幅8未満は無音とみなす
+	iq.thres = (float)(8.0 * iq.win / 2.0) * (float)(8.0 * iq.win / 2.0);
+}
+
+/// @brief 指定位置の窓で2つの周波数の強さを比べる
+/// @param[in] w_data WAVサンプルデータ
+/// @param[in] pos    窓の先頭位置
+/// @return 0:無音 1:long 2:short
+int WaveParser::CorrelateIQ(WaveData *w_data, int pos)
+{
+	parse_iq_t &iq = st_pa_iq;
+	float sum[4];
+
+	for(int i = 0; i < iq.win; i++) {
+		iq.xbuf[i] = (float)((int)w_data->AtData(pos + i) - 128);
+	}
+	iq_correlate(&iq.xbuf[0], &iq.coef[0], iq.win4, sum);
+
+	float e_long = sum[0] * sum[0] + sum[1] * sum[1];
+	float e_short = sum[2] * sum[2] + sum[3] * sum[3];
+	if (e_long < iq.thres && e_short < iq.thres) {
+		return 0;
+	}
+	return (e_long >= e_short ? 1 : 2);
+}
+
+/// @brief 判定結果から波の続いている長さを更新する
+///
+/// 同じ判定が2回続いたら波が切り替わったとみなす。
+/// 半波が短すぎない時は交点の位置と向きから切り替わり位置と最初の半波を決める。
+///
+/// @param[in] w_data WAVサンプルデータ
+/// @param[in] pos    判定した窓の先頭位置
+/// @param[in] tone   0:無音 1:long 2:short
+void WaveParser::UpdateIQRun(WaveData *w_data, int pos, int tone)
+{
+	parse_iq_t &iq = st_pa_iq;
+
+	if (tone == iq.tone) {
+		iq.cand_cnt = 0;
+		iq.run_len += iq.step;
+		return;
+	}
+	if (tone != iq.cand || iq.cand_cnt == 0) {
+		iq.cand = tone;
+		iq.cand_cnt = 0;
+		// 窓の中央から始まるとする
+		int mid = pos + iq.win / 2;
+		iq.cand_spos = w_data->AtSPos(mid);
+		iq.cand_phase = (tone != 0 ? -1 : 1);
+		if (tone != 0 && iq.unit[1] >= IQ_SNAP_MIN_SAMPLES) {
+			// 中央に最も近い交点を切り替わり位置とする
+			// shortは判定が半波の半分ほど遅れるので戻して探す
+			int c = mid - (tone == 2 ? (int)(iq.unit[1] / 2.0 + 0.5) : 0);
+			int found = -1;
+			for(int d = 0; d < iq.win / 2 && found < 0; d++) {
+				for(int sgn = -1; sgn <= 1 && found < 0; sgn += 2) {
+					int i = c + sgn * d;
+					if (i <= pos || i >= pos + iq.win) continue;
+					if ((w_data->AtData(i - 1) >= 128) == (w_data->AtData(i) >= 128)) continue;
+					found = i;
+				}
+			}
+			if (found >= 0) {
+				iq.cand_spos = w_data->AtSPos(found);
+				// 最初の半波の向き
+				iq.cand_phase = (w_data->AtData(found) >= 128 ? 1 : 0);
+			}
+		}
+	}
+	iq.cand_cnt++;
+	if (iq.cand_cnt < 2) {
+		// まだ前の波とする
+		iq.run_len += iq.step;
+		return;
+	}
+
+	// 切り替わった
+	iq.run_len = (double)(iq.cand_spos - iq.run_spos);
+	CloseIQRun();
+	iq.tone = tone;
+	iq.run_len = (double)(w_data->AtSPos(pos + iq.win / 2) - iq.cand_spos);
+	iq.run_spos = iq.cand_spos;
+	iq.run_phase = iq.cand_phase;
+	iq.cand_cnt = 0;
+}
+
+/// @brief 続いていた波の長さから出力する波の数を決める
+void WaveParser::CloseIQRun()
+{
+	parse_iq_t &iq = st_pa_iq;
+
+	double len = iq.run_len + iq.carry;
+	double unit = (iq.tone == 2 ? iq.unit[1] : iq.unit[0]);
+	int num = (int)(len / unit + 0.5);
+	if (num < 0) num = 0;
+	if (iq.tone == 0) {
+		// 無音は1つにまとめる
+		if (num > 1) num = 1;
+		iq.carry = 0.0;
+	} else {
+		iq.carry = len - num * unit;
+	}
+	iq.pend_tone = iq.tone;
+	iq.pend_num = num;
+	iq.pend_spos = iq.run_spos;
+	if (iq.run_phase >= 0) iq.phase = iq.run_phase;
+	iq.run_len = 0.0;
+}
+
+/// @brief 相関により2400Hzと1200Hzの波を見つけてビットデータに変換
+///
+/// 補正は行わず、窓をずらしながら2つの周波数のどちらが強いかを判定し、
+/// 続いた長さから半波の数を求める。1回の呼び出しで半波1つ分を出力する。
+///
+/// @param[in]   w_data    WAVサンプルデータ
+/// @param[out]  c_data    "1","0": 2400Hz "11","00":1200Hz "GGLL"(エラー):無音
+/// @return bit0:wavバッファのデータが足りない bit1:wavバッファ最後のブロック bit4::carrierバッファに空きがない
+int WaveParser::DecodeToCarrierIQ(WaveData *w_data, CarrierData *c_data)
+{
+	parse_iq_t &iq = st_pa_iq;
+	int rc = 0;
+
+	while(iq.pend_num <= 0) {
+		int pos = w_data->GetReadPos();
+		if (pos + iq.win > w_data->GetWritePos()) {
+			if (!w_data->IsLastData()) {
+				// データが足りない
+				return 0x01;
+			}
+			if (iq.run_len > 0.0) {
+				// 最後の波
+				CloseIQRun();
+				continue;
+			}
+			w_data->AddReadPos(w_data->GetWritePos() - pos);
+			return 0x03;
+		}
+		UpdateIQRun(w_data, pos, CorrelateIQ(w_data, pos));
+		w_data->AddReadPos(iq.step);
+	}
+
+	// 半波1つ分を出力
+	const uint8_t *bit_data;
+	int bit_len;
+	int spos = (int)iq.pend_spos;
+	switch(iq.pend_tone) {
+	case 1:
+		bit_data = (const uint8_t *)(iq.phase ? "11" : "00");
+		bit_len = 2;
+		iq.phase = 1 - iq.phase;
+		break;
+	case 2:
+		bit_data = (const uint8_t *)(iq.phase ? "1" : "0");
+		bit_len = 1;
+		iq.phase = 1 - iq.phase;
+		break;
+	default:
+		bit_data = (const uint8_t *)"GGLL";
+		bit_len = 4;
+		iq.phase = 1;
+		break;
+	}
+
+	// 一定間隔を覚えておく
+	mile_stone->ModifyMarkIfNeed(spos);
+
+	if (iq.pend_tone != 0) {
+		c_data->AddString(bit_data, bit_len, spos);
+	} else {
+		c_data->AddString(bit_data, bit_len, spos, 0, 0x8);
+	}
+
+#ifdef PARSEWAV_USE_REPORT
+	rep1.IncSampleNum(iq.pend_tone == 1 ? 0 : (iq.pend_tone == 2 ? 1 : 3));
+#endif
+
+	double unit = (iq.pend_tone == 2 ? iq.unit[1] : iq.unit[0]);
+	if (tmp_param->GetDebugMode() > 1) {
+		// デバッグログ
+		logfile->Fprintf("p1 w:%10d(%s) %2d %3.6f "
+			, spos
+			, UTILS::get_time_str(infile->CalcrateSampleUSec(spos)).c_str()
+			, iq.pend_num
+			, unit * st_lamda.us_delta);
+		logfile->Fwrite(bit_data, sizeof(uint8_t), bit_len);
+		logfile->Fputc('\n');
+	}
+
+	iq.pend_spos += unit;
+	iq.pend_num--;
+
+	rc = w_data->IsLastData() ? (w_data->IsTail() ? 0x03 : 0x02) : (w_data->IsTail(iq.win) ? 0x01 : 0);
+	rc |= (c_data->IsFull(4) ? 0x10 : 0);
+	return rc;
+}
+
 #if 0
 void WaveParser::check_new_ptn(int ptn)
 {
@@ -648,6 +1603,171 @@ int WaveParser::EncodeToWave(CarrierData *c_data, uint8_t *w_data, int len)
 	return pos;
 }
 
+/// @brief 搬送波から直接waveを合成する初期処理
+///
+/// @param[in] rate     出力サンプルレート
+/// @param[in] blk_size 出力サンプルバイト(1 or 2)
+void WaveParser::InitEncodeToWave(int rate, int blk_size)
+{
+	synth_wave_t &sy = st_synth;
+
+	if (sy.rate != rate || sy.blk_size != blk_size) {
+		sy.rate = rate;
+		sy.blk_size = blk_size;
+		sy.fsk_spd = -1;
+	}
+	sy.clear();
+}
+
+/// @brief 出力レートで合成するためのテーブルを作成
+///
+/// 48000Hzの波形(EncodeToWaveと同じ)を出力サンプルの区間ごとに平均した値を、
+/// 搬送波の値と前後の搬送波が異なるかどうか、出力サンプル内の開始位置ごとに求めておく。
+/// 時間単位は 1 / (48000 * 出力レート) 秒。
+///
+/// @param[in] fsk_spd 1:倍速FSK
+void WaveParser::MakeSynthTable(int fsk_spd)
+{
+	synth_wave_t &sy = st_synth;
+	int last = fsk_spd ? 5 : 10;
+
+	sy.fsk_spd = fsk_spd;
+	sy.sym_len = last * sy.rate;
+	sy.out_len = 48000;
+	int a = sy.sym_len;
+	int b = sy.out_len;
+	while(b != 0) {
+		int t = a % b;
+		a = b;
+		b = t;
+	}
+	sy.phase_unit = a;
+	int phases = sy.out_len / sy.phase_unit;
+	sy.width = (sy.out_len - sy.phase_unit + sy.sym_len + sy.out_len - 1) / sy.out_len;
+
+	sy.table.assign(8 * phases * sy.width, 0);
+	for(int type = 0; type < 8; type++) {
+		int val = (type >> 2) & 1;
+		bool edge_s = ((type & 2) != 0);
+		bool edge_e = ((type & 1) != 0);
+		for(int ph = 0; ph < phases; ph++) {
+			int32_t *t = &sy.table[(type * phases + ph) * sy.width];
+			int s0 = ph * sy.phase_unit;
+			for(int j = 0; j < last; j++) {
+				int amp = ((j == 0 && edge_s) || (j == last - 1 && edge_e)) ? 0x6c : 0x70;
+				if (!val) amp = -amp;
+				// 48000Hzの1サンプルが重なる出力サンプルに振り分ける
+				int from = s0 + j * sy.rate;
+				int to = from + sy.rate;
+				while(from < to) {
+					int i = from / sy.out_len;
+					int end = (i + 1) * sy.out_len;
+					if (end > to) end = to;
+					t[i] += amp * (end - from);
+					from = end;
+				}
+			}
+		}
+	}
+	sy.acc.assign(sy.width + 1, 0);
+}
+
+/// @brief 出力待ちのサンプルをファイルに出力
+///
+/// @param[in] num      出力するサンプル数
+/// @param[in,out] file 出力ファイル
+void WaveParser::OutSynthSamples(int num, OutputFile &file)
+{
+	synth_wave_t &sy = st_synth;
+	uint8_t buf[64];
+	int len = 0;
+	const int64_t ofs = (int64_t)128 * sy.out_len;
+
+	for(int i = 0; i < num; i++) {
+		int64_t v = (int64_t)sy.acc[i] + ofs;
+		if (sy.blk_size == 1) {
+			v = (v + sy.out_len / 2) / sy.out_len;
+			if (v > 255) v = 255;
+			buf[len++] = (uint8_t)v;
+		} else {
+			v = (v * 256 + sy.out_len / 2) / sy.out_len - 32768;
+			if (v > 32767) v = 32767;
+			int16_t d = (int16_t)v;
+			memcpy(&buf[len], &d, sizeof(int16_t));
+			len += 2;
+		}
+		if (len >= (int)sizeof(buf) - 2) {
+			file.Write(buf, len);
+			len = 0;
+		}
+	}
+	if (len > 0) {
+		file.Write(buf, len);
+	}
+	// 残りを前につめる
+	int rest = (int)sy.acc.size() - num;
+	memmove(&sy.acc[0], &sy.acc[num], rest * sizeof(int32_t));
+	memset(&sy.acc[rest], 0, num * sizeof(int32_t));
+}
+
+/// @brief 搬送波ビットデータから出力レートのwaveサンプルデータを直接作成してファイルに出力
+///
+/// 48000Hzで作成してからレート変換するかわりに、テーブルの値を足し合わせる。
+///
+/// @param[in]  c_data  搬送波データ
+/// @param[in]  remain  バッファに残しておく搬送波の数
+/// @param[in]  max_num 一度に変換する最大数
+/// @param[out] file    出力ファイル
+/// @return 変換した搬送波の数
+int WaveParser::EncodeToWave(CarrierData *c_data, int remain, int max_num, OutputFile &file)
+{
+	synth_wave_t &sy = st_synth;
+	int fsk_spd = param->GetFskSpeed() ? 1 : 0;
+	int num = 0;
+
+	if (sy.fsk_spd != fsk_spd) {
+		MakeSynthTable(fsk_spd);
+	}
+	int phases = sy.out_len / sy.phase_unit;
+
+	while(num < max_num && !c_data->IsTail(remain)) {
+		int val = (c_data->GetRead().Data() & 1);
+		int edge_s = (sy.prev != val ? 1 : 0);
+		int edge_e = (c_data->GetReadPos() >= c_data->GetWritePos() - 1
+			|| (c_data->GetRead(1).Data() & 1) != val) ? 1 : 0;
+		int type = (val << 2) | (edge_s << 1) | edge_e;
+
+		const int32_t *t = &sy.table[(type * phases + sy.start / sy.phase_unit) * sy.width];
+		for(int i = 0; i < sy.width; i++) {
+			sy.acc[i] += t[i];
+		}
+		sy.start += sy.sym_len;
+		int done = sy.start / sy.out_len;
+		sy.start %= sy.out_len;
+		if (done > 0) {
+			OutSynthSamples(done, file);
+		}
+
+		sy.prev = val;
+		c_data->IncreaseReadPos();
+		num++;
+	}
+	return num;
+}
+
+/// @brief 合成して出力待ちになっているサンプルをファイルに出力
+///
+/// @param[out] file 出力ファイル
+void WaveParser::FlushEncodeToWave(OutputFile &file)
+{
+	synth_wave_t &sy = st_synth;
+
+	if (sy.start > 0 && sy.acc.size() > 0) {
+		OutSynthSamples(1, file);
+	}
+	sy.clear();
+}
+
 /// @brief 事前のサンプリング位置をセット
 void WaveParser::SetPrevCross(int spos_)
 {
@@ -656,77 +1776,79 @@ void WaveParser::SetPrevCross(int spos_)
 
 #ifdef PARSEWAV_USE_REPORT
 /// @brief デコード時のレポート
-void WaveParser::DecordingReport(wxString &buff, wxString *logbuf)
+void WaveParser::DecordingReport(std::string &buff, std::string *logbuf)
 {
 	int spd = param->GetFskSpeed();
 
-	gLogFile.SetLogBuf(logbuf);
-
-	buff = _T(" [ wav -> l3c ]");
-	gLogFile.Write(buff, 1);
-	buff.Printf(_T("  Wave Type: %s"), (spd ? _T("Double Speed FSK") : _T("Standard FSK")));
-	gLogFile.Write(buff, 1);
-	buff.Printf(_T("  Detection: %s"),(param->GetHalfWave() ? _T("Half wave") : _T("Full wave")));
-	gLogFile.Write(buff, 1);
-	buff.Printf(_T("  Range: Long(0) : %2d%% (%3.3fus(%6.1fHz) - %3.3fus(%6.1fHz) - %3.3fus(%6.1fHz))")
+	logfile->SetLogBuf(logbuf);
+
+	buff = " [ wav -> l3c ]";
+	logfile->Write(buff, 1);
+	UTILS::str_printf(buff, "  Wave Type: %s", (spd ? "Double Speed FSK" : "Standard FSK"));
+	logfile->Write(buff, 1);
+	UTILS::str_printf(buff, "  Detection: %s",(param->GetHalfWave() ? "Half wave" : "Full wave"));
+	logfile->Write(buff, 1);
+	UTILS::str_printf(buff, "  Demodulation: %s",(tmp_param->GetDemodType() == 1 ? "Correlation" : "Zero cross"));
+	logfile->Write(buff, 1);
+	UTILS::str_printf(buff, "  Range: Long(0) : %2d%% (%3.3fus(%6.1fHz) - %3.3fus(%6.1fHz) - %3.3fus(%6.1fHz))"
 		,param->GetRange(0)
 		,st_lamda.us_max[spd],	(1000000.0 / st_lamda.us_max[spd])
 		,st_lamda.us[spd],		(1000000.0 / st_lamda.us[spd])
 		,st_lamda.us_min[spd],  (1000000.0 / st_lamda.us_min[spd])
 	);
-	gLogFile.Write(buff, 1);
-	buff.Printf(_T("  Range: Short(1): %2d%% (%3.3fus(%6.1fHz) - %3.3fus(%6.1fHz) - %3.3fus(%6.1fHz))")
+	logfile->Write(buff, 1);
+	UTILS::str_printf(buff, "  Range: Short(1): %2d%% (%3.3fus(%6.1fHz) - %3.3fus(%6.1fHz) - %3.3fus(%6.1fHz))"
 		,param->GetRange(1)
 		,st_lamda.us_max[spd+1],(1000000.0 / st_lamda.us_max[spd+1])
 		,st_lamda.us[spd+1],	(1000000.0 / st_lamda.us[spd+1])
 		,st_lamda.us_min[spd+1],(1000000.0 / st_lamda.us_min[spd+1])
 	);
-	gLogFile.Write(buff, 1);
-	buff.Printf(_T("  Wave Reverse: %s"),(param->GetReverseWave() ? _T("on") : _T("off")));
-	gLogFile.Write(buff, 1);
-	buff.Printf(_T("  Correct: %s"),(param->GetCorrectType() > 0 ? _T("on") : _T("off")));
-	gLogFile.Write(buff, 1);
+	logfile->Write(buff, 1);
+	UTILS::str_printf(buff, "  Wave Reverse: %s",(param->GetReverseWave() ? "on" : "off"));
+	logfile->Write(buff, 1);
+	UTILS::str_printf(buff, "  Correct: %s",(param->GetCorrectType() > 0 ? "on" : "off"));
+	logfile->Write(buff, 1);
 	if (param->GetCorrectType() > 0) {
-		buff.Printf(_T("  Correct Type: %s"),(param->GetCorrectType() == 2 ? _T("sin wave") : _T("cos wave")));
-		gLogFile.Write(buff, 1);
+		UTILS::str_printf(buff, "  Correct Type: %s",(param->GetCorrectType() == 2 ? "sin wave" : "cos wave"));
+		logfile->Write(buff, 1);
 	}
-	buff = _T("  Wave Sum:");
-	gLogFile.Write(buff, 1);
+	buff = "  Wave Sum:";
+	logfile->Write(buff, 1);
 
-	buff.Printf(_T("    Long(0) : %8d Cent:%6.1fHz Avg:%6.1fHz")
+	UTILS::str_printf(buff, "    Long(0) : %8d Cent:%6.1fHz Avg:%6.1fHz"
 		, rep1.GetSampleNum(0)
 		, 1000000.0 / st_lamda.us[spd]
 		, 1000000.0 / st_lamda.us_avg[spd]);
-	gLogFile.Write(buff, 1);
-	buff.Printf(_T("    Short(1): %8d Cent:%6.1fHz Avg:%6.1fHz")
+	logfile->Write(buff, 1);
+	UTILS::str_printf(buff, "    Short(1): %8d Cent:%6.1fHz Avg:%6.1fHz"
 		, rep1.GetSampleNum(1)
 		, 1000000.0 / st_lamda.us[spd+1]
 		, 1000000.0 / st_lamda.us_avg[spd+1]);
-	gLogFile.Write(buff, 1);
-	buff.Printf(_T("    Middle  : %8d Cent:%6.1fHz Avg:%6.1fHz")
+	logfile->Write(buff, 1);
+	UTILS::str_printf(buff, "    Middle  : %8d Cent:%6.1fHz Avg:%6.1fHz"
 		, rep1.GetSampleNum(2)
 		, 1000000.0 / st_lamda.us_mid[spd]
 		, 1000000.0 / st_lamda.us_mid_avg[spd]);
-	gLogFile.Write(buff, 1);
-	buff.Printf(_T("    Too Long : %8d"),rep1.GetSampleNum(3));
-	gLogFile.Write(buff, 1);
-	buff.Printf(_T("    Too Short: %8d"),rep1.GetSampleNum(4));
-	gLogFile.Write(buff, 1);
-	buff.Printf(_T("    Error    : %8d"),rep1.GetSampleNum(5));
-	gLogFile.Write(buff, 1);
-
-	gLogFile.Write(_T(""), 1);
+	logfile->Write(buff, 1);
+	UTILS::str_printf(buff, "    Too Long : %8d",rep1.GetSampleNum(3));
+	logfile->Write(buff, 1);
+	UTILS::str_printf(buff, "    Too Short: %8d",rep1.GetSampleNum(4));
+	logfile->Write(buff, 1);
+	UTILS::str_printf(buff, "    Error    : %8d",rep1.GetSampleNum(5));
+	logfile->Write(buff, 1);
+
+	logfile->Write("", 1);
 }
 
 /// @brief エンコード時のレポート
-void WaveParser::EncordingReport(WaveFormat &outwav, wxString &buff, wxString *logbuf)
+void WaveParser::EncordingReport(WaveFormat &outwav, std::string &buff)
 {
-	buff = _T(" [ l3c -> wav ]");
-	gLogFile.Write(buff, 1);
-	buff.Printf(_T(" %dHz %dbit %dch"),outwav.GetSampleRate(), outwav.GetSampleBits(), outwav.GetChannels());
-	gLogFile.Write(buff, 1);
+	buff = " [ l3c -> wav ]";
+	logfile->Write(buff, 1);
+	UTILS::str_printf(buff, " %dHz %dbit %dch",outwav.GetSampleRate(), outwav.GetSampleBits(), outwav.GetChannels());
+	logfile->Write(buff, 1);
 
-	gLogFile.Write(_T(""), 1);
+	logfile->Write("", 1);
 }
 #endif
 
@@ -11,18 +11,58 @@
 #include "common.h"
 #include <vector>
 #include <stdio.h>
-#include <wx/string.h>
+#include <string>
 #include "paw_parse.h"
 #include "errorinfo.h"
 #include "paw_datas.h"
 #include "paw_format.h"
 #include "paw_file.h"
 #include "paw_util.h"
+#ifdef PARSEWAV_USE_THREAD
+#include <thread>
+#include <atomic>
+#endif
 
 
 namespace PARSEWAV 
 {
 
+/// wavファイルから一度に変換するサンプル数
+#define WAVE_BLOCK_SIZE	4096
+
+/// 読み込みスレッドから受け取るバッファのサンプル数
+#define WAVE_READER_RING_SIZE	(WAVE_BLOCK_SIZE * 16)
+
+/// 相関で復調する時の窓の長さ(longの半波の数)
+#define IQ_WIN_MUL	2
+/// 相関で復調する時、波の切り替わり位置を交点に合わせるshortの半波の最小サンプル数
+#define IQ_SNAP_MIN_SAMPLES	4.0
+
+/// 高いサンプルレートの入力を自動で間引く時の最低レート (倍速FSKは2倍)
+#define DECIMATE_AUTO_RATE	22050
+
+/// 長いテープを分割する時に無音とみなす振幅 (8ビット換算)
+#define SEGMENT_SILENCE_LEVEL	6
+/// 長いテープを分割する位置とする無音の最短の長さ(ms)
+#define SEGMENT_SILENCE_MSEC	1000
+
+/// 波長の分類
+enum en_lamda_class {
+	LAMDA_LONG = 0,		///< long
+	LAMDA_SHORT,		///< short
+	LAMDA_MID_LONG,		///< middle long (全波)
+	LAMDA_MID_SHORT,	///< middle short (全波)
+	LAMDA_MIDDLE,		///< middle (半波)
+	LAMDA_TOO_LONG,		///< too long
+	LAMDA_TOO_SHORT,	///< too short
+	LAMDA_ERROR,		///< error
+	LAMDA_CLASS_END,
+	LAMDA_EXACT = 0xff	///< 境界をまたぐので比較して求める
+};
+
+/// 波長の分類テーブルの分解能(1サンプルあたりの分割数)
+#define LAMDA_TABLE_RES	16
+
 /// wavファイル解析のパラメータ
 class lamda_t
 {
@@ -56,6 +96,76 @@ public:
 	void clear();
 };
 
+/// 相関による復調のワーク
+class parse_iq_t
+{
+public:
+	int    win;			///< 窓の長さ(サンプル数)
+	int    win4;		///< 窓の長さを4の倍数にしたもの
+	int    step;		///< 判定する間隔(サンプル数)
+	double unit[2];		///< 半波のサンプル数 0:long 1:short
+	float  thres;		///< 無音と判定するエネルギー
+	std::vector<float> coef;	///< 係数 long(cos,sin),short(cos,sin)の順にwin4個ずつ
+	std::vector<float> xbuf;	///< 窓内の波形データ
+	int    tone;		///< 現在の波 0:無音 1:long 2:short
+	int    cand;		///< 切り替え候補の波
+	int    cand_cnt;	///< 切り替え候補が続いた回数
+	int    cand_spos;	///< 切り替え候補の開始位置
+	int    cand_phase;	///< 切り替え候補の最初の半波 0:'0' 1:'1' -1:前の波から続ける
+	double run_len;		///< 現在の波が続いている長さ(サンプル数)
+	int    run_spos;	///< 現在の波の開始位置
+	int    run_phase;	///< 現在の波の最初の半波 0:'0' 1:'1' -1:前の波から続ける
+	double carry;		///< 出力しきれなかった長さ(サンプル数)
+	int    pend_tone;	///< 出力待ちの波
+	int    pend_num;	///< 出力待ちの数
+	double pend_spos;	///< 次に出力する位置
+	int    phase;		///< 次に出力する半波 0:'0' 1:'1'
+public:
+	parse_iq_t();
+	void clear();
+};
+
+/// 搬送波から出力レートのwaveを直接合成する
+class synth_wave_t
+{
+public:
+	int    rate;		///< 出力サンプルレート
+	int    blk_size;	///< 出力サンプルバイト(1 or 2)
+	int    fsk_spd;		///< テーブルを作成した時の倍速FSK -1:未作成
+	int    sym_len;		///< 搬送波1つの長さ (時間単位)
+	int    out_len;		///< 出力1サンプルの長さ (時間単位)
+	int    phase_unit;	///< 搬送波の開始位置の間隔 (時間単位)
+	int    width;		///< 搬送波1つが影響する出力サンプル数
+	std::vector<int32_t> table;	///< 種類(値,前,後)x開始位置xwidth ごとの出力サンプルへの寄与分
+	std::vector<int32_t> acc;	///< 出力待ちのサンプル
+	int    start;		///< 次の搬送波の開始位置 (出力サンプル内の時間単位)
+	int    prev;		///< 前の搬送波 -1:なし
+public:
+	synth_wave_t();
+	void clear();
+};
+
+/// 高いサンプルレートの入力を間引く
+class decimate_wave_t
+{
+public:
+	int    factor;		///< 間引く数 1:間引かない
+	int    in_rate;		///< 入力サンプルレート
+	int    in_num;		///< 入力サンプル数
+	int    in_pos;		///< 次に読む入力サンプル位置
+	int    taps;		///< タップ数 (8の倍数)
+	int    half;		///< 出力位置より前のタップ数
+	std::vector<int16_t> coef;	///< ローパスフィルタの係数
+	std::vector<int16_t> buf;	///< 読み込んだ入力サンプル(16ビット)
+	int    pos;			///< 次の出力の先頭タップのbuf上の位置
+	int    len;			///< bufにあるサンプル数
+	bool   primed;		///< bufの先頭を埋めたか
+	int16_t last;		///< 最後に読んだ入力サンプル
+public:
+	decimate_wave_t();
+	void clear();
+};
+
 /// 交点を保存しておく
 class PrevCross
 {
@@ -82,6 +192,7 @@ public:
 	~REPORT1() {}
 
 	void Clear();
+	void Add(const REPORT1 &src);
 	void IncSampleNum(int idx) { sample_num[idx]++; }
 //	void IncSampleOdd(int idx) { sample_odd[idx]++; }
 	int GetSampleNum(int idx) const { return sample_num[idx]; }
@@ -95,12 +206,24 @@ class WaveParser : public ParserBase
 private:
 	/// 解析用のワーク
 	parse_carrier_t st_pa_carr;
+	/// 相関による復調のワーク
+	parse_iq_t st_pa_iq;
+
+	synth_wave_t st_synth;
+	/// 高いサンプルレートの入力を間引くワーク
+	decimate_wave_t st_decim;
 	/// １つ前の交点
 	PrevCross prev_cross;
 
 	/// wavファイル解析のパラメータ
 	lamda_t st_lamda;
 
+	/// 波長の分類テーブル(波長をサンプル数で量子化した位置ごとにen_lamda_class)
+	std::vector<uint8_t> lamda_table;
+	double lamda_table_scale;	///< 波長(us)をテーブルの位置にする係数
+	int    lamda_table_spd;		///< テーブル作成時のFSK速度
+	bool   lamda_table_half;	///< テーブル作成時の半波/全波
+
 #ifdef PARSEWAV_USE_REPORT
 	/// レポート表示用
 	REPORT1 rep1;
@@ -109,26 +232,85 @@ private:
 	/// Wavファイルのフォーマット情報
 	WaveFormat *inwav;
 
+	/// ブロック変換用バッファ
+	uint8_t block_buf[WAVE_BLOCK_SIZE];
+
+#ifdef PARSEWAV_USE_THREAD
+	/// 読み込みスレッドが変換したサンプルの受け渡し用
+	CSpscRing<uint8_t> reader_ring;
+	std::thread reader_thread;
+	std::atomic<bool> reader_stop;	///< 読み込みスレッドの中断要求
+	bool reader_running;	///< 読み込みスレッドが動いている
+	int  reader_pos;		///< 読み込みスレッドの開始位置
+	int  reader_end;		///< 読み込みスレッドの終了位置
+
+	void ReaderLoop(bool reverse);
+	int  PopWaveBlock(uint8_t *dst, int num);
+#endif
+
+	int  ReadWaveBlock(uint8_t *dst, int num, bool reverse);
+
 //	void check_new_ptn(int ptn);
 
+	int  CalcDecimation(int sample_rate) const;
+	void InitDecimation(int sample_rate);
+	int  ReadDecimateInput(int16_t *dst, int num, bool reverse);
+	void DecimateWave(uint8_t *dst, int num, bool reverse);
+
+	void MakeLamdaTable(int fsk_spd, bool half);
+	int  ClassifyLamda(int fsk_spd, bool half, double lamda) const;
+	int  LookupLamda(int fsk_spd, bool half, double lamda) const;
+
+	/// デコード関数
+	typedef int (WaveParser::*decode_to_carrier_t)(WaveData *w_data, CarrierData *c_data);
+	decode_to_carrier_t decoder;	///< 初期化時に選択したデコード関数
+	int decoder_spd;				///< 選択時のFSK速度
+
+	void SetDecoder(int fsk_spd);
+	static decode_to_carrier_t SelectDecoder(int fsk_spd, bool half, int demod);
+	template<bool HALF, int FSK_SPD>
+	int DecodeToCarrierT(WaveData *w_data, CarrierData *c_data);
+
+	void InitIQ(int fsk_spd);
+	int  CorrelateIQ(WaveData *w_data, int pos);
+	void UpdateIQRun(WaveData *w_data, int pos, int tone);
+	void CloseIQRun();
+	int  DecodeToCarrierIQ(WaveData *w_data, CarrierData *c_data);
+
+	void MakeSynthTable(int fsk_spd);
+	void OutSynthSamples(int num, OutputFile &file);
+
 public:
 	WaveParser();
+	~WaveParser();
 
 	void Clear();
 	void ClearResult();
+	void MergeResult(const WaveParser &src);
 	void InitForDecode(enum_process_mode process_mode_, WaveFormat &inwav_, TempParameter &tmp_param_, MileStoneList &mile_stone_);
 	void InitForEncode(enum_process_mode process_mode_, WaveFormat &inwav_, TempParameter &tmp_param_, MileStoneList &mile_stone_);
 
 	PwErrType CheckWaveFormat(InputFile &file, wav_header_t *head, wav_fmt_chank_t *fmt, wav_data_chank_t *data, Util& conv, PwErrCode &err_num, PwErrInfo &errinfo);
+	void SetWaveInput(InputFile &file, const wav_fmt_chank_t *fmt, const wav_data_chank_t *data);
+	int FindSilentCuts(std::vector<int> &cuts, int min_len);
 
 	int GetWaveSample(int blk_size, bool reverse);
 	int GetWaveSample(WaveData *w_data, bool reverse);
 
+	void StartReader(bool reverse);
+	void StopReader();
+
 	int SkipWaveSample(int dir);
 
+	int GetSampleRate() const { return st_decim.in_rate / st_decim.factor; }
+	int GetDecimation() const { return st_decim.factor; }
+
 	int DecodeToCarrier(int fsk_spd, WaveData *w_data, CarrierData *c_data);
 
 	int EncodeToWave(CarrierData *c_data, uint8_t *w_data, int len);
+	void InitEncodeToWave(int rate, int blk_size);
+	int EncodeToWave(CarrierData *c_data, int remain, int max_num, OutputFile &file);
+	void FlushEncodeToWave(OutputFile &file);
 
 #ifdef PARSEWAV_USE_REPORT
 	const REPORT1 &GetReport() const { return rep1; }
@@ -139,8 +321,8 @@ public:
 	void SetPrevCross(int spos_);
 
 #ifdef PARSEWAV_USE_REPORT
-	void DecordingReport(wxString &buff, wxString *logbuf);
-	void EncordingReport(WaveFormat &outwav, wxString &buff, wxString *logbuf);
+	void DecordingReport(std::string &buff, std::string *logbuf);
+	void EncordingReport(WaveFormat &outwav, std::string &buff);
 #endif
 };
 
@@ -6,6 +6,13 @@
 /// @date   2017.12.01
 ///
 #include "paw_util.h"
+#include <string.h>
+#define _USE_MATH_DEFINES
+#include <math.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UTIL_USE_SSE2
+#endif
 
 
 namespace PARSEWAV
@@ -28,10 +35,289 @@ Util::~Util()
 ///
 void Util::InitConvSampleData()
 {
-	divide = 0;
-	surplus = 0;
-	remain_buf_len = 0;
-	memset(remain_buf, 0, sizeof(remain_buf));
+	rs_in_rate = 0;
+	rs_out_rate = 0;
+	rs_up = 1;
+	rs_down = 1;
+	rs_phases = 1;
+	rs_taps = 0;
+	rs_half = 0;
+	rs_phase = 0;
+	rs_pos = 0;
+	rs_primed = false;
+	rs_buf_len = 0;
+}
+
+/// @brief 最大公約数
+static int gcd_int(int a, int b)
+{
+	while(b != 0) {
+		int t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+/// @brief レート変換用のポリフェーズフィルタを作成する
+///
+/// 窓関数(Blackman)をかけたsinc関数を出力レートの位相ごとに分けて係数テーブルにする。
+/// レートを下げる場合は出力レートのナイキスト周波数で帯域を制限する。
+///
+/// @param[in] in_rate  入力サンプルレート
+/// @param[in] out_rate 出力サンプルレート
+void Util::init_resampler(int in_rate, int out_rate)
+{
+	int g = gcd_int(in_rate, out_rate);
+
+	rs_in_rate = in_rate;
+	rs_out_rate = out_rate;
+	rs_up = out_rate / g;
+	rs_down = in_rate / g;
+	rs_phases = (rs_up < RESAMPLE_MAX_PHASES ? rs_up : RESAMPLE_MAX_PHASES);
+
+	// 遮断周波数 (入力のナイキスト周波数に対する比)
+	double cutoff = (out_rate < in_rate ? (double)out_rate / in_rate : 1.0);
+	rs_half = (int)ceil(RESAMPLE_ZEROS / cutoff);
+	if (rs_half > RESAMPLE_MAX_TAPS / 2 - 4) rs_half = RESAMPLE_MAX_TAPS / 2 - 4;
+	// 8の倍数にそろえる (余った分の係数は0)
+	rs_taps = (rs_half * 2 + 7) & ~7;
+
+	rs_coef.assign(rs_phases * rs_taps, 0);
+	for(int p = 0; p < rs_phases; p++) {
+		MakeLowPassCoef(cutoff, rs_half, (double)p / rs_phases, rs_taps, &rs_coef[p * rs_taps]);
+	}
+
+	rs_phase = 0;
+	rs_pos = 0;
+	rs_primed = false;
+	rs_buf_len = 0;
+}
+
+/// @brief ローパスフィルタの係数を作成する
+///
+/// 窓関数(Blackman)をかけたsinc関数。直流の利得がちょうど1になるように丸める。
+///
+/// @param[in]  cutoff 遮断周波数 (入力のナイキスト周波数に対する比)
+/// @param[in]  half   出力位置より前のタップ数
+/// @param[in]  frac   出力位置の小数部 (0 〜 1未満)
+/// @param[in]  taps   タップ数 (half * 2以上)
+/// @param[out] c      係数 (RESAMPLE_COEF_BITSビットの固定小数点) taps個
+void Util::MakeLowPassCoef(double cutoff, int half, double frac, int taps, int16_t *c)
+{
+	const int one = (1 << RESAMPLE_COEF_BITS);
+	std::vector<double> v(taps);
+	double sum = 0.0;
+	for(int k = 0; k < taps; k++) {
+		// 出力位置から入力サンプルまでの距離
+		double t = frac + half - 1 - k;
+		double u = t / half;
+		if (u <= -1.0 || 1.0 <= u) {
+			v[k] = 0.0;
+			continue;
+		}
+		double x = M_PI * cutoff * t;
+		v[k] = (fabs(x) < 1e-9 ? 1.0 : sin(x) / x);
+		v[k] *= 0.42 + 0.5 * cos(M_PI * u) + 0.08 * cos(2.0 * M_PI * u);
+		sum += v[k];
+	}
+	// 直流の利得をちょうど1にする
+	int isum = 0;
+	for(int k = 0; k < taps; k++) {
+		c[k] = (int16_t)floor(v[k] * one / sum + 0.5);
+		isum += c[k];
+	}
+	c[half - 1 + (frac >= 0.5 ? 1 : 0)] += (int16_t)(one - isum);
+}
+
+/// @brief 高いサンプルレートの入力を間引く数を求める
+///
+/// 間引いた後のレートが整数で、min_rate以上になる最大の数を返す。
+/// ただし、間引いた後のレートは DECIMATE_MAX_RATE 以下にする。
+///
+/// @param[in] rate     入力サンプルレート
+/// @param[in] min_rate 間引いた後の最低サンプルレート
+/// @return 間引く数 1:間引かない 0:対応できないレート
+int Util::CalcDecimation(int rate, int min_rate)
+{
+	if (rate <= DECIMATE_MAX_RATE) return 1;
+
+	int factor = 0;
+	for(int d = 2; d <= DECIMATE_MAX_FACTOR; d++) {
+		if ((rate % d) != 0 || rate / d > DECIMATE_MAX_RATE) continue;
+		if (factor == 0 || rate / d >= min_rate) {
+			factor = d;
+		}
+	}
+	return factor;
+}
+
+/// @brief 係数との積和
+/// @param[in] x   データ
+/// @param[in] c   係数
+/// @param[in] len 長さ(8の倍数)
+static inline int32_t resample_dot(const int16_t *x, const int16_t *c, int len)
+{
+#ifdef UTIL_USE_SSE2
+	__m128i s = _mm_setzero_si128();
+	for(int i = 0; i < len; i += 8) {
+		__m128i xv = _mm_loadu_si128((const __m128i *)(x + i));
+		s = _mm_add_epi32(s, _mm_madd_epi16(xv, _mm_loadu_si128((const __m128i *)(c + i))));
+	}
+	s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+	s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(s);
+#else
+	int32_t sum = 0;
+	for(int i = 0; i < len; i++) {
+		sum += (int32_t)x[i] * c[i];
+	}
+	return sum;
+#endif
+}
+
+/// @brief 係数との積和 (8ビット)
+/// @param[in] x   データ
+/// @param[in] c   係数
+/// @param[in] len 長さ(8の倍数)
+static inline int32_t resample_dot(const uint8_t *x, const int16_t *c, int len)
+{
+#ifdef UTIL_USE_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	__m128i s = _mm_setzero_si128();
+	for(int i = 0; i < len; i += 8) {
+		__m128i xv = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(x + i)), zero);
+		s = _mm_add_epi32(s, _mm_madd_epi16(xv, _mm_loadu_si128((const __m128i *)(c + i))));
+	}
+	s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+	s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(s);
+#else
+	int32_t sum = 0;
+	for(int i = 0; i < len; i++) {
+		sum += (int32_t)x[i] * c[i];
+	}
+	return sum;
+#endif
+}
+
+/// @brief 入力ブロックのレートを変換してファイルに出力
+///
+/// 入力バッファから直接フィルタをかける。ブロックの先頭付近だけは前回までの末尾と合わせて計算する。
+///
+/// @param[in] in_buf       サンプリングデータ
+/// @param[in] in_len       in_buf長さ
+/// @param[in] hist         in_bufの直前のデータ
+/// @param[in] hist_len     hist長さ
+/// @param[in] in_blk_size  in_bufのサンプルバイト(1 or 2)
+/// @param[in] out_blk_size 出力ファイルのサンプルバイト
+/// @param[in,out] file     出力ファイル
+template<typename T>
+void Util::resample_block(const T *in_buf, int in_len, const int16_t *hist, int hist_len, int in_blk_size, int out_blk_size, OutputFile &file)
+{
+	const int taps = rs_taps;
+	const int min_val = (in_blk_size == 1 ? 0 : -32768);
+	const int max_val = (in_blk_size == 1 ? 255 : 32767);
+	int16_t tmp[RESAMPLE_MAX_TAPS];
+	size_t new_len = 0;
+
+	for(;;) {
+		int first = rs_pos - rs_half + 1;
+		if (first + taps > in_len) {
+			// 足りない分は次回
+			break;
+		}
+		int ph = (rs_phases == rs_up ? rs_phase : (int)((int64_t)rs_phase * rs_phases / rs_up));
+		const int16_t *c = &rs_coef[ph * taps];
+		int32_t y;
+		if (first >= 0) {
+			y = resample_dot(in_buf + first, c, taps);
+		} else {
+			for(int k = 0; k < taps; k++) {
+				int idx = first + k;
+				tmp[k] = (idx < 0 ? hist[hist_len + idx] : (int16_t)in_buf[idx]);
+			}
+			y = resample_dot(tmp, c, taps);
+		}
+		int new_data = (y + (1 << (RESAMPLE_COEF_BITS - 1))) >> RESAMPLE_COEF_BITS;
+		if (new_data < min_val) new_data = min_val;
+		else if (new_data > max_val) new_data = max_val;
+		new_buf[new_len++] = (int16_t)new_data;
+		// バッファがいっぱいなのでファイルに出す
+		if (new_len >= OUTCONV_BUFFER_SIZE - 1) {
+			out_sample_buffer(new_buf, new_len, in_blk_size, out_blk_size, file);
+			new_len = 0;
+		}
+
+		rs_phase += rs_down;
+		rs_pos += rs_phase / rs_up;
+		rs_phase %= rs_up;
+	}
+	out_sample_buffer(new_buf, new_len, in_blk_size, out_blk_size, file);
+
+	rs_pos -= in_len;
+}
+
+/// @brief ためている入力のレートを変換してファイルに出力
+///
+/// @param[in] in_blk_size  サンプルバイト(1 or 2)
+/// @param[in] out_blk_size 出力ファイルのサンプルバイト
+/// @param[in,out] file     出力ファイル
+void Util::resample_staged(int in_blk_size, int out_blk_size, OutputFile &file)
+{
+	int keep = rs_taps - 1;
+
+	rs_pos += rs_buf_len;
+	resample_block(rs_buf, rs_buf_len, rs_buf, 0, in_blk_size, out_blk_size, file);
+	// 末尾を次回にまわす
+	memmove(rs_buf, rs_buf + rs_buf_len - keep, keep * sizeof(int16_t));
+	rs_buf_len = keep;
+}
+
+/// @brief 入力をレート変換する
+///
+/// 短い入力はためておき、長い入力はバッファから直接変換する。
+///
+/// @param[in] in_buf       サンプリングデータ
+/// @param[in] in_len       in_buf長さ
+/// @param[in] in_blk_size  in_bufのサンプルバイト(1 or 2)
+/// @param[in] out_blk_size 出力ファイルのサンプルバイト
+/// @param[in,out] file     出力ファイル
+template<typename T>
+void Util::resample_input(const T *in_buf, int in_len, int in_blk_size, int out_blk_size, OutputFile &file)
+{
+	int keep = rs_taps - 1;
+
+	if (in_len <= 0) return;
+
+	if (!rs_primed) {
+		// 先頭のサンプルが前にも続いているとする
+		for(int k = 0; k < keep; k++) {
+			rs_buf[k] = (int16_t)in_buf[0];
+		}
+		rs_buf_len = keep;
+		rs_primed = true;
+	}
+
+	if (in_len < RESAMPLE_STAGE_SIZE) {
+		// ためておく
+		for(int k = 0; k < in_len; k++) {
+			rs_buf[rs_buf_len++] = (int16_t)in_buf[k];
+		}
+		rs_pos -= in_len;
+		if (rs_buf_len >= RESAMPLE_STAGE_SIZE) {
+			resample_staged(in_blk_size, out_blk_size, file);
+		}
+		return;
+	}
+
+	// バッファから直接変換
+	resample_block(in_buf, in_len, rs_buf, rs_buf_len, in_blk_size, out_blk_size, file);
+	// 末尾を次回にまわす
+	for(int k = 0; k < keep; k++) {
+		rs_buf[k] = (int16_t)in_buf[in_len - keep + k];
+	}
+	rs_buf_len = keep;
 }
 
 /// @brief waveサンプリングデータのレートとビットを変換してファイルに出力
@@ -61,110 +347,54 @@ void Util::OutConvSampleData(WaveData &in_data, int in_rate
 void Util::OutConvSampleData(const void *in_buf, int in_rate, int in_blk_size, size_t in_len
 								, int outrate, int out_blk_size, OutputFile &file)
 {
-	size_t src_len = 0;
-	size_t pos = 0;
-	int new_data = 0;
-	size_t new_len = 0;
-	size_t i = 0;
-	int16_t *dst_buf = new_buf;
-	size_t dst_len = 0;
+	if (in_rate == outrate) {
+		// 同じレート
+		if (in_blk_size == 1) {
+			out_sample_buffer((const uint8_t *)in_buf, in_len, in_blk_size, out_blk_size, file);
+		} else if (in_blk_size == 2) {
+			out_sample_buffer((const int16_t *)in_buf, in_len, in_blk_size, out_blk_size, file);
+		}
+		return;
+	}
 
-//	memset(src_buf, 0, sizeof(src_buf));
-//	memset(new_buf, 0, sizeof(new_buf));
-	for (i=0; i<(size_t)remain_buf_len; i++) {
-		src_buf[i]=remain_buf[i];
+	if (rs_in_rate != in_rate || rs_out_rate != outrate) {
+		init_resampler(in_rate, outrate);
 	}
-	src_len = remain_buf_len;
 
 	if (in_blk_size == 1) {
 		// 8ビット
-		for(i=0; i<in_len; i++) {
-			src_buf[src_len]=(int16_t)*((uint8_t *)in_buf + i);
-			src_len++;
-		}
+		resample_input((const uint8_t *)in_buf, (int)in_len, in_blk_size, out_blk_size, file);
 	} else if (in_blk_size == 2) {
 		// 16ビット
-		for(i=0; i<in_len; i++) {
-			src_buf[src_len]=(int16_t)*((int16_t *)in_buf + i);
-			src_len++;
-		}
+		resample_input((const int16_t *)in_buf, (int)in_len, in_blk_size, out_blk_size, file);
 	}
+}
 
-//	memset(remain_buf, 0, sizeof(remain_buf));
-	remain_buf_len = 0;
-
-	if (in_rate > outrate) {
-		// rate 下げる場合
-		pos = 0;
-		while (pos < src_len) {
-			divide = (in_rate + surplus) / outrate;
-			if (pos + divide + 2 >= src_len) {
-				break;
-			}
-			int n_surplus = (in_rate + surplus) % outrate;
 
-			// 平均化
-			new_data = 0;
-			if (surplus >= 0) {
-				new_data += (int)((double)src_buf[pos] * (double)((int)outrate - surplus) / (double)outrate);
-				pos++;
-			}
-			for(i = 1; i < (size_t)divide; i++) {
-				new_data += src_buf[pos];
-				pos++;
-			}
-			if (n_surplus > 0) {
-				new_data += (int)((double)src_buf[pos] * (double)n_surplus / (double)outrate);
-			}
-			new_data = (int)((double)new_data * (double)outrate / (double)in_rate);
+/// @brief レート変換で残っているデータをファイルに出力
+///
+/// 最後のサンプルが後にも続いているとして残りを変換する
+///
+/// @param[in] in_blk_size  入力のサンプルバイト(1 or 2)
+/// @param[in] out_blk_size 出力wavファイルのサンプルバイト
+/// @param[in,out] file     出力wavファイル
+void Util::FlushConvSampleData(int in_blk_size, int out_blk_size, OutputFile &file)
+{
+	if (!rs_primed || rs_buf_len <= 0) return;
 
-			surplus = n_surplus;
-			new_buf[new_len] = (int16_t)new_data;
-			new_len++;
-		}
-		if (pos < src_len) {
-			// 余ったデータは次回にまわす
-			for(i=pos; i<src_len; i++) {
-				remain_buf[i-pos]=src_buf[i];
-			}
-			remain_buf_len = (int)(src_len - pos);
-		}
-		dst_len = new_len; 
-	} else if (in_rate < outrate) {
-		// rate 上げる場合
-		pos = 0;
-		while (pos < src_len - 1) {
-			divide = (outrate + surplus) / in_rate;
-			surplus = (outrate + surplus) % in_rate;
-			// サンプル間を線形で補完
-			for(i=0; i<(size_t)divide; i++) {
-				new_data = (int)src_buf[pos] + (int)i * ((int)src_buf[pos+1] - (int)src_buf[pos]) / divide;
-				new_buf[new_len] = (int16_t)new_data;
-				new_len++;
-				// バッファがいっぱいなのでファイルに出す
-				if (new_len >= OUTCONV_BUFFER_SIZE - 1) {
-					out_sample_buffer(new_buf, new_len, in_blk_size, out_blk_size, file);
-//					memset(new_buf, 0, sizeof(new_buf));
-					new_len = 0;
-				}
-			}
-			pos++;
-		}
-		// 最後のデータを次に回す
-		remain_buf[0]=src_buf[src_len-1];
-		remain_buf_len = 1;
-		dst_len = new_len; 
-	} else {
-		// 同じレート
-//		memcpy(new_buf, src_buf, src_len * sizeof(int16_t));
-		dst_buf = src_buf;
-		dst_len = src_len;
+	int16_t last = rs_buf[rs_buf_len - 1];
+	int pad = rs_taps - rs_half;
+	for(int k = 0; k < pad; k++) {
+		rs_buf[rs_buf_len++] = last;
 	}
-
-	out_sample_buffer(dst_buf, dst_len, in_blk_size, out_blk_size, file);
+	rs_pos -= pad;
+	resample_staged(in_blk_size, out_blk_size, file);
+	rs_primed = false;
+	rs_phase = 0;
+	rs_pos = 0;
+	rs_buf_len = 0;
 }
 
-
 /// @brief waveサンプリングデータのビット変換
 ///
 /// @param[in] in_buf       入力データ
@@ -173,44 +403,45 @@ void Util::OutConvSampleData(const void *in_buf, int in_rate, int in_blk_size, s
 /// @param[in] out_blk_size 出力ファイルのサンプルバイト
 /// @param[out] file        出力ファイル
 /// @return 出力サイズ(バイト)
-size_t Util::out_sample_buffer(int16_t *in_buf, size_t in_len, int in_blk_size, int out_blk_size, OutputFile &file)
+template<typename T>
+size_t Util::out_sample_buffer(const T *in_buf, size_t in_len, int in_blk_size, int out_blk_size, OutputFile &file)
 {
 	int16_t new_data = 0;
 	size_t i = 0;
 	size_t out_len = 0;
 
-	// 出力
-	if (in_blk_size > out_blk_size) {
-		// ビット 下げる場合
-		for(i=0; i<in_len; i++) {
-			new_data = (in_buf[i] / 256) + 128;
-
-			file.Fputc(new_data);
-			out_len++;
-		}
-	} else if (in_blk_size < out_blk_size) {
-		// ビット 上げる場合
-		for(i=0; i<in_len; i++) {
-			new_data = (in_buf[i] - 128) * 256;
-
-			file.Fwrite(&new_data, sizeof(int16_t), 1);
-			out_len+=2;
-		}
-	} else {
-		// 同じビット
-		if (out_blk_size == 1) {
-			for(i=0; i<in_len; i++) {
-				new_data = in_buf[i];
-				file.Fputc(new_data);
-				out_len++;
+	// 出力バッファに直接書き込む
+	while(i < in_len) {
+		size_t len = (in_len - i) * out_blk_size;
+		uint8_t *p = file.Freserve(len);
+		size_t n = len / out_blk_size;
+		size_t k;
+
+		if (in_blk_size > out_blk_size) {
+			// ビット 下げる場合
+			for(k=0; k<n; k++) {
+				new_data = (in_buf[i + k] / 256) + 128;
+				p[k] = (uint8_t)new_data;
+			}
+		} else if (in_blk_size < out_blk_size) {
+			// ビット 上げる場合
+			for(k=0; k<n; k++) {
+				new_data = (in_buf[i + k] - 128) * 256;
+				memcpy(&p[k * 2], &new_data, sizeof(int16_t));
 			}
 		} else {
-			for(i=0; i<in_len; i++) {
-				new_data = in_buf[i];
-				file.Fwrite(&new_data, sizeof(int16_t), 1);
-				out_len+=2;
+			// 同じビット
+			if (out_blk_size == 1) {
+				for(k=0; k<n; k++) {
+					p[k] = (uint8_t)in_buf[i + k];
+				}
+			} else {
+				memcpy(p, &in_buf[i], n * sizeof(int16_t));
 			}
 		}
+		file.Fcommit(n * out_blk_size);
+		i += n;
+		out_len += n * out_blk_size;
 	}
 	return out_len;
 }
@@ -262,8 +493,8 @@ PwErrCode Util::CheckWavFormat(InputFile &file, wav_header_t *head, wav_fmt_chan
 				return pwErrNotPCMFormat;
 			}
 
-			// 11025 - 48000Hz
-			if (fmt->sample_rate < 11025 || 48000 < fmt->sample_rate) {
+			// 11025 - 48000Hz (それより高いレートは間引けるもの)
+			if (fmt->sample_rate < 11025 || CalcDecimation(fmt->sample_rate, 0) == 0) {
 				return pwErrSampleRate;
 			}
 
@@ -298,6 +529,14 @@ PwErrCode Util::CheckWavFormat(InputFile &file, wav_header_t *head, wav_fmt_chan
 	// 実際のサンプルデータがはじまる位置の先頭
 	file.Fseek(fpos_data, SEEK_SET);
 
+	if (data_len) {
+		// 途中で切れているファイルはファイルの終わりまでのサンプル数
+		long remain = (long)file.GetSize() - fpos_data;
+		if (remain < 0) remain = 0;
+		if ((long)data->data_len < remain) remain = (long)data->data_len;
+		*data_len = (fmt->block_size > 0 ? (size_t)remain / fmt->block_size : 0);
+	}
+
 	return pwErrNone;
 }
 
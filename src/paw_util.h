@@ -9,6 +9,7 @@
 #define _PARSEWAV_UTIL_H_
 
 #include "errorinfo.h"
+#include <vector>
 #include "paw_datas.h"
 #include "paw_format.h"
 #include "paw_file.h"
@@ -19,19 +20,50 @@ namespace PARSEWAV
 
 #define OUTCONV_BUFFER_SIZE (DATA_ARRAY_SIZE + 4)
 
+/// レート変換フィルタの片側のゼロ点の数
+#define RESAMPLE_ZEROS		8
+/// レート変換フィルタの1位相あたりの最大タップ数
+#define RESAMPLE_MAX_TAPS	128
+/// レート変換フィルタの係数テーブルの最大位相数
+#define RESAMPLE_MAX_PHASES	1024
+/// レート変換フィルタの係数の小数部ビット数
+#define RESAMPLE_COEF_BITS	14
+/// これより短い入力はためてからまとめてレート変換する
+#define RESAMPLE_STAGE_SIZE	1024
+
+/// 入力wavを間引かずに扱う最大のサンプルレート
+#define DECIMATE_MAX_RATE	48000
+/// 入力wavを間引く最大の数
+#define DECIMATE_MAX_FACTOR	8
+
 /// @brief WAVファイルを扱うクラス
 class Util
 {
 private:
-	int remain_buf[100];
-	int remain_buf_len;
-	int divide;
-	int surplus;
+	int rs_in_rate;		///< 入力サンプルレート
+	int rs_out_rate;	///< 出力サンプルレート
+	int rs_up;			///< 補間数 (出力レート / 最大公約数)
+	int rs_down;		///< 間引き数 (入力レート / 最大公約数)
+	int rs_phases;		///< 係数テーブルの位相数
+	int rs_taps;		///< 1位相あたりのタップ数 (8の倍数)
+	int rs_half;		///< 出力位置より前のタップ数
+	std::vector<int16_t> rs_coef;	///< 係数 位相ごとにrs_taps個ずつ
+	int rs_phase;		///< 次に出力する位相 (0 〜 rs_up - 1)
+	int rs_pos;			///< 次に出力する位置 (次の入力ブロック先頭からのサンプル数)
+	bool rs_primed;		///< 履歴を初期化したか
+	int16_t rs_buf[RESAMPLE_STAGE_SIZE * 2 + RESAMPLE_MAX_TAPS];	///< 前回までの入力の末尾とためている入力
+	int rs_buf_len;		///< rs_bufの長さ
 
-	int16_t src_buf[OUTCONV_BUFFER_SIZE];
 	int16_t new_buf[OUTCONV_BUFFER_SIZE];
 
-	size_t out_sample_buffer(int16_t *in_buf, size_t in_len, int in_blk_size, int out_blk_size, OutputFile &file);
+	void   init_resampler(int in_rate, int out_rate);
+	template<typename T>
+	void   resample_block(const T *in_buf, int in_len, const int16_t *hist, int hist_len, int in_blk_size, int out_blk_size, OutputFile &file);
+	void   resample_staged(int in_blk_size, int out_blk_size, OutputFile &file);
+	template<typename T>
+	void   resample_input(const T *in_buf, int in_len, int in_blk_size, int out_blk_size, OutputFile &file);
+	template<typename T>
+	size_t out_sample_buffer(const T *in_buf, size_t in_len, int in_blk_size, int out_blk_size, OutputFile &file);
 
 public:
 	Util();
@@ -42,8 +74,12 @@ public:
 						, int outrate, int out_blk_size, OutputFile &file);
 	void   OutConvSampleData(const void *in_buf, int in_rate, int in_blk_size, size_t in_len
 						, int outrate, int out_blk_size, OutputFile &file);
+	void   FlushConvSampleData(int in_blk_size, int out_blk_size, OutputFile &file);
 	size_t ReadWavData(InputFile &file, wav_fmt_chank_t *in_fmt, size_t in_len, uint8_t *outbuf, uint32_t outrate, int outbits, size_t outlen);
 
+	static void MakeLowPassCoef(double cutoff, int half, double frac, int taps, int16_t *c);
+	static int  CalcDecimation(int rate, int min_rate);
+
 	static PwErrCode CheckWavFormat(InputFile &file, wav_header_t *head, wav_fmt_chank_t *fmt, wav_data_chank_t *data, size_t *data_len = NULL);
 	static PwErrCode CheckWavFormat(InputFile &file, WaveFormat &format, size_t *data_len = NULL);
 };
@@ -8,45 +8,6 @@
 
 //////////////////////////////////////////////////////////////////////
 
-RfTypeParam::RfTypeParam()
-{
-	Initialize();
-}
-
-void RfTypeParam::Initialize()
-{
-	data_format = 0;
-	data_type   = 0;
-	sel_file_type = 0;
-
-	rf_name = _T("");
-	rf_name_real[0] = '\0';
-}
-
-int RfTypeParam::GetRfDataName(uint8_t *name) const
-{
-	strncpy((char *)name, rf_name.mb_str(), 8);
-
-	for(int i=0; i<8; i++) {
-		if (name[i] == 0) name[i] = 0x20;
-	}
-	return 0;
-}
-
-const uint8_t *RfTypeParam::GetRfDataName()
-{
-	memset(rf_name_real, 0, sizeof(rf_name_real));
-	GetRfDataName(rf_name_real);
-	return rf_name_real;
-}
-
-int RfTypeParam::GetRfDataNameLen() const
-{
-	return 8;
-}
-
-//////////////////////////////////////////////////////////////////////
-
 // Attach Event
 BEGIN_EVENT_TABLE(RfTypeBox, wxDialog)
 #ifndef USE_RADIOBOX
@@ -120,23 +81,10 @@ RfTypeBox::RfTypeBox(wxWindow* parent, RfTypeParam &nparam)
 }
 
 // ダイアログ表示
-int RfTypeBox::showRftypeBox(const _TCHAR *name, bool init_data)
+int RfTypeBox::showRftypeBox(const std::string &name, bool init_data)
 {
-	wxString sName = _T("");
-
-	if (name != NULL) {
-		wxString snName;
-		sName = wxString(name, wxConvUTF8);
-		trim_str(sName, snName);
-		param->SetRfName(snName);
-	}
-	return showRftypeBox(init_data);
-}
-
-int RfTypeBox::showRftypeBox(const wxString &name, bool init_data)
-{
-	wxString snName;
-	trim_str(name, snName);
+	std::string snName;
+	RfTypeParam::TrimName(name, snName);
 	param->SetRfName(snName);
 
 	return showRftypeBox(init_data);
@@ -182,7 +130,7 @@ void RfTypeBox::init_dialog(bool init_data)
 	radBinary->SetValue(data_type == 0);
 	radAscii->SetValue(data_type == 0xff);
 
-	txtEdit->SetValue(param->GetRfName());
+	txtEdit->SetValue(wxString::FromUTF8(param->GetRfName().c_str()));
 	txtEdit->SetMaxLength(8);
 
 	select_file_type();
@@ -239,8 +187,8 @@ void RfTypeBox::OnClickFileType(wxCommandEvent& event)
 void RfTypeBox::OnClickOk(wxCommandEvent& event)
 {
 	// テキスト
-	param->SetRfName(txtEdit->GetValue());
-	if (!chk_str(param->GetRfName())) {
+	param->SetRfName((const char *)txtEdit->GetValue().utf8_str());
+	if (!RfTypeParam::CheckName(param->GetRfName())) {
 		wxMessageBox(_("Internal file name accepts only alphabets and digits.") // 内部ファイル名は半角英数字で入力してください。
 			, _("error"), wxOK | wxICON_ERROR, this);
 		return;
@@ -277,39 +225,3 @@ void RfTypeBox::select_data_format()
 		radAscii->SetValue(false);
 	}
 }
-
-bool RfTypeBox::chk_str(const wxString &str)
-{
-	bool rc = true;
-	size_t len;
-
-	len = str.Length();
-
-	if (len <= 0) {
-			rc = false;
-	}
-	for(size_t i=0; i < len; i++) {
-		wxChar c = str.GetChar(i);
-		if (c < _T(' ') || c == _T('(') || c == _T(')') || c == _T(':')) {
-			rc = false;
-			break;
-		}
-	}
-	return rc;
-}
-
-void RfTypeBox::trim_str(const wxString &str, wxString &nstr)
-{
-	size_t len;
-
-	nstr = _T("");
-
-	len = str.Length();
-	for(size_t i=0; i < len && i < 8; i++) {
-		wxChar c = str.GetChar(i);
-		if (c < _T(' ') || c == _T('.') || c == _T('(') || c == _T(')') || c == _T(':')) {
-			break;
-		}
-		nstr += c;
-	}
-}
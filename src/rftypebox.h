@@ -10,37 +10,9 @@
 #include "common.h"
 #include <wx/wx.h>
 #include <wx/dialog.h>
+#include "paw_param.h"
 
-/// 実ファイル種類選択パラメータ
-class RfTypeParam
-{
-private:
-	uint8_t  data_format;
-	uint8_t  data_type;
-
-	wxString rf_name;
-	uint8_t rf_name_real[12];
-
-	int sel_file_type;
-
-public:
-	RfTypeParam();
-	~RfTypeParam() {}
-
-	void Initialize();
-
-	int		GetRfDataName(uint8_t *) const;
-	const uint8_t *GetRfDataName();
-	int		GetRfDataNameLen() const;
-	const wxString &GetRfName() const { return rf_name; }
-	uint8_t	GetRfDataFormat() const { return data_format; }
-	uint8_t	GetRfDataType() const { return data_type; }
-	int     GetRfDataFileType() const { return sel_file_type; }
-	void    SetRfDataFormat(uint8_t val) { data_format = val; }
-	void    SetRfDataType(uint8_t val) { data_type = val; }
-	void    SetRfName(const wxString &val) { rf_name = val; }
-	void    SetRfDataFileType(int val) { sel_file_type = val; }
-};
+using PARSEWAV::RfTypeParam;
 
 /// 実ファイル種類選択ダイアログ
 class RfTypeBox : public wxDialog
@@ -66,8 +38,6 @@ private:
 
 	void select_file_type();
 	void select_data_format();
-	bool chk_str(const wxString &str);
-	void trim_str(const wxString &str, wxString &nstr);
 
 public:
 	RfTypeBox(wxWindow* parent, RfTypeParam &nparam);
@@ -103,8 +73,7 @@ public:
 //	uint8_t	getRfDataType()   { return data_type; }
 //	int     getRfDataFileType() { return sel_file_type; }
 
-	int		showRftypeBox(const _TCHAR *name, bool init_data = true);
-	int     showRftypeBox(const wxString &name, bool init_data = true);
+	int     showRftypeBox(const std::string &name, bool init_data = true);
 	int     showRftypeBox(bool init_data = true);
 
 	DECLARE_EVENT_TABLE()
@@ -5,6 +5,14 @@
 /// @author Copyright (c) Sasaji. All rights reserved.
 ///
 #include "utils.h"
+#include <string.h>
+#include <ctype.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <stdlib.h>
+#else
+#include <sys/stat.h>
+#endif
 
 namespace UTILS
 {
@@ -12,66 +20,84 @@ namespace UTILS
 /// @brief ファイルパスからファイル名取得
 ///
 /// @param[in] src ファイルパス
-/// @param[out] dst ファイル名を格納するバッファ
-/// @param[in] size バッファサイズ
+/// @param[out] dst ファイル名
 /// @return true
-bool base_name(const _TCHAR *src, _TCHAR *dst, size_t size)
+bool base_name(const std::string &src, std::string &dst)
 {
-	const _TCHAR *p;
+	size_t p;
 #ifdef _WIN32
-	p = _tcsrchr(src, '\\');
+	p = src.find_last_of("\\/");
 #else
-	p = _tcsrchr(src, '/');
+	p = src.rfind('/');
 #endif
-	if (dst != NULL && size > 0 && p != NULL) {
-		if (_tcslen(p+1) < size) size = _tcslen(p);
-		_tcsncpy(dst, p+1, size);
-		dst[size-1]=_T('\0');
+	if (p != std::string::npos) {
+		dst = src.substr(p+1);
+	} else {
+		dst = src;
 	}
 	return true;
 }
 
-/// @brief ファイルパスからファイル名取得
+/// @brief ファイルパスから拡張子を除いたファイル名取得
 ///
 /// @param[in] src ファイルパス
 /// @param[out] dst ファイル名
 /// @return true
-bool prefix_name(const wxString &src, wxString &dst)
+bool prefix_name(const std::string &src, std::string &dst)
 {
-	int p = wxNOT_FOUND;
+	size_t p;
 
-#ifdef __WXMSW__
-	if ((p = src.Find('\\', true)) != wxNOT_FOUND) {
-#else
-	if ((p = src.Find('/', true)) != wxNOT_FOUND) {
-#endif
-		dst = src.Mid(p+1);
-	} else {
-		dst = src;
-	}
-	if ((p = dst.Find('.', true)) != wxNOT_FOUND) {
-		dst = dst.Left(p);
+	base_name(src, dst);
+	if ((p = dst.rfind('.')) != std::string::npos) {
+		dst = dst.substr(0, p);
 	}
 	return true;
 }
 
-/// @brief 時間（文字列）を返す
+/// @brief 同じファイルを指しているか
 ///
-/// @param[in] usec マイクロ秒
-/// @return 文字列 mm'ss"ms
+/// @param[in] src1 ファイルパス
+/// @param[in] src2 ファイルパス
+/// @return true 同じ
+bool same_path(const std::string &src1, const std::string &src2)
+{
+#ifdef _WIN32
+	wchar_t wsrc[_MAX_PATH];
+	wchar_t full1[_MAX_PATH];
+	wchar_t full2[_MAX_PATH];
+	if (MultiByteToWideChar(CP_UTF8, 0, src1.c_str(), -1, wsrc, _MAX_PATH) == 0
+	 || _wfullpath(full1, wsrc, _MAX_PATH) == NULL
+	 || MultiByteToWideChar(CP_UTF8, 0, src2.c_str(), -1, wsrc, _MAX_PATH) == 0
+	 || _wfullpath(full2, wsrc, _MAX_PATH) == NULL) {
+		return (src1 == src2);
+	}
+	return (_wcsicmp(full1, full2) == 0);
+#else
+	struct stat st1, st2;
+	if (stat(src1.c_str(), &st1) != 0 || stat(src2.c_str(), &st2) != 0) {
+		return (src1 == src2);
+	}
+	return (st1.st_dev == st2.st_dev && st1.st_ino == st2.st_ino);
+#endif
+}
+
+/// @brief 拡張子のチェック
 ///
-wxString get_time_str(uint32_t usec)
+/// @param[in] filename ファイル名
+/// @param[in] ext 拡張子名 (大文字小文字は区別しない)
+/// @return true 拡張子が一致 / false 一致しない
+bool check_extension(const std::string &filename, const char *ext)
 {
-	wxString str;
-	usec += 500;
-	int ms = usec / 1000;
-	int sec = ms / 1000;
-	int msec = ms % 1000;
-	int min = sec / 60;
-	sec = sec % 60;
+	size_t nam_len = filename.length();
+	size_t ext_len = strlen(ext);
 
-	str.Printf(_T("%d\'%02d\".%03d"), min, sec, msec);
-	return str;
+	if (nam_len < ext_len) return false;
+
+	const char *p = filename.c_str() + nam_len - ext_len;
+	for(size_t i=0; i<ext_len; i++) {
+		if (toupper((unsigned char)p[i]) != toupper((unsigned char)ext[i])) return false;
+	}
+	return true;
 }
 
 /// @brief 時間（文字列）を返す
@@ -79,9 +105,9 @@ wxString get_time_str(uint32_t usec)
 /// @param[in] usec マイクロ秒
 /// @return 文字列 mm'ss"ms
 ///
-const char *get_time_cstr(uint32_t usec)
+std::string get_time_str(uint32_t usec)
 {
-	static char str[50];
+	char str[50];
 	usec += 500;
 	int ms = usec / 1000;
 	int sec = ms / 1000;
@@ -89,7 +115,7 @@ const char *get_time_cstr(uint32_t usec)
 	int min = sec / 60;
 	sec = sec % 60;
 
-#if defined(__WXMSW__)
+#if defined(_WIN32)
 	_snprintf(str, sizeof(str), "%d\'%02d\".%03d", min, sec, msec);
 #else
 	snprintf(str, sizeof(str), "%d\'%02d\".%03d", min, sec, msec);
@@ -97,34 +123,108 @@ const char *get_time_cstr(uint32_t usec)
 	return str;
 }
 
+/// @brief 書式に従って文字列を作る
+///
+/// @param[out] dst 出力先
+/// @param[in] format 書式
+/// @return 文字列の長さ
+int str_printf(std::string &dst, const char *format, ...)
+{
+	char buf[1024];
+	va_list ap;
+
+	va_start(ap, format);
+	int len = vsnprintf(buf, sizeof(buf), format, ap);
+	va_end(ap);
+	if (len < 0) {
+		dst.clear();
+		return 0;
+	}
+	if (len < (int)sizeof(buf)) {
+		dst.assign(buf, len);
+	} else {
+		// バッファに入らない場合
+		dst.resize(len + 1);
+		va_start(ap, format);
+		vsnprintf(&dst[0], len + 1, format, ap);
+		va_end(ap);
+		dst.resize(len);
+	}
+	return len;
+}
+
+/// @brief 書式に従って文字列を作る
+///
+/// @param[in] format 書式
+/// @return 文字列
+std::string str_format(const char *format, ...)
+{
+	char buf[1024];
+	std::string dst;
+	va_list ap;
+
+	va_start(ap, format);
+	int len = vsnprintf(buf, sizeof(buf), format, ap);
+	va_end(ap);
+	if (len < 0) {
+		return dst;
+	}
+	if (len < (int)sizeof(buf)) {
+		dst.assign(buf, len);
+	} else {
+		// バッファに入らない場合
+		dst.resize(len + 1);
+		va_start(ap, format);
+		vsnprintf(&dst[0], len + 1, format, ap);
+		va_end(ap);
+		dst.resize(len);
+	}
+	return dst;
+}
+
 /// @brief 内部ファイル名のキャラクターコードを変換するテーブル
-static const wxString chr2utf8tbl[128] = {
-	_T("年"),_T("月"),_T("日"),_T("市"),_T("区"),_T("町"),_T("を"),_T("ぁ"),_T("ぃ"),_T("ぅ"),_T("ぇ"),_T("ぉ"),_T("ゃ"),_T("ゅ"),_T("ょ"),_T("っ"),
-	_T("π"),_T("あ"),_T("い"),_T("う"),_T("え"),_T("お"),_T("か"),_T("き"),_T("く"),_T("け"),_T("こ"),_T("さ"),_T("し"),_T("す"),_T("せ"),_T("そ"),
-	_T("〒"),_T("。"),_T("「"),_T("」"),_T("、"),_T("・"),_T("ヲ"),_T("ァ"),_T("ィ"),_T("ゥ"),_T("ェ"),_T("ォ"),_T("ャ"),_T("ュ"),_T("ョ"),_T("ッ"),
-	_T("ー"),_T("ア"),_T("イ"),_T("ウ"),_T("エ"),_T("オ"),_T("カ"),_T("キ"),_T("ク"),_T("ケ"),_T("コ"),_T("サ"),_T("シ"),_T("ス"),_T("セ"),_T("ソ"),
-	_T("タ"),_T("チ"),_T("ツ"),_T("テ"),_T("ト"),_T("ナ"),_T("ニ"),_T("ヌ"),_T("ネ"),_T("ノ"),_T("ハ"),_T("ヒ"),_T("フ"),_T("ヘ"),_T("ホ"),_T("マ"),
-	_T("ミ"),_T("ム"),_T("メ"),_T("モ"),_T("ヤ"),_T("ユ"),_T("ヨ"),_T("ラ"),_T("リ"),_T("ル"),_T("レ"),_T("ロ"),_T("ワ"),_T("ン"),_T("゛"),_T("゜"),
-	_T("た"),_T("ち"),_T("つ"),_T("て"),_T("と"),_T("な"),_T("に"),_T("ぬ"),_T("ね"),_T("の"),_T("は"),_T("ひ"),_T("ふ"),_T("へ"),_T("ほ"),_T("ま"),
-	_T("み"),_T("む"),_T("め"),_T("も"),_T("や"),_T("ゆ"),_T("よ"),_T("ら"),_T("り"),_T("る"),_T("れ"),_T("ろ"),_T("わ"),_T("ん"),_T("■"),_T("　")
+static const wchar_t chr2ucs2tbl[128] = {
+	L'年',L'月',L'日',L'市',L'区',L'町',L'を',L'ぁ',L'ぃ',L'ぅ',L'ぇ',L'ぉ',L'ゃ',L'ゅ',L'ょ',L'っ',
+	L'π',L'あ',L'い',L'う',L'え',L'お',L'か',L'き',L'く',L'け',L'こ',L'さ',L'し',L'す',L'せ',L'そ',
+	L'〒',L'。',L'「',L'」',L'、',L'・',L'ヲ',L'ァ',L'ィ',L'ゥ',L'ェ',L'ォ',L'ャ',L'ュ',L'ョ',L'ッ',
+	L'ー',L'ア',L'イ',L'ウ',L'エ',L'オ',L'カ',L'キ',L'ク',L'ケ',L'コ',L'サ',L'シ',L'ス',L'セ',L'ソ',
+	L'タ',L'チ',L'ツ',L'テ',L'ト',L'ナ',L'ニ',L'ヌ',L'ネ',L'ノ',L'ハ',L'ヒ',L'フ',L'ヘ',L'ホ',L'マ',
+	L'ミ',L'ム',L'メ',L'モ',L'ヤ',L'ユ',L'ヨ',L'ラ',L'リ',L'ル',L'レ',L'ロ',L'ワ',L'ン',L'゛',L'゜',
+	L'た',L'ち',L'つ',L'て',L'と',L'な',L'に',L'ぬ',L'ね',L'の',L'は',L'ひ',L'ふ',L'へ',L'ほ',L'ま',
+	L'み',L'む',L'め',L'も',L'や',L'ゆ',L'よ',L'ら',L'り',L'る',L'れ',L'ろ',L'わ',L'ん',L'■',L'　'
 };
 
+/// @brief 1文字をUTF-8にして追加
+static void append_utf8(std::string &dst, uint32_t c)
+{
+	if (c < 0x80) {
+		dst += (char)c;
+	} else if (c < 0x800) {
+		dst += (char)(0xc0 | (c >> 6));
+		dst += (char)(0x80 | (c & 0x3f));
+	} else {
+		dst += (char)(0xe0 | (c >> 12));
+		dst += (char)(0x80 | ((c >> 6) & 0x3f));
+		dst += (char)(0x80 | (c & 0x3f));
+	}
+}
+
 /// @brief 内部ファイル名のキャラクターコードをUTF-8に変換
 ///
 /// @param[in] src 内部ファイル名
 /// @return 変換後の文字列
-wxString conv_internal_name(const uint8_t *src)
+std::string conv_internal_name(const uint8_t *src)
 {
-	wxString dst = _T("");
+	std::string dst;
 
 	for(int i=0; i<8; i++) {
 		const uint8_t *p = &src[i];
-		if (*p >= 0x80 && *p <= 0xff) {
-			dst += chr2utf8tbl[(*p)-0x80];
+		if (*p >= 0x80) {
+			append_utf8(dst, (uint32_t)chr2ucs2tbl[(*p)-0x80]);
 		} else if (*p >= 0x20 && *p <= 0x7f) {
-			dst += wxString::FromUTF8((const char *)p, 1);
+			dst += (char)*p;
 		} else {
-			dst += _T("?");
+			dst += '?';
 		}
 	}
 	return dst;
@@ -132,15 +232,19 @@ wxString conv_internal_name(const uint8_t *src)
 
 /// @brief ファイルをオープンする
 ///
-/// @param[in] file ファイル名
+/// @param[in] file ファイル名 (UTF-8)
 /// @param[in] mode ファイルモード
 /// @return ファイルポインタ
-FILE *pw_fopen(const wxString &file, const wxString &mode)
+FILE *pw_fopen(const std::string &file, const char *mode)
 {
-#ifdef __WXMSW__
-	return _tfopen(file, mode);
+#ifdef _WIN32
+	wchar_t wfile[_MAX_PATH];
+	wchar_t wmode[8];
+	if (MultiByteToWideChar(CP_UTF8, 0, file.c_str(), -1, wfile, _MAX_PATH) == 0) return NULL;
+	if (MultiByteToWideChar(CP_UTF8, 0, mode, -1, wmode, 8) == 0) return NULL;
+	return _wfopen(wfile, wmode);
 #else
-	return fopen(file.fn_str(), mode.fn_str());
+	return fopen(file.c_str(), mode);
 #endif
 }
 
@@ -249,18 +353,18 @@ int write_data(FILE *fp, const char *data, int len, int width, int pos, int type
 /// @param[in] fiolog ログファイル
 /// @param[in] logbuf ログバッファ
 ///
-void write_log(const wxString &buff, int crlf, FILE *fiolog, wxString *logbuf)
+void write_log(const std::string &buff, int crlf, FILE *fiolog, std::string *logbuf)
 {
-	if (buff.Length() > 0) {
-		if (fiolog) _fputts(buff.c_str(), fiolog);
+	if (buff.length() > 0) {
+		if (fiolog) fputs(buff.c_str(), fiolog);
 		if (logbuf) *logbuf += buff;
 	}
 	for (int i=0; i<crlf; i++) {
-		if (fiolog) _fputts(_T("\n"), fiolog);
+		if (fiolog) fputs("\n", fiolog);
 #ifdef _WIN32
-		if (logbuf) *logbuf += _T("\r\n");
+		if (logbuf) *logbuf += "\r\n";
 #else
-		if (logbuf) *logbuf += _T("\n");
+		if (logbuf) *logbuf += "\n";
 #endif
 	}
 }
@@ -8,22 +8,28 @@
 #define _UTILS_H_
 
 #include "common.h"
-#include <wx/wx.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string>
 
 namespace UTILS
 {
-	bool base_name(const _TCHAR *, _TCHAR *, size_t);
-	bool prefix_name(const wxString &, wxString &);
+	bool base_name(const std::string &, std::string &);
+	bool prefix_name(const std::string &, std::string &);
+	bool same_path(const std::string &, const std::string &);
+	bool check_extension(const std::string &filename, const char *ext);
 
-	wxString get_time_str(uint32_t usec);
-	const char *get_time_cstr(uint32_t usec);
+	std::string get_time_str(uint32_t usec);
 
-	wxString conv_internal_name(const uint8_t *src);
+	int   str_printf(std::string &dst, const char *format, ...);
+	std::string str_format(const char *format, ...);
 
-	FILE *pw_fopen(const wxString &file, const wxString &mode);
+	std::string conv_internal_name(const uint8_t *src);
+
+	FILE *pw_fopen(const std::string &file, const char *mode);
 //	int   write_data(FILE *fp, const char *data, int len, int width, int pos, int type);
 
-	void  write_log(const wxString &buff, int crlf, FILE *fiolog = NULL, wxString *logbuf = NULL);
+	void  write_log(const std::string &buff, int crlf, FILE *fiolog = NULL, std::string *logbuf = NULL);
 
 };
 
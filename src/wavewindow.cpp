@@ -583,7 +583,7 @@ void WavePanel::OnDraw(wxDC &dc)
 			dc.DrawText(wxString::Format(wxT("%d"), measure_msec * 10), x, m_ybase);
 		} else {
 			// mill second
-			dc.DrawText(UTILS::get_time_str(measure_msec * 1000), x, m_ybase);
+			dc.DrawText(wxString::FromUTF8(UTILS::get_time_str(measure_msec * 1000).c_str()), x, m_ybase);
 		}
 		measure_msec += measure_mspitch;
 		dx += measure_xpitch;
@@ -683,8 +683,7 @@ void SampleDrawer::Draw(wxDC &dc, int a_start_pos, int a_exp)
 	wxCoord view_right = m_right + a_exp * m_xmag;
 	for(wxCoord x = view_left; x < view_right;) {
 		if (a_data_pos >= 0 && a_data_pos < m_a_data->GetWritePos()) {
-			const CSampleData *d = &m_a_data->At(a_data_pos);
-			int a_data_spos = d->SPos();
+			int a_data_spos = m_a_data->AtSPos(a_data_pos);
 			if (a_data_spos >= 0) {
 				DrawOneX(dc, a_data_spos, x);
 			}
@@ -791,8 +790,7 @@ void FirstSampleDrawer::Draw(wxDC &dc, int a_start_pos, int a_exp)
 	for(wxCoord x = view_left; x < view_right;) {
 		int prev_pos = m_data_pos;
 		if (m_data_pos >= 0 && m_data_pos < m_data->GetWritePos()) {
-			const CSampleData *d = &m_data->At(m_data_pos);
-			int a_data_spos = d->SPos();
+			int a_data_spos = m_data->AtSPos(m_data_pos);
 			if (a_data_spos >= 0) {
 				DrawOneX(dc, a_data_spos, x);
 			} else {
@@ -7,6 +7,8 @@
 #include "parsewav.h"
 #include "wavtool.h"
 #include "configbox.h"
+#include "rftypebox.h"
+#include "maddressbox.h"
 #include <wx/filename.h>
 #include "wavewindow.h"
 #include "mymenu.h"
@@ -80,6 +82,95 @@ const wxString &WavtoolApp::GetResPath()
 	return res_path;
 }
 
+//
+// Frontend
+//
+WavtoolFrontend::WavtoolFrontend(wxWindow *parent_)
+	: PARSEWAV::Frontend()
+	, parent(parent_)
+	, progbox(parent_)
+{
+}
+
+void WavtoolFrontend::InitProgress(int type, int min_val, int max_val)
+{
+	progbox.initProgress(type, min_val, max_val);
+}
+bool WavtoolFrontend::NeedSetProgress() const
+{
+	return progbox.needSetProgress();
+}
+bool WavtoolFrontend::SetProgress(int val)
+{
+	return progbox.setProgress(val);
+}
+bool WavtoolFrontend::SetProgress(int num, int div)
+{
+	return progbox.setProgress(num, div);
+}
+bool WavtoolFrontend::IncProgress()
+{
+	return progbox.incProgress();
+}
+bool WavtoolFrontend::ViewProgress()
+{
+	return progbox.viewProgress();
+}
+void WavtoolFrontend::EndProgress()
+{
+	progbox.endProgress();
+}
+
+/// 実ファイル種類ダイアログを表示
+bool WavtoolFrontend::SelectRfType(PARSEWAV::RfTypeParam &param, const std::string &name, bool init_data)
+{
+	if (init_data) {
+		param.Initialize();
+	}
+	RfTypeBox rftypebox(parent, param);
+	int rc;
+	if (!name.empty()) {
+		rc = rftypebox.showRftypeBox(name, init_data);
+	} else {
+		rc = rftypebox.showRftypeBox(init_data);
+	}
+	return (rc == 1);
+}
+
+/// マシン語情報ダイアログを表示
+bool WavtoolFrontend::InputMAddress(PARSEWAV::MAddressParam &param, bool hide_no_header_info)
+{
+	MAddressBox maddressbox(parent, param);
+	return (maddressbox.showMAddressBox(hide_no_header_info) == 1);
+}
+
+/// エラーメッセージBOX
+void WavtoolFrontend::ShowMessage(const PwErrInfo &info)
+{
+	wxString msg;
+	if (info.GetCode() == pwErrNone) {
+		msg = wxEmptyString;
+	} else {
+		msg = wxString::Format(wxGetTranslation(wxString::FromUTF8(PwErrInfo::ErrFormat(info.GetCode()))), (int)info.GetCode());
+	}
+	if (!info.GetDetail().empty()) {
+		msg += _T(" (") + wxString::FromUTF8(info.GetDetail().c_str()) + _T(")");
+	}
+	if (info.GetCode2() != pwErrNone) {
+		msg += _T("\n") + wxString::Format(wxGetTranslation(wxString::FromUTF8(PwErrInfo::ErrFormat(info.GetCode2()))), (int)info.GetCode2());
+	}
+	switch(info.GetType()) {
+		case pwError:
+			wxMessageBox(msg, _("Error"), wxOK | wxICON_ERROR, parent);
+			break;
+		case pwWarning:
+			wxMessageBox(msg, _("Warning"), wxOK | wxICON_WARNING, parent);
+			break;
+		default:
+			break;
+	}
+}
+
 //
 // Frame
 //
@@ -212,7 +303,8 @@ WavtoolFrame::WavtoolFrame(const wxString& title, const wxSize& size)
 	SetMenuBar( menuBar );
 
 	// initialize
-	wav = new ParseWav(this);
+	frontend = new WavtoolFrontend(this);
+	wav = new ParseWav(frontend);
 	wav->SetLogBufferPtr(&text_buffer);
 
 //	cfgbox = new ConfigBox(this, IDD_CONFIGBOX);
@@ -222,11 +314,15 @@ WavtoolFrame::WavtoolFrame(const wxString& title, const wxSize& size)
 	wav->GetParam().SetSampleBitsPos(gConfig.GetSampleBitsPos());
 	wav->GetParam().SetBaud(gConfig.GetBaud());
 	wav->GetParam().SetAutoBaud(gConfig.GetAutoBaud());
+	wav->GetParam().SetDemodType(gConfig.GetDemodType());
+	wav->GetParam().SetDecimateRatePos(gConfig.GetDecimateRatePos());
 	wav->GetParam().SetCorrectType(gConfig.GetCorrectType());
 	wav->GetParam().SetCorrectAmp(0, gConfig.GetCorrectAmp(0));
 	wav->GetParam().SetCorrectAmp(1, gConfig.GetCorrectAmp(1));
+	wav->GetParam().SetCorrectCalc(gConfig.GetCorrectCalc());
 	wav->GetParam().SetChangeGapSize(gConfig.GetChangeGapSize() ? 1 : 0);
 	wav->GetParam().SetOutErrSerial(gConfig.GetOutErrSerial());
+	wav->GetParam().SetDecodeThreads(gConfig.GetDecodeThreads());
 
 	// control panel
 	panel = new WavtoolPanel(this);
@@ -247,14 +343,19 @@ WavtoolFrame::~WavtoolFrame()
 	gConfig.SetSampleBitsPos(wav->GetParam().GetSampleBitsPos());
 	gConfig.SetBaud(wav->GetParam().GetBaud());
 	gConfig.SetAutoBaud(wav->GetParam().GetAutoBaud());
+	gConfig.SetDemodType(wav->GetParam().GetDemodType());
+	gConfig.SetDecimateRatePos(wav->GetParam().GetDecimateRatePos());
 	gConfig.SetCorrectType(wav->GetParam().GetCorrectType());
 	gConfig.SetCorrectAmp(0, wav->GetParam().GetCorrectAmp(0));
 	gConfig.SetCorrectAmp(1, wav->GetParam().GetCorrectAmp(1));
+	gConfig.SetCorrectCalc(wav->GetParam().GetCorrectCalc());
 	gConfig.SetChangeGapSize(wav->GetParam().GetChangeGapSize() != 0);
 	gConfig.SetOutErrSerial(wav->GetParam().GetOutErrSerial());
+	gConfig.SetDecodeThreads(wav->GetParam().GetDecodeThreads());
 
 //	delete cfgbox;
 	delete wav;
+	delete frontend;
 }
 
 /// メニュー更新
@@ -489,7 +590,7 @@ void WavtoolFrame::OnAnalyzeWave(wxCommandEvent& event)
 	wav->AnalyzeWave();
 
 	// disp infomation on the window
-	panel->GetTextInfo()->SetValue(text_buffer);
+	panel->GetTextInfo()->SetValue(wxString::FromUTF8(text_buffer.c_str()));
 
 	UpdateMenu(menuSets);
 	panel->UpdateBaudAndCorr();
@@ -509,7 +610,7 @@ void WavtoolFrame::OnAnalyzeFiles(wxCommandEvent& event)
 	wav->ExportData(FILETYPE_NO_FILE);
 
 	// disp infomation on the window
-	panel->GetTextInfo()->SetValue(text_buffer);
+	panel->GetTextInfo()->SetValue(wxString::FromUTF8(text_buffer.c_str()));
 
 	panel->UpdateExportButton();
 	ResumeWaveFrame();
@@ -647,7 +748,7 @@ void WavtoolFrame::OpenDataFile(wxString &path)
 	gConfig.AddRecentFile(path);
 	UpdateMenuRecentFiles();
 
-	rc = wav->OpenDataFile(path);
+	rc = wav->OpenDataFile((const char *)path.utf8_str());
 	if (!rc) {
 		// cancel button or error
 		return;
@@ -690,13 +791,15 @@ void WavtoolFrame::CloseDataFile()
 void WavtoolFrame::ExportFile(int id)
 {
 	int rc;
+	std::string file_base_str;
 	wxString file_base;
 	wxString wild_card;
 	bool enable = true;
 
 	if (!wav->IsOpenedDataFile()) return;
 
-	wav->GetFileNameBase(file_base);
+	wav->GetFileNameBase(file_base_str);
+	file_base = wxString::FromUTF8(file_base_str.c_str());
 	enum_file_type infile_type = wav->GetDataFileType();
 	enum_file_type outfile_type = FILETYPE_UNKNOWN;
 
@@ -765,7 +868,7 @@ void WavtoolFrame::ExportFile(int id)
 		gConfig.AddRecentFile(path);
 		UpdateMenuRecentFiles();
 
-		bool rt = wav->OpenOutFile(path, outfile_type);
+		bool rt = wav->OpenOutFile((const char *)path.utf8_str(), outfile_type);
 		if (!rt) {
 			// cancel button or error
 			return;
@@ -786,7 +889,7 @@ void WavtoolFrame::ExportFile(int id)
 		}
 
 		// disp infomation on the window
-		panel->GetTextInfo()->SetValue(text_buffer);
+		panel->GetTextInfo()->SetValue(wxString::FromUTF8(text_buffer.c_str()));
 	}
 }
 
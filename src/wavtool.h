@@ -13,6 +13,7 @@
 #include <wx/spinctrl.h>
 #include "config.h"
 #include "parsewav.h"
+#include "progressbox.h"
 
 
 class WavtoolApp;
@@ -47,6 +48,29 @@ public:
 
 DECLARE_APP(WavtoolApp)
 
+/// @brief 変換処理から呼ばれる表示・入力 (ダイアログ)
+class WavtoolFrontend : public PARSEWAV::Frontend
+{
+private:
+	wxWindow *parent;
+	ProgressBox progbox;
+
+public:
+	WavtoolFrontend(wxWindow *parent_);
+
+	void InitProgress(int type, int min_val, int max_val);
+	bool NeedSetProgress() const;
+	bool SetProgress(int val);
+	bool SetProgress(int num, int div);
+	bool IncProgress();
+	bool ViewProgress();
+	void EndProgress();
+
+	bool SelectRfType(PARSEWAV::RfTypeParam &param, const std::string &name, bool init_data);
+	bool InputMAddress(PARSEWAV::MAddressParam &param, bool hide_no_header_info);
+	void ShowMessage(const PwErrInfo &info);
+};
+
 /// @brief Frame
 class WavtoolFrame: public wxFrame
 {
@@ -60,11 +84,12 @@ private:
 	WavtoolPanel *panel;
 
 	PARSEWAV::ParseWav *wav;
+	WavtoolFrontend *frontend;
 
 //	ConfigBox *cfgbox;
 //	WaveFrame *wavewin;
 
-	wxString text_buffer;
+	std::string text_buffer;
 
 public:
 
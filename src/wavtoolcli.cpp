@@ -0,0 +1,492 @@
+﻿/// @file wavtoolcli.cpp
+///
+/// @brief コマンドライン版メイン
+///
+/// ウィンドウを表示せずに、オプションで指定した内容でファイルを変換する。
+///
+/// @author Copyright (c) Sasaji. All rights reserved.
+///
+#include "parsewav.h"
+#include "utils.h"
+#include "version.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#define isatty _isatty
+#define fileno _fileno
+#else
+#include <unistd.h>
+#endif
+
+using namespace PARSEWAV;
+
+#define CLI_NAME	"wavtool-cli"
+
+/// 終了コード
+#define CLI_EXIT_OK			0	///< 正常終了
+#define CLI_EXIT_USAGE		1	///< オプションの誤り
+#define CLI_EXIT_INPUT		2	///< 入力ファイルを開けない
+#define CLI_EXIT_OUTPUT		3	///< 出力ファイルを開けない
+#define CLI_EXIT_FAILED		4	///< 変換に失敗
+
+/// @brief 進捗とメッセージを標準エラー出力に表示する
+///
+/// 進捗は標準エラー出力が端末の場合に割合が変わったときだけ表示する
+class CliFrontend : public Frontend
+{
+private:
+	bool active;		///< 表示中
+	bool console;		///< 端末に表示できる
+	int  last_value;	///< 最後に表示した割合(%)
+	long max_value;
+	const char *title;
+	std::chrono::steady_clock::time_point lap;	///< 最後に表示した時刻
+
+public:
+	CliFrontend();
+	~CliFrontend();
+
+	void InitProgress(int type, int min_val, int max_val);
+	bool NeedSetProgress() const;
+	bool SetProgress(int val);
+	bool SetProgress(int num, int div);
+	bool IncProgress();
+	void EndProgress();
+
+	bool SelectRfType(RfTypeParam &param, const std::string &name, bool init_data);
+	void ShowMessage(const PwErrInfo &info);
+};
+
+CliFrontend::CliFrontend()
+	: Frontend()
+{
+	active = false;
+	console = (isatty(fileno(stderr)) != 0);
+	last_value = -1;
+	max_value = 0;
+	title = "";
+}
+
+CliFrontend::~CliFrontend()
+{
+	EndProgress();
+}
+
+void CliFrontend::InitProgress(int type, int min_val, int max_val)
+{
+	if (!active) {
+		max_value = (max_val - min_val);
+		title = (type == 1 ? "Analyzing..." : "Converting...");
+		active = true;
+		last_value = -1;
+		SetProgress(0);
+	}
+}
+
+bool CliFrontend::NeedSetProgress() const
+{
+	return (std::chrono::steady_clock::now() - lap >= std::chrono::milliseconds(500));
+}
+
+bool CliFrontend::SetProgress(int val)
+{
+	if (active) {
+		if (val > max_value) val = (int)max_value;
+		if (val < 0) val = 0;
+		// 割合が変わったときだけ表示
+		int per = (max_value > 0 ? (int)((double)val * 100.0 / max_value) : 0);
+		if (console && per != last_value) {
+			fprintf(stderr, "\r%s %3d%%", title, per);
+			fflush(stderr);
+		}
+		last_value = per;
+
+		lap = std::chrono::steady_clock::now();
+	}
+	return false;
+}
+
+bool CliFrontend::SetProgress(int num, int div)
+{
+	if (active && div > 0) {
+		return SetProgress((int)((double)num * max_value / div));
+	}
+	return false;
+}
+
+bool CliFrontend::IncProgress()
+{
+	if (active) {
+		lap = std::chrono::steady_clock::now();
+	}
+	return false;
+}
+
+void CliFrontend::EndProgress()
+{
+	if (active) {
+		if (console && last_value >= 0) {
+			fprintf(stderr, "\n");
+		}
+		active = false;
+	}
+}
+
+/// 種類はオプションで指定したものをそのまま使う
+bool CliFrontend::SelectRfType(RfTypeParam &param, const std::string &name, bool init_data)
+{
+	if (!Frontend::SelectRfType(param, name, init_data)) {
+		fprintf(stderr, "Internal file name accepts only alphabets and digits.\n");
+		return false;
+	}
+	return true;
+}
+
+void CliFrontend::ShowMessage(const PwErrInfo &info)
+{
+	EndProgress();
+	switch(info.GetType()) {
+		case pwError:
+			fprintf(stderr, "Error: %s\n", info.GetMsg().c_str());
+			break;
+		case pwWarning:
+			fprintf(stderr, "Warning: %s\n", info.GetMsg().c_str());
+			break;
+		default:
+			break;
+	}
+}
+
+/// 使い方を表示
+static void usage(FILE *fp)
+{
+	fprintf(fp, "%s %s (%s)\n", CLI_NAME, APPLICATION_VERSION, PLATFORM);
+	fprintf(fp, "Usage: %s [options] <input file> [output file]\n", CLI_NAME);
+	fprintf(fp, "  If output file is omitted, only analyze the input file.\n");
+	fprintf(fp, "Options:\n");
+	fprintf(fp, "  -t, --type <type>     output type: l3 l3b l3c t9x wav real plain\n");
+	fprintf(fp, "                        (default: decided by the extension)\n");
+	fprintf(fp, "  -a, --analyze         analyze wave and decide parameters before converting\n");
+	fprintf(fp, "  -b, --baud <baud>     600 1200 2400 300 (default: auto)\n");
+	fprintf(fp, "  -f, --fsk-double      double speed FSK\n");
+	fprintf(fp, "  -r, --reverse         reverse wave\n");
+	fprintf(fp, "      --full-wave       parse full wave\n");
+	fprintf(fp, "      --correct <type>  wave correct: none cos sin\n");
+	fprintf(fp, "      --correct-calc <calc>\n");
+	fprintf(fp, "                        calculation of wave correct: fft fir (default: fft)\n");
+	fprintf(fp, "      --demod <type>    demodulation: zero corr\n");
+	fprintf(fp, "      --rate <rate>     sample rate of wav output: 11025 22050 44100 48000\n");
+	fprintf(fp, "      --bits <bits>     sample bits of wav output: 8 16\n");
+	fprintf(fp, "      --split           split real file per program\n");
+	fprintf(fp, "      --rf-type <type>  type of real input file: plain basic data machine\n");
+	fprintf(fp, "      --rf-ascii        real input file is ascii format\n");
+	fprintf(fp, "      --rf-name <name>  internal file name (default: input file name)\n");
+	fprintf(fp, "      --start <hex>     start address of machine code\n");
+	fprintf(fp, "      --exec <hex>      execute address of machine code\n");
+	fprintf(fp, "      --threads <num>   threads to decode long tape in segments\n");
+	fprintf(fp, "                        (default: 0 = auto, 1 = no segments)\n");
+	fprintf(fp, "      --debug <level>   output debug log (0-3)\n");
+	fprintf(fp, "  -q, --quiet           do not print report\n");
+	fprintf(fp, "  -h, --help            show this message\n");
+	fprintf(fp, "Exit status:\n");
+	fprintf(fp, "  0:OK 1:bad option 2:cannot open input 3:cannot open output 4:conversion failed\n");
+}
+
+/// レポートを標準出力に表示
+static void print_report(const std::string &log)
+{
+	std::string str;
+	for(size_t i=0; i<log.length(); i++) {
+		if (log[i] == '\r' && i + 1 < log.length() && log[i + 1] == '\n') continue;
+		str += log[i];
+	}
+	printf("%s\n", str.c_str());
+}
+
+/// 引数の文字列をUTF-8にする
+static std::string arg_to_utf8(const char *str)
+{
+#ifdef _WIN32
+	// コマンドラインはANSIコードページ
+	int wlen = MultiByteToWideChar(CP_ACP, 0, str, -1, NULL, 0);
+	if (wlen <= 0) return std::string(str);
+	std::wstring wstr(wlen, L'\0');
+	MultiByteToWideChar(CP_ACP, 0, str, -1, &wstr[0], wlen);
+	int len = WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), -1, NULL, 0, NULL, NULL);
+	if (len <= 0) return std::string(str);
+	std::string dst(len, '\0');
+	WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), -1, &dst[0], len, NULL, NULL);
+	dst.resize(len - 1);
+	return dst;
+#else
+	return std::string(str);
+#endif
+}
+
+/// オプションの値を取り出す
+static const char *next_arg(int argc, char **argv, int &i)
+{
+	if (i + 1 >= argc) {
+		fprintf(stderr, "%s: option '%s' requires a value.\n", CLI_NAME, argv[i]);
+		return NULL;
+	}
+	i++;
+	return argv[i];
+}
+
+/// 16進数4桁のアドレスを取り出す
+static bool parse_addr(const char *str, long &addr)
+{
+	char *end = NULL;
+	size_t len = strlen(str);
+	if (len <= 0 || len > 4) return false;
+	addr = strtol(str, &end, 16);
+	return (end != NULL && *end == '\0');
+}
+
+/// 出力ファイルの種類
+static bool parse_type(const char *str, enum_file_type &type)
+{
+	static const struct {
+		const char *name;
+		enum_file_type type;
+	} types[] = {
+		{ "wav", FILETYPE_WAV },
+		{ "l3c", FILETYPE_L3C },
+		{ "l3b", FILETYPE_L3B },
+		{ "t9x", FILETYPE_T9X },
+		{ "l3", FILETYPE_L3 },
+		{ "real", FILETYPE_REAL },
+		{ "plain", FILETYPE_PLAIN },
+		{ NULL, FILETYPE_UNKNOWN }
+	};
+	for(int i=0; types[i].name != NULL; i++) {
+		if (strcmp(str, types[i].name) == 0) {
+			type = types[i].type;
+			return true;
+		}
+	}
+	return false;
+}
+
+/// 文字列が候補の何番目か
+static int find_word(const char *str, const char *const *words)
+{
+	for(int i=0; words[i] != NULL; i++) {
+		if (strcmp(str, words[i]) == 0) return i;
+	}
+	return -1;
+}
+
+int main(int argc, char **argv)
+{
+	static const char *const bauds[] = { "600", "1200", "2400", "300", NULL };
+	static const char *const corrects[] = { "none", "cos", "sin", NULL };
+	static const char *const correct_calcs[] = { "fft", "fir", NULL };
+	static const char *const demods[] = { "zero", "corr", NULL };
+	static const char *const rates[] = { "11025", "22050", "44100", "48000", NULL };
+	static const char *const bits[] = { "8", "16", NULL };
+	static const char *const rftypes[] = { "plain", "basic", "data", "machine", NULL };
+
+	CliFrontend frontend;
+	ParseWav wav(&frontend);
+	Parameter &param = wav.GetParam();
+	RfTypeParam &rfparam = wav.GetRfTypeParam();
+	MAddressParam &maparam = wav.GetMAddressParam();
+
+	const char *in_file = NULL;
+	const char *out_file = NULL;
+	enum_file_type out_type = FILETYPE_UNKNOWN;
+	bool analyze = false;
+	bool quiet = false;
+	bool rf_ascii = false;
+	bool has_start = false;
+	bool has_exec = false;
+	long addr;
+	int n;
+
+	for(int i=1; i<argc; i++) {
+		const char *opt = argv[i];
+		const char *val = NULL;
+
+		if (opt[0] != '-' || opt[1] == '\0') {
+			// ファイル名
+			if (in_file == NULL) {
+				in_file = opt;
+			} else if (out_file == NULL) {
+				out_file = opt;
+			} else {
+				fprintf(stderr, "%s: too many files.\n", CLI_NAME);
+				return CLI_EXIT_USAGE;
+			}
+			continue;
+		}
+
+		if (strcmp(opt, "-h") == 0 || strcmp(opt, "--help") == 0) {
+			usage(stdout);
+			return CLI_EXIT_OK;
+		} else if (strcmp(opt, "-q") == 0 || strcmp(opt, "--quiet") == 0) {
+			quiet = true;
+		} else if (strcmp(opt, "-a") == 0 || strcmp(opt, "--analyze") == 0) {
+			analyze = true;
+		} else if (strcmp(opt, "-t") == 0 || strcmp(opt, "--type") == 0) {
+			if ((val = next_arg(argc, argv, i)) == NULL) return CLI_EXIT_USAGE;
+			if (!parse_type(val, out_type)) goto BAD_VALUE;
+		} else if (strcmp(opt, "-b") == 0 || strcmp(opt, "--baud") == 0) {
+			if ((val = next_arg(argc, argv, i)) == NULL) return CLI_EXIT_USAGE;
+			if ((n = find_word(val, bauds)) < 0) goto BAD_VALUE;
+			param.SetBaud(n);
+			param.SetAutoBaud(false);
+		} else if (strcmp(opt, "-f") == 0 || strcmp(opt, "--fsk-double") == 0) {
+			param.SetFskSpeed(1);
+		} else if (strcmp(opt, "-r") == 0 || strcmp(opt, "--reverse") == 0) {
+			param.SetReverseWave(true);
+		} else if (strcmp(opt, "--full-wave") == 0) {
+			param.SetHalfWave(false);
+		} else if (strcmp(opt, "--correct") == 0) {
+			if ((val = next_arg(argc, argv, i)) == NULL) return CLI_EXIT_USAGE;
+			if ((n = find_word(val, corrects)) < 0) goto BAD_VALUE;
+			param.SetCorrectType(n);
+		} else if (strcmp(opt, "--correct-calc") == 0) {
+			if ((val = next_arg(argc, argv, i)) == NULL) return CLI_EXIT_USAGE;
+			if ((n = find_word(val, correct_calcs)) < 0) goto BAD_VALUE;
+			param.SetCorrectCalc(n);
+		} else if (strcmp(opt, "--demod") == 0) {
+			if ((val = next_arg(argc, argv, i)) == NULL) return CLI_EXIT_USAGE;
+			if ((n = find_word(val, demods)) < 0) goto BAD_VALUE;
+			param.SetDemodType(n);
+		} else if (strcmp(opt, "--rate") == 0) {
+			if ((val = next_arg(argc, argv, i)) == NULL) return CLI_EXIT_USAGE;
+			if ((n = find_word(val, rates)) < 0) goto BAD_VALUE;
+			param.SetSampleRatePos(n);
+		} else if (strcmp(opt, "--bits") == 0) {
+			if ((val = next_arg(argc, argv, i)) == NULL) return CLI_EXIT_USAGE;
+			if ((n = find_word(val, bits)) < 0) goto BAD_VALUE;
+			param.SetSampleBitsPos(n);
+		} else if (strcmp(opt, "--split") == 0) {
+			param.SetFileSplit(1);
+		} else if (strcmp(opt, "--rf-type") == 0) {
+			if ((val = next_arg(argc, argv, i)) == NULL) return CLI_EXIT_USAGE;
+			if ((n = find_word(val, rftypes)) < 0) goto BAD_VALUE;
+			rfparam.SetRfDataFileType(n > 0 ? 1 : 0);
+			rfparam.SetRfDataFormat((uint8_t)(n > 0 ? n - 1 : 0));
+		} else if (strcmp(opt, "--rf-ascii") == 0) {
+			rf_ascii = true;
+		} else if (strcmp(opt, "--rf-name") == 0) {
+			if ((val = next_arg(argc, argv, i)) == NULL) return CLI_EXIT_USAGE;
+			rfparam.SetRfName(arg_to_utf8(val));
+		} else if (strcmp(opt, "--start") == 0) {
+			if ((val = next_arg(argc, argv, i)) == NULL) return CLI_EXIT_USAGE;
+			if (!parse_addr(val, addr)) goto BAD_VALUE;
+			maparam.SetStartAddr(addr);
+			has_start = true;
+		} else if (strcmp(opt, "--exec") == 0) {
+			if ((val = next_arg(argc, argv, i)) == NULL) return CLI_EXIT_USAGE;
+			if (!parse_addr(val, addr)) goto BAD_VALUE;
+			maparam.SetExecAddr(addr);
+			has_exec = true;
+		} else if (strcmp(opt, "--threads") == 0) {
+			if ((val = next_arg(argc, argv, i)) == NULL) return CLI_EXIT_USAGE;
+			n = atoi(val);
+			if (n < 0 || n > 256) goto BAD_VALUE;
+			param.SetDecodeThreads(n);
+		} else if (strcmp(opt, "--debug") == 0) {
+			if ((val = next_arg(argc, argv, i)) == NULL) return CLI_EXIT_USAGE;
+			n = atoi(val);
+			if (n < 0 || n > 3) goto BAD_VALUE;
+			param.SetDebugMode(n);
+		} else {
+			fprintf(stderr, "%s: unknown option '%s'.\n", CLI_NAME, opt);
+			usage(stderr);
+			return CLI_EXIT_USAGE;
+		}
+		continue;
+
+BAD_VALUE:
+		fprintf(stderr, "%s: invalid value '%s' for option '%s'.\n", CLI_NAME, val, opt);
+		return CLI_EXIT_USAGE;
+	}
+
+	if (in_file == NULL) {
+		usage(stderr);
+		return CLI_EXIT_USAGE;
+	}
+
+	// 実ファイルのデータ形式
+	// データはアスキー、マシン語はバイナリのみ
+	switch(rfparam.GetRfDataFormat()) {
+	case 1:
+		rf_ascii = true;
+		break;
+	case 2:
+		rf_ascii = false;
+		break;
+	}
+	rfparam.SetRfDataType(rf_ascii ? 0xff : 0);
+
+	// マシン語のアドレス指定はダイアログのOKと同じ扱い
+	if (has_start || has_exec) {
+		if (!has_start || !has_exec) {
+			fprintf(stderr, "%s: specify both --start and --exec.\n", CLI_NAME);
+			return CLI_EXIT_USAGE;
+		}
+		maparam.Submitted(true);
+	}
+
+	std::string log;
+	wav.SetLogBufferPtr(&log);
+
+	if (!wav.OpenDataFile(arg_to_utf8(in_file))) {
+		return CLI_EXIT_INPUT;
+	}
+
+	enum_file_type in_type = wav.GetDataFileType();
+
+	// ヘッダのないマシン語ファイルはアドレスの指定が必要
+	if (in_type == FILETYPE_REAL && rfparam.GetRfDataFormat() == 2
+		&& !maparam.Valid() && !maparam.Submitted()) {
+		fprintf(stderr, "%s: machine code file without header needs --start and --exec.\n", CLI_NAME);
+		return CLI_EXIT_USAGE;
+	}
+
+	if (analyze) {
+		if (in_type != FILETYPE_WAV) {
+			fprintf(stderr, "%s: --analyze is available only for wav file.\n", CLI_NAME);
+			return CLI_EXIT_USAGE;
+		}
+		wav.AnalyzeWave();
+		if (!quiet) print_report(log);
+	}
+
+	bool rc;
+	if (out_file == NULL) {
+		// 解析のみ
+		if (analyze) return CLI_EXIT_OK;
+		rc = wav.ExportData(FILETYPE_NO_FILE);
+	} else {
+		if (out_type == FILETYPE_UNKNOWN) {
+			if (UTILS::check_extension(out_file, ".WAV")) out_type = FILETYPE_WAV;
+			else if (UTILS::check_extension(out_file, ".L3C")) out_type = FILETYPE_L3C;
+			else if (UTILS::check_extension(out_file, ".L3B")) out_type = FILETYPE_L3B;
+			else if (UTILS::check_extension(out_file, ".T9X")) out_type = FILETYPE_T9X;
+			else if (UTILS::check_extension(out_file, ".L3")) out_type = FILETYPE_L3;
+			else out_type = FILETYPE_REAL;
+		}
+		// 同じ形式には変換しない (GUI版と同じ)
+		if (out_type == in_type && out_type != FILETYPE_WAV && out_type != FILETYPE_PLAIN) {
+			fprintf(stderr, "%s: input and output are the same type.\n", CLI_NAME);
+			return CLI_EXIT_USAGE;
+		}
+		if (!wav.OpenOutFile(arg_to_utf8(out_file), out_type)) {
+			return CLI_EXIT_OUTPUT;
+		}
+		rc = wav.ExportData();
+		wav.CloseOutFile();
+	}
+	if (!quiet) print_report(log);
+
+	return (rc ? CLI_EXIT_OK : CLI_EXIT_FAILED);
+}
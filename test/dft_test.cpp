@@ -0,0 +1,103 @@
+﻿/// @file dft_test.cpp
+///
+/// @brief 波形補正の計算方法のテスト
+///
+/// 1200Hzと2400Hzが混ざった波形を補正したとき、
+/// FIR(SIMD)で計算した結果がFFT(重畳保存法)で計算した結果と
+/// ±1の範囲で一致するかを調べる。
+///
+/// @author Copyright (c) Sasaji. All rights reserved.
+///
+#include "paw_dft.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+using namespace PARSEWAV;
+
+#define TEST_DATA_LEN	30000	///< 波形のサンプル数
+#define TEST_AMPLITUDE	90		///< 波形の振幅
+
+/// 1200Hzと2400Hzをランダムにつないだ波形を作る
+static void make_wave(int rate, std::vector<uint8_t> &data)
+{
+	double phase = 0.0;
+	double freq = 1200.0;
+	int next = 0;
+
+	data.resize(TEST_DATA_LEN);
+	srand(rate);
+	for(int n = 0; n < TEST_DATA_LEN; n++) {
+		if (n >= next) {
+			// 1ビット分で周波数を切り替える
+			freq = ((rand() & 1) ? 2400.0 : 1200.0);
+			next = n + rate / 1200;
+		}
+		phase += 2.0 * M_PI * freq / rate;
+		int val = (int)(sin(phase) * TEST_AMPLITUDE) + 128 + (rand() % 9) - 4;
+		data[n] = (uint8_t)val;
+	}
+}
+
+/// 波形を補正する
+static void correct_wave(const std::vector<uint8_t> &data, int rate, int type, int amp0, int amp1, int method, std::vector<int> &result)
+{
+	WaveData w_data(TEST_DATA_LEN);
+	WaveData wc_data(TEST_DATA_LEN);
+	Dft dft;
+
+	w_data.AddSamples(&data[0], (int)data.size(), 0);
+	dft.Init((double)rate / 1200.0, type, amp0, amp1, method);
+	dft.Calcrate(&w_data, &wc_data);
+
+	result.clear();
+	for(int p = 0; p < wc_data.GetWritePos(); p++) {
+		result.push_back((int)wc_data.AtData(p));
+	}
+}
+
+int main(int, char **)
+{
+	static const int rates[] = { 11025, 22050, 44100, 48000, 0 };
+	static const int amps[][2] = { { 1000, 1000 }, { 1500, 800 }, { 0, 0 } };
+	int errors = 0;
+	int cases = 0;
+
+	for(int r = 0; rates[r] != 0; r++) {
+		std::vector<uint8_t> data;
+		make_wave(rates[r], data);
+		for(int type = 1; type <= 2; type++) {
+			for(int a = 0; amps[a][0] != 0; a++) {
+				std::vector<int> fft_res, fir_res;
+				correct_wave(data, rates[r], type, amps[a][0], amps[a][1], DFT_METHOD_FFT, fft_res);
+				correct_wave(data, rates[r], type, amps[a][0], amps[a][1], DFT_METHOD_FIR, fir_res);
+				cases++;
+				if (fft_res.empty() || fft_res.size() != fir_res.size()) {
+					fprintf(stderr, "rate %d type %d amp %d/%d: length differs: fft %d fir %d\n"
+						, rates[r], type, amps[a][0], amps[a][1], (int)fft_res.size(), (int)fir_res.size());
+					errors++;
+					continue;
+				}
+				for(size_t p = 0; p < fft_res.size(); p++) {
+					if (abs(fft_res[p] - fir_res[p]) > 1) {
+						fprintf(stderr, "rate %d type %d amp %d/%d: differs at %d: fft %d fir %d\n"
+							, rates[r], type, amps[a][0], amps[a][1], (int)p, fft_res[p], fir_res[p]);
+						errors++;
+						break;
+					}
+				}
+			}
+		}
+	}
+	if (errors > 0) {
+		fprintf(stderr, "%d of %d cases failed.\n", errors, cases);
+		return 1;
+	}
+	printf("ok: %d cases\n", cases);
+	return 0;
+}
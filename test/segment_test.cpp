@@ -0,0 +1,176 @@
+﻿/// @file segment_test.cpp
+///
+/// @brief 区間に分けたデコードのテスト
+///
+/// 無音でつないだ長いテープを区間に分けてデコードしても、
+/// 分けずにデコードした場合と同じL3が出力されるかを調べる。
+/// 途中のプログラムは最後のバイトの途中で録音が途切れたものとする。
+///
+/// @author Copyright (c) Sasaji. All rights reserved.
+///
+#include "parsewav.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <string>
+
+using namespace PARSEWAV;
+
+#define TEST_DATA_SIZE		6000	///< プログラムのサイズ
+#define TEST_SILENCE_SEC	3		///< プログラム間の無音(秒)
+#define TEST_TRUNCATE_MSEC	600		///< 途中のプログラムの末尾を削る長さ(ms)
+
+/// ファイルを読む
+static bool read_file(const std::string &name, std::vector<uint8_t> &data)
+{
+	FILE *fp = fopen(name.c_str(), "rb");
+	if (!fp) return false;
+	uint8_t buf[4096];
+	size_t len;
+	data.clear();
+	while((len = fread(buf, 1, sizeof(buf), fp)) > 0) {
+		data.insert(data.end(), buf, buf + len);
+	}
+	fclose(fp);
+	return true;
+}
+
+/// ファイルに書く
+static bool write_file(const std::string &name, const std::vector<uint8_t> &data)
+{
+	FILE *fp = fopen(name.c_str(), "wb");
+	if (!fp) return false;
+	size_t len = (data.empty() ? 0 : fwrite(&data[0], 1, data.size(), fp));
+	fclose(fp);
+	return (len == data.size());
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void set_le32(uint8_t *p, uint32_t val)
+{
+	p[0] = val & 0xff;
+	p[1] = (val >> 8) & 0xff;
+	p[2] = (val >> 16) & 0xff;
+	p[3] = (val >> 24) & 0xff;
+}
+
+/// マシン語のプログラムを8ビットのwavに変換する
+static bool make_program(const std::string &dir, std::vector<uint8_t> &wav)
+{
+	std::string bin_file = dir + "/segprog.bin";
+	std::string wav_file = dir + "/segprog.wav";
+
+	std::vector<uint8_t> bin(TEST_DATA_SIZE);
+	uint32_t seed = 1;
+	for(int i=0; i<TEST_DATA_SIZE; i++) {
+		seed = seed * 1103515245 + 12345;
+		bin[i] = (uint8_t)(seed >> 16);
+	}
+	if (!write_file(bin_file, bin)) return false;
+
+	ParseWav pw;
+	pw.GetParam().SetSampleRatePos(1);	// 22050Hz
+	pw.GetParam().SetSampleBitsPos(0);	// 8bit
+	RfTypeParam &rfparam = pw.GetRfTypeParam();
+	rfparam.SetRfDataFileType(1);
+	rfparam.SetRfDataFormat(2);
+	rfparam.SetRfDataType(0);
+	MAddressParam &maparam = pw.GetMAddressParam();
+	maparam.SetStartAddr(0x1000);
+	maparam.SetExecAddr(0x1000);
+	maparam.Submitted(true);
+
+	if (!pw.OpenDataFile(bin_file)) return false;
+	if (!pw.OpenOutFile(wav_file, FILETYPE_WAV)) return false;
+	bool rc = pw.ExportData();
+	pw.CloseOutFile();
+
+	return rc && read_file(wav_file, wav);
+}
+
+/// 途中のプログラムの末尾を削り、無音でつないだテープを作る
+static bool make_tape(const std::vector<uint8_t> &wav, std::vector<uint8_t> &tape)
+{
+	// dataチャンクをさがす
+	size_t pos = 12;
+	size_t data_pos = 0;
+	size_t data_len = 0;
+	while(pos + 8 <= wav.size()) {
+		uint32_t len = get_le32(&wav[pos + 4]);
+		if (memcmp(&wav[pos], "data", 4) == 0) {
+			data_pos = pos + 8;
+			data_len = len;
+			break;
+		}
+		pos += 8 + len;
+	}
+	if (data_pos == 0 || data_pos + data_len > wav.size() || wav.size() < 44) return false;
+
+	uint32_t rate = get_le32(&wav[24]);
+	size_t cut_len = data_len - (size_t)rate * TEST_TRUNCATE_MSEC / 1000;
+	std::vector<uint8_t> silence((size_t)rate * TEST_SILENCE_SEC, 0x80);
+
+	tape.assign(wav.begin(), wav.begin() + data_pos);
+	for(int i=0; i<3; i++) {
+		if (i < 2) {
+			tape.insert(tape.end(), wav.begin() + data_pos, wav.begin() + data_pos + cut_len);
+			tape.insert(tape.end(), silence.begin(), silence.end());
+		} else {
+			tape.insert(tape.end(), wav.begin() + data_pos, wav.begin() + data_pos + data_len);
+		}
+	}
+	set_le32(&tape[4], (uint32_t)(tape.size() - 8));
+	set_le32(&tape[data_pos - 4], (uint32_t)(tape.size() - data_pos));
+	return true;
+}
+
+/// テープをL3にデコードする
+/// @param[in] threads 区間に分けてデコードするスレッド数 1:分けない
+static bool decode_tape(const std::string &tape_file, const std::string &l3_file, int threads, std::vector<uint8_t> &l3)
+{
+	ParseWav pw;
+	pw.GetParam().SetDecodeThreads(threads);
+	if (!pw.OpenDataFile(tape_file)) return false;
+	if (!pw.OpenOutFile(l3_file, FILETYPE_L3)) return false;
+	bool rc = pw.ExportData();
+	pw.CloseOutFile();
+	return rc && read_file(l3_file, l3);
+}
+
+int main(int argc, char **argv)
+{
+	std::string dir = (argc > 1 ? argv[1] : ".");
+
+	std::vector<uint8_t> wav;
+	if (!make_program(dir, wav)) {
+		fprintf(stderr, "cannot make program wav.\n");
+		return 1;
+	}
+	std::vector<uint8_t> tape;
+	if (!make_tape(wav, tape)) {
+		fprintf(stderr, "cannot make tape.\n");
+		return 1;
+	}
+	std::string tape_file = dir + "/segtape.wav";
+	if (!write_file(tape_file, tape)) {
+		fprintf(stderr, "cannot write %s.\n", tape_file.c_str());
+		return 1;
+	}
+
+	std::vector<uint8_t> serial_l3, segment_l3;
+	if (!decode_tape(tape_file, dir + "/segtape_1.l3", 1, serial_l3)
+	 || !decode_tape(tape_file, dir + "/segtape_2.l3", 2, segment_l3)) {
+		fprintf(stderr, "cannot decode tape.\n");
+		return 1;
+	}
+	if (serial_l3.empty() || serial_l3 != segment_l3) {
+		fprintf(stderr, "output differs: serial %d bytes, segments %d bytes.\n", (int)serial_l3.size(), (int)segment_l3.size());
+		return 1;
+	}
+	printf("ok: %d bytes\n", (int)serial_l3.size());
+	return 0;
+}